@@ -14,13 +14,26 @@ import Utils;
 import VulkanExtensions;
 import ShaderCodes;
 import ShaderCompiler;
+import ShaderCache;
+import ShaderReflection;
 import FileManager;
+import FileWatcher;
+import ImageWriter;
+import FrameExporter;
+import FramePacer;
+import ResolutionScaler;
+import TileScheduler;
+import SpecConstants;
+import Playlist;
+import Benchmark;
+import FrameOutput;
 import ApplicationGlobalData;
 import ParseUtils;
 import Log;
 import Glfw;
 
 using u32 = std::uint32_t;
+using u64 = std::uint64_t;
 
 struct PhysicalDevice : public VulkanRHI::PhysicalDevice {
 	PhysicalDevice() {}
@@ -37,22 +50,89 @@ struct PhysicalDevice : public VulkanRHI::PhysicalDevice {
 };
 
 struct FragmentShaderManager {
+	static constexpr char const* kBufferSuffixes[] = {".bufferA", ".bufferB", ".bufferC", ".bufferD"};
+
 	void Update(std::string_view const fragment_shader_code) {
 		path             = fragment_shader_code;
 		path_string      = path.string();
-		file_version     = Utils::GetFileVersion(path_string);
+		file_version     = 0;
 		pipeline_version = -1;
+		for (std::size_t buffer = 0; buffer < buffer_paths.size(); ++buffer) {
+			buffer_paths[buffer] = GetBufferPath(path, buffer);
+		}
+		spec_path = path;
+		spec_path += ".spec";
+		dependencies.clear();
+	}
+
+	static auto GetBufferPath(std::filesystem::path const& shader_path, std::size_t buffer) -> std::filesystem::path {
+		std::filesystem::path buffer_path = shader_path.parent_path() / shader_path.stem();
+		buffer_path += kBufferSuffixes[buffer];
+		buffer_path += shader_path.extension();
+		return buffer_path;
+	}
+
+	// Changes are detected by the watcher thread, on_change is called from it.
+	// Missing buffer files are watched too, creating one adds the pass.
+	void StartWatching(std::function<void()> on_change, bool bForcePolling) {
+		watcher.Start({.on_change = on_change, .bForcePolling = bForcePolling});
+		watcher.SetFiles(GetWatchedFiles());
+		// Separate version, editing the control file only respecializes the pipelines
+		spec_watcher.Start({.on_change = std::move(on_change), .bForcePolling = bForcePolling});
+		spec_watcher.SetFiles(std::span{&spec_path, 1});
+	}
+
+	void StopWatching() {
+		watcher.Stop();
+		spec_watcher.Stop();
 	}
 
+	// Files the last build included or imported, only edits to them or the shader reload it
+	void SetDependencies(std::span<std::filesystem::path const> paths) {
+		dependencies.assign(paths.begin(), paths.end());
+		std::ranges::sort(dependencies);
+		dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+		if (watcher.IsRunning()) {
+			watcher.SetFiles(GetWatchedFiles());
+		}
+	}
+
+	auto GetWatchedFiles() const -> std::vector<std::filesystem::path> {
+		std::vector<std::filesystem::path> files{path};
+		files.append_range(buffer_paths);
+		files.append_range(dependencies);
+		return files;
+	}
+
+	// For writes the watcher did not see, made before it started
+	bool IsModifiedSince(std::filesystem::file_time_type time) const {
+		std::error_code error;
+		return std::ranges::any_of(GetWatchedFiles(), [&](std::filesystem::path const& file_path) {
+			return std::filesystem::exists(file_path, error) && std::filesystem::last_write_time(file_path, error) > time;
+		});
+	}
+
+	// Reload even if the file did not change
+	void ForceReload() { ++reload_count; }
+
 	bool UpdateFileVersion() {
-		int new_version = Utils::GetFileVersion(path_string);
-		if (new_version > file_version) {
+		int new_version = static_cast<int>(watcher.GetVersion()) + reload_count;
+		if (new_version != file_version) {
 			file_version = new_version;
 			return true;
 		}
 		return false;
 	}
 
+	bool UpdateSpecFileVersion() {
+		int new_version = static_cast<int>(spec_watcher.GetVersion());
+		if (new_version != spec_file_version) {
+			spec_file_version = new_version;
+			return true;
+		}
+		return false;
+	}
+
 	bool IsUpToDate(int current_file_version) const { return file_version >= current_file_version; }
 
 	auto GetPath() -> std::filesystem::path& { return path; }
@@ -72,18 +152,74 @@ struct FragmentShaderManager {
 	std::string           path_string;
 	int                   file_version     = -1;
 	int                   pipeline_version = -1;
+	int                   reload_count     = 0;
+	FileWatcher           watcher;
+
+	// Shadertoy style Buffer A-D, <name>.bufferA<ext> to <name>.bufferD<ext> next to the shader
+	std::array<std::filesystem::path, 4> buffer_paths;
+	// Of all passes, from the compiler
+	std::vector<std::filesystem::path> dependencies;
+
+	// Specialization constant values, <name><ext>.spec next to the shader
+	std::filesystem::path spec_path;
+	int                   spec_file_version = 0;
+	FileWatcher           spec_watcher;
 };
 
 constexpr float kFpsUnlimited = 0.0f;
 
 struct UserOptions {
-	bool  bVerbose : 1           = false;
-	bool  bFlipY : 1             = true;
-	bool  bUpdateOnSave : 1      = true;
-	bool  bValidationEnabled : 1 = true;
-	bool  bStartPaused : 1       = false;
-	bool  bTransparent : 1       = false;
-	float fps_limit              = -1.0f;
+	// Not bitfields, other threads read flags while the render thread toggles their neighbours
+	bool  bVerbose           = false;
+	bool  bFlipY             = true;
+	bool  bUpdateOnSave      = true;
+	bool  bValidationEnabled = true;
+	bool  bStartPaused       = false;
+	bool  bTransparent       = false;
+	bool  bInProcessCompiler = true;
+	bool  bPollFiles         = false;
+	bool  bHeadless          = false;
+	bool  bPrerecord         = false;
+	float fps_limit          = -1.0f;
+	int   pacer_slack_us     = 1500;
+
+	// Messages below are discarded, validation ones included
+	LogLevel log_level = LogLevel::Trace;
+
+	// Windowed rendering at a fraction of the window size, upscaled when presenting.
+	// With a target GPU frame time the scale is adjusted to hold it, disabled if 0.
+	float render_scale = 1.0f;
+	float target_ms    = 0.0f;
+	// Windowed single pass fragment shaders are drawn in tiles spread over frames, each frame drawing
+	// about this much GPU time of them. 0 draws whole frames.
+	float tile_budget_ms = 0.0f;
+
+	// Headless rendering
+	int              headless_width  = 800;
+	int              headless_height = 600;
+	int              frame_count     = 1;
+	float            time_step       = 1.0f / 60.0f;
+	std::string_view output_path     = "frame_%04d.png";
+	// Unset saves the last frame, or all of them to a .y4m stream
+	std::optional<std::string_view> save_frames;
+	// Frames are read back into a ring of buffers and encoded on export threads, 0 to use
+	// up to kMaxExportThreads hardware threads
+	int readback_buffers = 4;
+	int export_threads   = 0;
+
+	// Raw per-phase CPU frame times are written here on exit, empty to disable
+	std::string_view phase_csv_path = "";
+	// Chrome trace event JSON of frame phases and shader builds is written here on exit, empty to disable
+	std::string_view trace_path = "";
+
+	// Benchmark, disabled if benchmark_frames is 0
+	int              benchmark_frames = 0;
+	int              benchmark_warmup = 60;
+	std::string_view benchmark_output = "benchmark.json";
+
+	// Playlist of several shaders or a directory
+	float playlist_interval  = 0.0f; // seconds each shader is shown, 0 to switch only by key
+	int   precompile_threads = 0;    // 0 to use up to kMaxPrecompileThreads hardware threads
 
 	std::string_view compile_options = "";
 };
@@ -109,6 +245,19 @@ struct std::hash<KeyboardAction> {
 	}
 };
 
+// Parts of a windowed frame timed on the CPU, in the order they run
+enum class FramePhase {
+	eWaitFence,
+	eAcquire,
+	eRecord,
+	eSubmitPresent,
+	eFrameLimit,
+	eCount,
+};
+
+constexpr char const* kFramePhaseNames[] = {"wait_fence", "acquire", "record", "submit_present", "frame_limit"};
+static_assert(std::size(kFramePhaseNames) == std::to_underlying(FramePhase::eCount));
+
 struct MainAppImpl {
 	static constexpr u32 kApiVersion          = vk::ApiVersion13;
 	static constexpr int kDefaultWindowWidth  = 800;
@@ -118,41 +267,145 @@ struct MainAppImpl {
 	static constexpr char const* kEnabledDeviceExtensions[] = {
 		vk::KHRSwapchainExtensionName,
 	};
+	// Optional, used for pacing on presentation
+	static constexpr char const* kPresentWaitDeviceExtensions[] = {
+		vk::KHRPresentIdExtensionName,
+		vk::KHRPresentWaitExtensionName,
+	};
+	static constexpr u64 kPresentWaitTimeout = 100'000'000; // ns
+	// Optional, presents signal fences and are scaled to the window while it is resized
+	static constexpr char const* kSurfaceMaintenanceInstanceExtensions[] = {
+		vk::KHRGetSurfaceCapabilities2ExtensionName,
+		vk::EXTSurfaceMaintenance1ExtensionName,
+	};
+	static constexpr char const* kSwapchainMaintenanceDeviceExtensions[] = {
+		vk::EXTSwapchainMaintenance1ExtensionName,
+	};
 
 	~MainAppImpl();
-	void Run(int argc, char const* const* argv);
+	int  Run(int argc, char const* const* argv);
 	void Init();
+	void InitWindow();
 	void MainLoop();
 	void WaitForFrameTimeLeft();
+	void InitFramePacer();
 	void Destroy();
 	void CreateInstance();
 	void SelectPhysicalDevice();
 	void GetPhysicalDeviceInfo();
 	void CreateDevice();
+	void CreatePipelineCache();
+	void SavePipelineCache();
 	// void CreateVmaAllocator();
 
 	void CreateDescriptorSetLayout();
 	void CreateDescriptorPool();
 	void CreateDescriptorSet();
+	void CreateChannelResources();
+	void WriteFrameUniforms(u32 slot, u32 width, u32 height);
+	void WriteFrameUniforms(u32 slot, PushConstants const& constants);
+	auto GetFrameConstants(u32 width, u32 height) const -> PushConstants;
 
 	void CreateSwapchain();
+	void CreateTimestampQueryPools();
+	void CreateOffscreenTargets();
+	void DestroyOffscreenTargets();
 
 	void CreatePipelineLayout();
 	void CreateVertexShaderModule();
 	void CreateFallbackPipeline();
 	bool UpdateUserFragmentShader();
 
-	[[nodiscard]] auto CreatePipeline(std::span<std::byte const> fragment_shader_code, vk::Pipeline& pipeline) -> vk::Result;
-	[[nodiscard]] bool TryRecreateUserPipeline();
-
-	void RecordCommands();
+	[[nodiscard]] auto CreatePipeline(std::span<std::byte const> fragment_shader_code, vk::Format format, vk::Pipeline& pipeline,
+									  vk::SpecializationInfo const* specialization_info = nullptr) -> vk::Result;
+	[[nodiscard]] auto CreateComputePipeline(std::span<u32 const> compute_shader_code, vk::SpecializationInfo const& specialization_info,
+											 vk::Pipeline& pipeline) -> vk::Result;
+	auto               SelectWorkgroupSize(ComputeWorkgroup const& workgroup) const -> vk::Extent2D;
+	struct CompiledUserShader;
+	struct ShaderBuildContext;
+	struct PipelineBuildResult;
+	[[nodiscard]] auto CreateUserPipeline(CompiledUserShader const& shader, std::span<SpecConstantValue const> spec_values, vk::Pipeline& pipeline) -> vk::Result;
+	[[nodiscard]] bool TryCreateUserPipeline(ShaderBuildContext const& context, std::string const& path, vk::Format format, CompiledUserShader& shader,
+											 vk::Pipeline& new_pipeline);
+	[[nodiscard]] bool TryCreateUserPasses(ShaderBuildContext const& context, std::filesystem::path const& path, PipelineBuildResult& result,
+										   std::vector<CompiledUserShader>& compiled_shaders);
+	[[nodiscard]] bool RespecializeUserPasses(std::span<CompiledUserShader const> shaders, PipelineBuildResult& result);
+	static auto        CollectSpecConstants(std::span<CompiledUserShader const> shaders) -> std::vector<SpecConstant>;
+	auto               GetShaderBuildContext() -> ShaderBuildContext;
+	void               DestroyPipelines(PipelineBuildResult const& result);
+	void               LogShaderDiagnostics(std::span<ShaderDiagnostic const> diagnostics);
+
+	void StartPipelineBuildThread();
+	void StopPipelineBuildThread();
+	void PipelineBuildThread(std::stop_token stop_token);
+	void RequestPipelineBuild(int file_version);
+
+	void PrecompilePlaylist();
+	void ShowPlaylistEntry(std::size_t index);
+	void UpdatePlaylist();
+
+	void UpdateSpecConstants(std::span<SpecConstant const> reflected);
+	void ApplySpecControlValues();
+	void RequestPipelineSpecialization();
+	void StepSpecConstant(u32 index, int direction);
+	void ResetSpecConstants();
+	void LogSpecConstants() const;
+
+	auto RecordCommands() -> vk::CommandBuffer;
+	void RecordSwapchainImageCommands(VulkanRHI::CommandBuffer cmd, u32 frame_slot, vk::Extent2D extent, vk::Extent2D scaled_extent);
+	auto RecordTiledCommands(VulkanRHI::CommandBuffer cmd, u32 frame_slot, vk::Extent2D extent, vk::Extent2D scaled_extent)
+		-> VulkanRHI::RenderGraphImageState;
+	void CreateTiledImages(vk::Extent2D extent);
+	// Buffer passes read their own previous frame and compute shaders write the whole image, neither is tiled
+	bool IsTiled() const { return user_options.tile_budget_ms > 0.0f && !user_options.bHeadless && !IsMultipass() && !IsComputeShader(); }
+	struct DrawInfo;
+	void RecordDraw(VulkanRHI::CommandBuffer cmd, DrawInfo const& info);
+	void RecordDispatch(VulkanRHI::CommandBuffer cmd, DrawInfo const& info);
+	void BuildRenderGraph(vk::Extent2D extent, vk::Extent2D output_extent);
+	void RecordRenderGraph(VulkanRHI::CommandBuffer cmd, vk::Image image, vk::ImageView view, u32 uniform_slot,
+						   vk::Extent2D extent, vk::Extent2D output_extent);
+	bool IsMultipass() const { return !buffer_passes.empty(); }
+	bool IsComputeShader() const { return current_pipeline == &user_pipeline && image_workgroup_size.width > 0; }
+	// Size passes render at, the window size times the render scale
+	auto GetScaledExtent(u32 width, u32 height) const -> vk::Extent2D;
+	// Anything but a fragment shader drawn straight into the target at its size goes through the render graph
+	bool UsesRenderGraph(vk::Extent2D extent, vk::Extent2D scaled_extent) const {
+		return IsMultipass() || IsComputeShader() || extent != scaled_extent;
+	}
+	bool IsFlipY() const { return user_options.bFlipY || current_pipeline == &fallback_pipeline; }
+	// Buffer passes may feed back into themselves, assume they change every frame
+	bool IsShaderAnimated() const { return IsMultipass() || shader_input_usage.IsAnimated(); }
+	void CreatePrerecordedCommandPool();
+	auto GetPrerecordedCommands(u32 width, u32 height) -> vk::CommandBuffer;
 	void UpdateViewport(int width, int height);
 	void UpdateMouse(int x, int y, int height);
 	void OnDrawWindow();
 	void UpdateTime();
+	void ReportFrameStats();
+	void BeginFramePhase();
+	void EndFramePhase(FramePhase phase);
+	void SaveFramePhaseCsv() const;
+	void SaveTrace() const;
+	struct FrameTimestamps;
+	void CollectGpuFrameTime(FrameTimestamps& timestamps);
+
+	bool IsBenchmarking() const { return benchmark.IsEnabled(); }
+	void PinMouse(int width, int height);
+	void SaveBenchmarkResults();
 	void RecreateSwapchain(int width, int height);
 
+	void RunHeadless();
+	struct OffscreenTarget;
+	void               RecordOffscreenCommands(OffscreenTarget& target, bool bReadback);
+	void               RetireOffscreenTarget(OffscreenTarget& target);
+
 	auto GetAllocator() const -> vk::AllocationCallbacks const* { return allocator; }
+	auto GetRequiredDeviceExtensions() const -> std::span<char const* const> {
+		return user_options.bHeadless ? std::span<char const* const>{} : kEnabledDeviceExtensions;
+	}
+	auto GetDeviceExtensions() const -> std::span<char const* const> { return device_extensions; }
+	bool SupportsPresentWait();
+	bool SupportsSwapchainMaintenance();
 	auto GetPipelineCache() const -> vk::PipelineCache { return pipeline_cache; }
 
 	bool CallKeyCallback(KeyboardAction const& key);
@@ -164,14 +417,15 @@ struct MainAppImpl {
 	struct UserOptions user_options;
 
 	ShaderCompiler        shader_compiler;
+	ShaderCache           shader_cache;
 	FileManager           file_manager;
 	FragmentShaderManager fragment_shader;
 
 	Window       window;
+	std::string  window_title;
 	WindowState  window_state;
 	int          WindowFramesToDraw = 0;
 	vk::Viewport viewport;
-	vk::Viewport viewport_flip_y;
 	struct {
 		float x = 300.0f;
 		float y = 300.0f;
@@ -191,24 +445,89 @@ struct MainAppImpl {
 
 	bool bPaused = false;
 
+	// Inputs the current pipeline reads, the fallback reads none. Unless it is animated and not paused
+	// the loop sleeps in WaitEvents and draws again only on input, resize or a new pipeline.
+	FrameInputUsage shader_input_usage = FrameInputUsage::ResolutionOnly();
+	bool            bNeedsRedraw       = true;
+	// Of user_pipeline if it is a compute shader, zero otherwise
+	vk::Extent2D image_workgroup_size{};
+
+	// Frames are paced by waiting for presentation when the limit is the display refresh rate
+	// and present wait is available, by frame_pacer otherwise
+	FramePacer frame_pacer;
+	bool       bFpsFromRefreshRate   = false;
+	bool       bPaceOnPresent        = false;
+	u64        last_paced_present_id = 0;
+
+	// Windowed passes render at a scale of the window size, an upscale pass blits to the swapchain image
+	ResolutionScaler resolution_scaler;
+
+	// In tiled mode the tiles of each frame are drawn into tiled_images[tiled_draw_index] and the other one
+	// holds the last complete image, which is presented meanwhile. All tiles of an image are drawn with the
+	// frame values of when it was started, a new pipeline starts it over.
+	struct TiledImage {
+		VulkanRHI::Image image;
+		vk::ImageLayout  layout = vk::ImageLayout::eUndefined;
+	};
+	TileScheduler             tile_scheduler;
+	std::array<TiledImage, 2> tiled_images;
+	u32                       tiled_draw_index = 0;
+	bool                      bTiledPassActive = false;
+	bool                      bTiledComplete   = false; // tiled_images[1 - tiled_draw_index] holds a complete image
+	vk::Pipeline              tiled_pipeline{};
+	PushConstants             tiled_constants{};
+	std::vector<Tile>         frame_tiles;
+	std::vector<vk::Rect2D>   frame_scissors;
+
 	vk::Instance                    instance{};
 	vk::AllocationCallbacks const*  allocator{nullptr};
-	vk::PipelineCache               pipeline_cache{nullptr};
+	VulkanRHI::PipelineCache        pipeline_cache{};
 	vk::DebugUtilsMessengerEXT      debug_messenger{};
 	std::span<char const* const>    enabled_layers{};
 	std::vector<vk::PhysicalDevice> vulkan_physical_devices{};
 	PhysicalDevice                  physical_device{};
+	std::vector<char const*>        device_extensions{};
+	bool                            bPresentWait          = false; // VK_KHR_present_id and VK_KHR_present_wait enabled
+	bool                            bSurfaceMaintenance   = false; // instance extensions of kSurfaceMaintenanceInstanceExtensions enabled
+	bool                            bSwapchainMaintenance = false; // VK_EXT_swapchain_maintenance1 enabled
 	vk::Device                      device{};
 	VulkanRHI::Swapchain            swapchain{};
-	bool                            bSwapchainDirty = false;
+	bool                            bSwapchainDirty = false; // recreated before the next frame, resizes are coalesced
 	vk::SurfaceKHR                  surface{};
 
+	// GPU time of one frame, read back once the frame's fence has signaled
+	struct FrameTimestamps {
+		VulkanRHI::TimestampQueryPool pool;
+		int                           frame_index = -1;
+		u64                           tile_pixels = 0; // drawn by a tiled frame, 0 for a whole one
+	};
+	// Indexed like swapchain frame data
+	std::vector<FrameTimestamps> frame_timestamps;
+
 	vk::Queue queue{};
 	u32       queue_family_index = ~0u;
 
-	// vk::DescriptorSetLayout descriptor_set_layout{};
-	// vk::DescriptorPool      descriptor_pool{};
-	// vk::DescriptorSet       descriptor_set{};
+	// Per-frame values as a uniform buffer with one aligned slice per frame in flight,
+	// bound with a dynamic offset. Same layout as PushConstants.
+	vk::DescriptorSetLayout descriptor_set_layout{};
+	vk::DescriptorPool      descriptor_pool{};
+	vk::DescriptorSet       descriptor_set{};
+	VulkanRHI::Buffer       frame_uniforms;
+	vk::DeviceSize          frame_uniforms_stride = 0;
+
+	// With --prerecord command buffers are recorded once per (frame in flight, swapchain image)
+	// and recorded again only when something they reference changes. Handles of destroyed pipelines
+	// and views can be reused by new ones, so a new pipeline or swapchain bumps the generation
+	// instead of being compared.
+	struct PrerecordedCommands {
+		vk::CommandBuffer cmd;
+		u64               generation = 0;
+		vk::Extent2D      extent;
+		bool              bFlipY = false;
+	};
+	vk::CommandPool                               prerecorded_command_pool{};
+	std::vector<std::vector<PrerecordedCommands>> prerecorded_commands; // [frame_slot][image_index]
+	u64                                           prerecorded_generation = 1;
 
 	vk::PipelineLayout pipeline_layout;
 
@@ -219,17 +538,170 @@ struct MainAppImpl {
 
 	vk::ShaderModule vertex_shader_module;
 	vk::ShaderModule fragment_shader_module;
+	vk::Format       color_format = vk::Format::eUndefined;
+
+	// Buffer A-D passes that exist next to the shader, drawn in that order before the image pass.
+	// Every pass samples Buffer A-D as iChannel0-3 at set 1, bindings 0-3, earlier buffers from this
+	// frame, itself and later ones from the previous frame.
+	static constexpr u32        kBufferCount  = 4;
+	static constexpr vk::Format kBufferFormat = vk::Format::eR16G16B16A16Sfloat;
+	// Compute passes write the storage image at set 1, binding 4, in kBufferFormat
+	static constexpr u32                  kOutputBinding    = kBufferCount;
+	static constexpr vk::ShaderStageFlags kUserShaderStages = vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+	struct BufferPass {
+		vk::Pipeline    pipeline;
+		FrameInputUsage input_usage;
+		vk::Extent2D    workgroup_size; // zero for a fragment shader
+		u32             buffer = 0;     // 0-3 for Buffer A-D
+	};
+	std::vector<BufferPass> buffer_passes; // owning, empty for a single pass
+
+	// Adjusted with Alt+1-9 and the control file, changing one only respecializes the pipelines
+	SpecConstantSet      spec_constants;
+	static constexpr u32 kSpecConstantKeyCount = 9;
+
+	// SPIR-V of a built pass, kept by the thread building pipelines to create them again with
+	// other specialization constant values without compiling
+	struct CompiledUserShader {
+		std::vector<u32>          spirv;
+		vk::Format                format = vk::Format::eUndefined;
+		BufferPass                pass; // without the pipeline, buffer is unused for the image pass
+		bool                      bWorkgroupSpecialized = false;
+		std::vector<SpecConstant> spec_constants;
+	};
+
+	struct DrawInfo {
+		vk::ImageView               image_view; // unused by compute passes, they write the output binding of channel_set
+		vk::Pipeline                pipeline;
+		vk::DescriptorSet           channel_set; // null for a single pass
+		vk::Extent2D                workgroup_size;
+		bool                        bFlipY       = false;
+		u32                         uniform_slot = 0;
+		u32                         width        = 0;
+		u32                         height       = 0;
+		std::span<vk::Rect2D const> scissors;            // drawn with one draw each, the whole target if empty
+		PushConstants const*        constants = nullptr; // of the current frame if null
+	};
+
+	VulkanRHI::RenderGraph         render_graph;
+	VulkanRHI::RenderGraphImage    render_graph_output{};
+	vk::Extent2D                   render_graph_extent{};
+	vk::Extent2D                   render_graph_output_extent{};
+	bool                           bRenderGraphDirty         = true;
+	u32                            render_graph_uniform_slot = 0; // of the frame being recorded
+	vk::DescriptorSetLayout        channel_set_layout{};
+	vk::Sampler                    channel_sampler{};
+	vk::DescriptorPool             channel_descriptor_pool{};
+	std::vector<vk::DescriptorSet> channel_sets; // [pass * 2 + parity], image pass last
+
+	// User pipeline is compiled and built on pipeline_build_thread and handed over
+	// through pipeline_build_result, the render loop keeps drawing the old one meanwhile
+	struct PipelineBuildResult {
+		vk::Pipeline                   pipeline; // null if compilation or creation failed
+		FrameInputUsage                input_usage;
+		vk::Extent2D                   workgroup_size;
+		std::vector<BufferPass>        buffer_passes;
+		std::vector<SpecConstant>      spec_constants;
+		std::vector<SpecConstantValue> spec_values; // pipelines were created with
+		// Included and imported files of all passes, set by builds that compiled, failed ones too
+		std::optional<std::vector<std::filesystem::path>> dependencies;
+		std::optional<std::vector<CompiledUserShader>>    compiled_shaders; // set by builds that ran the compiler
+		int                                               file_version = -1;
+	};
+	// Shader the build thread switches to, with what its shown pipelines were built from
+	struct PipelineBuildSource {
+		std::filesystem::path           path;
+		std::vector<CompiledUserShader> compiled_shaders;
+		std::vector<SpecConstantValue>  spec_values;
+		int                             file_version = -1;
+	};
+	std::jthread                       pipeline_build_thread;
+	std::mutex                         pipeline_build_mutex;
+	std::condition_variable_any        pipeline_build_cv;
+	int                                pipeline_build_requested_version = -1; // guarded by pipeline_build_mutex
+	int                                pipeline_build_spec_version      = 0;  // guarded by pipeline_build_mutex
+	std::vector<SpecConstantValue>     pipeline_build_spec_values;            // guarded by pipeline_build_mutex
+	std::optional<PipelineBuildSource> pipeline_build_source;                 // guarded by pipeline_build_mutex
+	int                                pipeline_build_generation        = 0;  // guarded by pipeline_build_mutex, results of older ones are dropped
+	int                                pipeline_build_last_request      = -1; // render thread only
+	std::atomic<PipelineBuildResult*>  pipeline_build_result            = nullptr;
+	// Owned by pipeline_build_thread, by Init before it starts
+	std::vector<SpecConstantValue> build_spec_values;
+	// Render thread, what the shown pipelines were built from
+	std::vector<CompiledUserShader> compiled_user_shaders; // image pass last, empty if the last build failed
+	std::vector<SpecConstantValue>  user_pipeline_spec_values;
+
+	// Shaders given as a list or a directory are all built up front, switching between them only swaps
+	// pipelines. Entries not shown own theirs, the shown one lives in user_pipeline and buffer_passes.
+	static constexpr u32 kMaxPrecompileThreads = 8;
+	struct PlaylistBuild {
+		PipelineBuildResult             build;
+		std::vector<CompiledUserShader> compiled_shaders;
+		SpecConstantSet                 spec_constants;
+	};
+	using PlaylistEntry = Playlist<PlaylistBuild>::Entry;
+	Playlist<PlaylistBuild> playlist;
+
+	// Rolling frame statistics, reported every kFrameStatsInterval
+	static constexpr std::chrono::seconds kFrameStatsInterval{1};
+	Utils::SampleRing<256>                gpu_frame_times_ms;
+	std::chrono::steady_clock::time_point last_frame_stats_time = std::chrono::steady_clock::now();
+
+	static constexpr std::size_t kFramePhaseHistory = 1024;
+	using FramePhaseRing                            = Utils::SampleRing<kFramePhaseHistory>;
+	std::array<FramePhaseRing, std::to_underlying(FramePhase::eCount)> frame_phase_times_ms;
+	std::chrono::steady_clock::time_point                              frame_phase_start;
+
+	Benchmark benchmark;
+
+	// Timings of the last user shader build, written by the thread building it
+	struct ShaderBuildTimes {
+		char const* backend_name     = "none";
+		float       compile_time_ms  = 0.0f;
+		float       pipeline_time_ms = 0.0f;
+	} last_shader_build;
+
+	// What a thread builds user shaders with. Init and pipeline_build_thread use shader_compiler,
+	// playlist workers their own compiler and output file. shader_cache is shared under its mutex.
+	struct ShaderBuildContext {
+		ShaderCompiler*                    compiler;
+		std::string                        spv_path; // written by the external compiler
+		std::span<SpecConstantValue const> spec_values;
+		ShaderBuildTimes*                  build_times = nullptr; // timings of the last pass are reported to, if set
+	};
+	std::mutex shader_cache_mutex;
+
+	// Headless mode renders into offscreen images instead of the swapchain. Targets are used in
+	// turn: once the fence of one signals its readback buffer is handed to frame_exporter, and the
+	// target is only rendered into again after the frame is encoded.
+	struct OffscreenTarget {
+		VulkanRHI::Image  image;
+		VulkanRHI::Buffer readback;
+		vk::CommandPool   command_pool;
+		vk::CommandBuffer command_buffer;
+		vk::Fence         fence;
+		FrameTimestamps   timestamps;
+		int               pending_frame = -1; // frame in readback not yet handed to frame_exporter
+	};
+	static constexpr u32                               kMaxExportThreads = 4;
+	std::vector<OffscreenTarget>                       offscreen_targets;
+	vk::Extent2D                                       render_extent;
+	ImageWriter::PixelFormat                           readback_format = ImageWriter::PixelFormat::eRGBA8;
+	FrameExporter                                      frame_exporter;
+	FrameOutput                                        frame_output;
+	int                                                exit_code = 0;
 };
 
 std::unordered_map<KeyboardAction, void (*)(MainAppImpl*)> callback_map;
 
 static MainAppImpl* gApp = nullptr;
 
+// A drag resizes many times per frame, the swapchain is recreated once before the next frame
 static void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
 	gApp->bSwapchainDirty = true;
+	gApp->bNeedsRedraw    = true;
 	if (width <= 0 || height <= 0) return;
 	gApp->UpdateViewport(width, height);
-	gApp->RecreateSwapchain(width, height);
 }
 
 static void WindowRefreshCallback(GLFWwindow* window) {
@@ -241,6 +713,7 @@ static void CursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
 	Window* app_window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
 	int     x, y, width, height;
 	app_window->GetRect(x, y, width, height);
+	if (gApp->IsBenchmarking()) [[unlikely]] return; // mouse stays pinned
 	float  dx          = xpos - gApp->mouse.x;
 	float  dy          = ypos - gApp->mouse.y;
 	Action right_state = gApp->mouse.button_state[std::underlying_type_t<MouseButton>(MouseButton::eRight)];
@@ -252,6 +725,7 @@ static void CursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
 		gApp->mouse.x = static_cast<float>(xpos);
 		gApp->mouse.y = static_cast<float>(ypos);
 	}
+	gApp->bNeedsRedraw |= gApp->shader_input_usage.bMouse;
 }
 
 bool MainAppImpl::CallKeyCallback(KeyboardAction const& key) {
@@ -266,6 +740,7 @@ bool MainAppImpl::CallKeyCallback(KeyboardAction const& key) {
 static void KeyCallback(GLFWwindow* in_window, int in_keycode, int in_scancode, int in_action, int in_mods) {
 	using namespace Glfw;
 	[[maybe_unused]] bool bConsumed = gApp->CallKeyCallback({Key(in_keycode), Action(in_action), Mod(in_mods)});
+	gApp->bNeedsRedraw              = true;
 }
 
 static void MouseButtonCallback(GLFWwindow* in_window, int in_button, int in_action, int in_mods) {
@@ -275,12 +750,123 @@ static void MouseButtonCallback(GLFWwindow* in_window, int in_button, int in_act
 	Mod         mods   = static_cast<Mod>(in_mods);
 
 	gApp->mouse.button_state[in_button] = action;
+	gApp->bNeedsRedraw                  = true;
 }
 
 void MainAppImpl::Init() {
 	if (user_options.bStartPaused) {
 		bPaused = true;
 	}
+	if (!user_options.bHeadless) {
+		InitWindow();
+	}
+
+	CreateInstance();
+
+	if (user_options.bHeadless) {
+		UpdateViewport(user_options.headless_width, user_options.headless_height);
+	} else {
+		CHECK_RESULT(WindowManager::CreateWindowSurface(instance, reinterpret_cast<GLFWwindow*>(window.GetHandle()), GetAllocator(), &surface));
+		int x, y, width, height;
+		window.GetRect(x, y, width, height);
+		UpdateViewport(width, height);
+	}
+	SelectPhysicalDevice();
+	GetPhysicalDeviceInfo();
+
+	CreateDevice();
+	CreatePipelineCache();
+	// CreateVmaAllocator();
+
+	if (user_options.bHeadless) {
+		CreateOffscreenTargets();
+	} else {
+		CreateSwapchain();
+		CreateTimestampQueryPools();
+		InitFramePacer();
+		resolution_scaler.Init({.scale = user_options.render_scale, .target_ms = user_options.target_ms});
+		LogVerbose("Render scale: %.3f%s", resolution_scaler.GetScale(), resolution_scaler.IsAdaptive() ? ", adaptive" : "");
+		if (user_options.tile_budget_ms > 0.0f) {
+			tile_scheduler.Init({.budget_ms = user_options.tile_budget_ms});
+			LogVerbose("Tiled rendering: %.3f ms per frame", user_options.tile_budget_ms);
+		}
+		if (user_options.bPrerecord) {
+			CreatePrerecordedCommandPool();
+		}
+	}
+
+	CreateDescriptorSetLayout();
+	CreateDescriptorPool();
+	CreateDescriptorSet();
+	CreateChannelResources();
+
+	shader_compiler.Init();
+	shader_compiler.SetInProcessEnabled(user_options.bInProcessCompiler);
+	shader_compiler.SetModuleCacheDir(gGlobalData.slang_module_cache_dir);
+	LogVerbose("In-process shader compiler: %s", Utils::FormatBool(shader_compiler.HasInProcessBackend() && user_options.bInProcessCompiler).data());
+	if (shader_cache.Init({.directory = gGlobalData.shader_cache_dir})) {
+		LogVerbose("Shader cache: %ju bytes in %s", shader_cache.GetTotalSize(), gGlobalData.shader_cache_dir.data());
+	} else {
+		LOG_WARN("Failed to open shader cache %s", gGlobalData.shader_cache_dir.data());
+	}
+
+	CreatePipelineLayout();
+	CreateVertexShaderModule();
+	CreateFallbackPipeline();
+	current_pipeline = &fallback_pipeline;
+
+	// First build is done synchronously so the user shader is shown from the first frame
+	auto const          build_start_time = std::filesystem::file_time_type::clock::now();
+	PipelineBuildResult initial;
+	spec_constants.LoadControlFile(fragment_shader.spec_path);
+	bool const bInitialBuilt = TryCreateUserPasses(GetShaderBuildContext(), fragment_shader.path, initial, compiled_user_shaders);
+	fragment_shader.SetDependencies(initial.dependencies.value());
+	if (bInitialBuilt) {
+		UpdateSpecConstants(initial.spec_constants);
+		build_spec_values = spec_constants.GetValues();
+		// Control file names constants, their ids are only known after the first build
+		PipelineBuildResult specialized;
+		if (build_spec_values != initial.spec_values && RespecializeUserPasses(compiled_user_shaders, specialized)) {
+			DestroyPipelines(initial);
+			initial = std::move(specialized);
+		}
+		buffer_passes             = std::move(initial.buffer_passes);
+		user_pipeline             = initial.pipeline;
+		current_pipeline          = &user_pipeline;
+		shader_input_usage        = initial.input_usage;
+		image_workgroup_size      = initial.workgroup_size;
+		user_pipeline_spec_values = initial.spec_values;
+	}
+	fragment_shader.SetPipelineVersion(fragment_shader.GetFileVersion());
+	if (user_options.bHeadless || IsBenchmarking()) {
+		// Shader is built once, nothing to watch or rebuild
+		return;
+	}
+	if (!playlist.IsEmpty()) {
+		PrecompilePlaylist();
+	}
+	pipeline_build_last_request      = fragment_shader.GetFileVersion();
+	pipeline_build_requested_version = fragment_shader.GetFileVersion();
+	pipeline_build_spec_values       = build_spec_values;
+	pipeline_build_source            = PipelineBuildSource{
+		.path             = fragment_shader.path,
+		.compiled_shaders = compiled_user_shaders,
+		.spec_values      = build_spec_values,
+		.file_version     = fragment_shader.GetFileVersion(),
+	};
+	StartPipelineBuildThread();
+
+	if (user_options.bUpdateOnSave) {
+		fragment_shader.StartWatching(WindowManager::PostEmptyEvent, user_options.bPollFiles);
+		LogVerbose("Watching %s using %s", fragment_shader.path_string.data(), fragment_shader.watcher.IsUsingInotify() ? "inotify" : "polling");
+		// Saves during the initial build and the playlist precompile happened before watching
+		if (fragment_shader.IsModifiedSince(build_start_time)) {
+			fragment_shader.ForceReload();
+		}
+	}
+}
+
+void MainAppImpl::InitWindow() {
 	WindowManager::SetErrorCallback(WindowErrorCallback);
 	WindowManager::Init();
 	char        title_buffer[256];
@@ -293,6 +879,7 @@ void MainAppImpl::Init() {
 	std::snprintf(title_buffer, sizeof(title_buffer) - 1, "%s - %s",
 				  file_name,
 				  gGlobalData.application_title.data());
+	window_title = title_buffer;
 
 	WindowMode    initial_window_mode = WindowMode::eWindowed;
 	WindowRect    initial_window_rect{.x = kWindowDontCare, .y = kWindowDontCare, .width = kDefaultWindowWidth, .height = kDefaultWindowHeight};
@@ -338,6 +925,7 @@ void MainAppImpl::Init() {
 	int refresh_rate = glfwGetVideoMode(glfwGetPrimaryMonitor())->refreshRate;
 
 	if (user_options.fps_limit < 0) {
+		bFpsFromRefreshRate = true;
 		if (refresh_rate > 0) {
 			user_options.fps_limit = static_cast<float>(refresh_rate);
 		} else {
@@ -345,32 +933,6 @@ void MainAppImpl::Init() {
 		}
 	}
 	LogVerbose("Using refresh rate: %.1f", user_options.fps_limit);
-
-	CreateInstance();
-
-	CHECK_RESULT(WindowManager::CreateWindowSurface(instance, reinterpret_cast<GLFWwindow*>(window.GetHandle()), GetAllocator(), &surface));
-	int x, y, width, height;
-	window.GetRect(x, y, width, height);
-	UpdateViewport(width, height);
-	SelectPhysicalDevice();
-	GetPhysicalDeviceInfo();
-
-	CreateDevice();
-	// CreateVmaAllocator();
-
-	// CreateDescriptorSetLayout();
-	// CreateDescriptorPool();
-	// CreateDescriptorSet();
-
-	CreateSwapchain();
-
-	shader_compiler.Init();
-
-	CreatePipelineLayout();
-	CreateVertexShaderModule();
-	CreateFallbackPipeline();
-	current_pipeline = &fallback_pipeline;
-	UpdateUserFragmentShader();
 }
 
 auto FlipWindowAttrib(MainAppImpl* app, Glfw::WindowAttribute attribute) {
@@ -382,6 +944,8 @@ void MainAppImpl::SetupKeyCallbackMap() {
 	using namespace Glfw;
 	auto PauseCallback = +[](MainAppImpl* app) {
 		app->bPaused = !app->bPaused;
+		// Time continues from where it stopped
+		app->last_time = std::chrono::high_resolution_clock::now();
 		LOG_INFO("Paused: %s", Utils::FormatBool(app->bPaused).data());
 	};
 
@@ -415,7 +979,13 @@ void MainAppImpl::SetupKeyCallbackMap() {
 			 glfwSetWindowShouldClose(reinterpret_cast<GLFWwindow*>(app->window.GetHandle()), kTrue);
 		 }},
 		{KeyboardAction{Key::eF5, Action::ePress, Mod{}}, +[](MainAppImpl* app) {
-			 app->fragment_shader.UpdateFileVersion();
+			 app->fragment_shader.ForceReload();
+		 }},
+		{KeyboardAction{Key::ePageDown, Action::ePress, Mod{}}, +[](MainAppImpl* app) {
+			 if (!app->playlist.IsEmpty()) app->ShowPlaylistEntry(app->playlist.GetNextIndex(1));
+		 }},
+		{KeyboardAction{Key::ePageUp, Action::ePress, Mod{}}, +[](MainAppImpl* app) {
+			 if (!app->playlist.IsEmpty()) app->ShowPlaylistEntry(app->playlist.GetNextIndex(-1));
 		 }},
 		{KeyboardAction{Key::eF11, Action::ePress, Mod{}}, +[](MainAppImpl* app) {
 			 if (app->window.GetWindowMode() == WindowMode::eWindowed) {
@@ -424,7 +994,20 @@ void MainAppImpl::SetupKeyCallbackMap() {
 				 app->window.SetWindowMode(WindowMode::eWindowed);
 			 }
 		 }},
+		{KeyboardAction{Key::e0, Action::ePress, Mod::eAlt}, +[](MainAppImpl* app) {
+			 app->ResetSpecConstants();
+		 }},
 	};
+
+	// Alt+1-9 toggles or increments the specialization constant, with Shift decrements it
+	[]<u32... kIndices>(std::integer_sequence<u32, kIndices...>) {
+		auto const AddStep = [](Key key, Mod mod, void (*callback)(MainAppImpl*)) {
+			callback_map.insert({KeyboardAction{key, Action::ePress, mod}, callback});
+			callback_map.insert({KeyboardAction{key, Action::eRepeat, mod}, callback});
+		};
+		(AddStep(static_cast<Key>(std::to_underlying(Key::e1) + kIndices), Mod::eAlt, +[](MainAppImpl* app) { app->StepSpecConstant(kIndices, 1); }), ...);
+		(AddStep(static_cast<Key>(std::to_underlying(Key::e1) + kIndices), Mod::eAlt | Mod::eShift, +[](MainAppImpl* app) { app->StepSpecConstant(kIndices, -1); }), ...);
+	}(std::make_integer_sequence<u32, kSpecConstantKeyCount>{});
 }
 
 template <typename... Args>
@@ -433,42 +1016,364 @@ void MainAppImpl::LogVerbose(Args&&... args) const {
 }
 
 bool MainAppImpl::UpdateUserFragmentShader() {
+	TRACE_SCOPE("update_user_shader");
+	fragment_shader.UpdateFileVersion();
+	if (pipeline_build_last_request != fragment_shader.GetFileVersion()) {
+		pipeline_build_last_request = fragment_shader.GetFileVersion();
+		RequestPipelineBuild(pipeline_build_last_request);
+	}
+	if (fragment_shader.UpdateSpecFileVersion() && spec_constants.LoadControlFile(fragment_shader.spec_path)) {
+		ApplySpecControlValues();
+		RequestPipelineSpecialization();
+		LogSpecConstants();
+	}
+
+	std::unique_ptr<PipelineBuildResult> result{pipeline_build_result.exchange(nullptr, std::memory_order_acquire)};
+	if (!result) return false;
+
+	// Frames in flight may still use the old pipelines
+	for (BufferPass const& pass : buffer_passes) {
+		swapchain.DestroyDeferred(pass.pipeline);
+	}
+	buffer_passes     = std::move(result->buffer_passes);
+	bRenderGraphDirty = true;
+	++prerecorded_generation;
+	if (result->compiled_shaders.has_value()) {
+		compiled_user_shaders = std::move(result->compiled_shaders.value());
+	}
+	if (result->pipeline) {
+		swapchain.DestroyDeferred(user_pipeline);
+		user_pipeline             = result->pipeline;
+		current_pipeline          = &user_pipeline;
+		shader_input_usage        = result->input_usage;
+		image_workgroup_size      = result->workgroup_size;
+		user_pipeline_spec_values = result->spec_values;
+		// Constants of a reloaded shader keep the values set for them, the build used the previous ids
+		UpdateSpecConstants(result->spec_constants);
+		if (spec_constants.GetValues() != result->spec_values) {
+			RequestPipelineSpecialization();
+		}
+	} else {
+		current_pipeline   = &fallback_pipeline;
+		shader_input_usage = FrameInputUsage::ResolutionOnly();
+	}
+	if (result->dependencies.has_value()) {
+		fragment_shader.SetDependencies(result->dependencies.value());
+		LogVerbose("Watching %zu included files", fragment_shader.dependencies.size());
+	}
+	fragment_shader.SetPipelineVersion(result->file_version);
+	return true;
+};
+
+void MainAppImpl::UpdateSpecConstants(std::span<SpecConstant const> reflected) {
+	if (spec_constants.Update(reflected)) {
+		ApplySpecControlValues();
+		LogSpecConstants();
+	}
+}
+
+void MainAppImpl::ApplySpecControlValues() {
+	for (std::string const& message : spec_constants.ApplyControlValues()) {
+		LOG_WARN("%s: %s", fragment_shader.spec_path.string().data(), message.data());
+	}
+}
+
+void MainAppImpl::RequestPipelineSpecialization() {
+	{
+		std::lock_guard lock(pipeline_build_mutex);
+		pipeline_build_spec_values = spec_constants.GetValues();
+		++pipeline_build_spec_version;
+	}
+	pipeline_build_cv.notify_one();
+}
+
+void MainAppImpl::StepSpecConstant(u32 index, int direction) {
+	UserSpecConstant const* constant = spec_constants.Step(index, direction);
+	if (!constant) return;
+	LOG_INFO("%s = %s", constant->info.name.empty() ? std::format("constant_id {}", constant->info.id).data() : constant->info.name.data(),
+			 FormatSpecConstantValue(constant->info.type, constant->value).data());
+	RequestPipelineSpecialization();
+}
+
+void MainAppImpl::ResetSpecConstants() {
+	spec_constants.ResetToDefaults();
+	ApplySpecControlValues();
+	RequestPipelineSpecialization();
+	LogSpecConstants();
+}
+
+void MainAppImpl::LogSpecConstants() const {
+	for (u32 index = 0; UserSpecConstant const& constant : spec_constants.GetConstants()) {
+		std::string const key = index < kSpecConstantKeyCount ? std::format("Alt+{}", index + 1) : std::string{"-"};
+		LOG_INFO("[%s] constant_id %u %s = %s", key.data(), constant.info.id, constant.info.name.data(),
+				 FormatSpecConstantValue(constant.info.type, constant.value).data());
+		++index;
+	}
+}
+
+// Entries after the shown one are built on a bounded pool, each worker with its own compiler.
+// Pipelines are created against the shared pipeline cache, creation is thread-safe with it.
+void MainAppImpl::PrecompilePlaylist() {
+	auto const start_time   = std::chrono::steady_clock::now();
+	u32 const  max_threads  = user_options.precompile_threads > 0 ? static_cast<u32>(user_options.precompile_threads)
+																  : std::clamp(std::thread::hardware_concurrency(), 1u, kMaxPrecompileThreads);
+	u32 const  thread_count = std::min(max_threads, static_cast<u32>(playlist.GetSize() - 1));
+
+	// Created by the worker using it
+	std::vector<std::unique_ptr<ShaderCompiler>> compilers(thread_count);
+
+	u32 const built_count = playlist.Precompile(thread_count, [this, &compilers](u32 worker, PlaylistEntry& entry) {
+		std::unique_ptr<ShaderCompiler>& compiler = compilers[worker];
+		if (!compiler) {
+			TRACE_THREAD_NAME("playlist_build");
+			compiler = std::make_unique<ShaderCompiler>();
+			compiler->Init();
+			compiler->SetInProcessEnabled(user_options.bInProcessCompiler);
+			compiler->SetModuleCacheDir(gGlobalData.slang_module_cache_dir);
+		}
+		ShaderBuildContext const context{
+			.compiler = compiler.get(),
+			.spv_path = std::format("{}.{}", gGlobalData.user_fragment_spv_path, worker),
+		};
+		TRACE_SCOPE("build");
+		if (!TryCreateUserPasses(context, entry.path, entry.data.build, entry.data.compiled_shaders)) {
+			LOG_ERROR("Failed to build %s", entry.path.string().data());
+			return false;
+		}
+		return true;
+	});
+	LOG_INFO("Built %u of %zu playlist shaders on %u threads in %.1f ms", built_count + (current_pipeline == &user_pipeline), playlist.GetSize(),
+			 thread_count, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+}
+
+// Swaps the pipelines of the shown entry with the prebuilt ones of index. Entries whose files
+// changed while hidden are shown as built and rebuilt in the background.
+void MainAppImpl::ShowPlaylistEntry(std::size_t index) {
+	if (index == playlist.GetIndex()) {
+		playlist.RestartInterval();
+		return;
+	}
+
+	fragment_shader.StopWatching();
+
+	PlaylistEntry& hidden = playlist[playlist.GetIndex()];
+	bool const     bBuilt = current_pipeline == &user_pipeline;
+	if (!bBuilt) {
+		swapchain.DestroyDeferred(user_pipeline);
+	}
+	hidden.data.build = {
+		.pipeline       = bBuilt ? user_pipeline : vk::Pipeline{},
+		.input_usage    = shader_input_usage,
+		.workgroup_size = image_workgroup_size,
+		.buffer_passes  = std::move(buffer_passes),
+		.spec_values    = std::move(user_pipeline_spec_values),
+		.dependencies   = fragment_shader.dependencies,
+	};
+	for (UserSpecConstant const& constant : spec_constants.GetConstants()) {
+		hidden.data.build.spec_constants.push_back(constant.info);
+	}
+	hidden.data.spec_constants   = std::move(spec_constants);
+	hidden.data.compiled_shaders = std::move(compiled_user_shaders);
+	hidden.build_time            = fragment_shader.GetDirty() ? std::filesystem::file_time_type::min() : std::filesystem::file_time_type::clock::now();
+
+	playlist.SetIndex(index);
+	PlaylistEntry& shown      = playlist[index];
+	buffer_passes             = std::move(shown.data.build.buffer_passes);
+	compiled_user_shaders     = std::move(shown.data.compiled_shaders);
+	user_pipeline             = shown.data.build.pipeline;
+	current_pipeline          = user_pipeline ? &user_pipeline : &fallback_pipeline;
+	shader_input_usage        = user_pipeline ? shown.data.build.input_usage : FrameInputUsage::ResolutionOnly();
+	image_workgroup_size      = shown.data.build.workgroup_size;
+	user_pipeline_spec_values = std::move(shown.data.build.spec_values);
+	bRenderGraphDirty         = true;
+	bNeedsRedraw              = true;
+	++prerecorded_generation;
+
+	fragment_shader.Update(shown.path.string());
+	fragment_shader.SetDependencies(shown.data.build.dependencies.value_or(std::vector<std::filesystem::path>{}));
 	if (user_options.bUpdateOnSave) {
-		fragment_shader.UpdateFileVersion();
+		fragment_shader.StartWatching(WindowManager::PostEmptyEvent, user_options.bPollFiles);
+	}
+	fragment_shader.UpdateFileVersion();
+	fragment_shader.UpdateSpecFileVersion();
+	fragment_shader.SetPipelineVersion(fragment_shader.GetFileVersion());
+	pipeline_build_last_request = fragment_shader.GetFileVersion();
+
+	// Control values are read again, the file may have changed while hidden
+	spec_constants = std::move(shown.data.spec_constants);
+	spec_constants.LoadControlFile(fragment_shader.spec_path);
+	UpdateSpecConstants(shown.data.build.spec_constants);
+	shown.data.build = {};
+	// Finished for the hidden entry and never drawn with. Taken under the mutex before the source
+	// changes, results are only published under it, so no result of the shown entry is lost.
+	std::unique_ptr<PipelineBuildResult> stale;
+	{
+		// Build thread moves on to the shown entry once its current build finishes, that one is dropped
+		std::lock_guard lock(pipeline_build_mutex);
+		++pipeline_build_generation;
+		stale.reset(pipeline_build_result.exchange(nullptr, std::memory_order_acquire));
+		pipeline_build_source = PipelineBuildSource{
+			.path             = shown.path,
+			.compiled_shaders = compiled_user_shaders,
+			.spec_values      = user_pipeline_spec_values,
+			.file_version     = fragment_shader.GetFileVersion(),
+		};
+		pipeline_build_requested_version = fragment_shader.GetFileVersion();
+		pipeline_build_spec_values       = user_pipeline_spec_values;
+	}
+	if (stale) {
+		DestroyPipelines(*stale);
+	}
+	pipeline_build_cv.notify_one();
+	if (spec_constants.GetValues() != user_pipeline_spec_values) {
+		RequestPipelineSpecialization();
+	}
+
+	if (fragment_shader.IsModifiedSince(shown.build_time)) {
+		fragment_shader.ForceReload();
+	}
+
+	window_title = std::format("{} ({}/{}) - {}", shown.path.filename().string(), index + 1, playlist.GetSize(), gGlobalData.application_title);
+	window.SetText(window_title.data());
+	LOG_INFO("Showing %s (%zu/%zu)", fragment_shader.path_string.data(), index + 1, playlist.GetSize());
+}
+
+// Advances the playlist when its interval has passed
+void MainAppImpl::UpdatePlaylist() {
+	if (!bPaused && playlist.IsSwitchDue()) {
+		ShowPlaylistEntry(playlist.GetNextIndex());
+	}
+}
+
+void MainAppImpl::StartPipelineBuildThread() {
+	pipeline_build_thread = std::jthread([this](std::stop_token stop_token) { PipelineBuildThread(stop_token); });
+}
+
+void MainAppImpl::StopPipelineBuildThread() {
+	if (pipeline_build_thread.joinable()) {
+		pipeline_build_thread.request_stop();
+		pipeline_build_thread.join();
+	}
+	if (std::unique_ptr<PipelineBuildResult> result{pipeline_build_result.exchange(nullptr, std::memory_order_acquire)}) {
+		DestroyPipelines(*result);
 	}
-	if (fragment_shader.GetDirty()) {
-		current_pipeline = &fallback_pipeline;
+}
+
+void MainAppImpl::DestroyPipelines(PipelineBuildResult const& result) {
+	device.destroyPipeline(result.pipeline, GetAllocator());
+	for (BufferPass const& pass : result.buffer_passes) {
+		device.destroyPipeline(pass.pipeline, GetAllocator());
+	}
+}
 
-		static int last_recreation_attempt_file_version = -1;
-		if (last_recreation_attempt_file_version != fragment_shader.GetFileVersion()) {
-			last_recreation_attempt_file_version = fragment_shader.GetFileVersion();
-			if (TryRecreateUserPipeline()) {
-				fragment_shader.SetPipelineVersion(last_recreation_attempt_file_version);
-				current_pipeline = &user_pipeline;
+void MainAppImpl::RequestPipelineBuild(int file_version) {
+	{
+		std::lock_guard lock(pipeline_build_mutex);
+		pipeline_build_requested_version = file_version;
+	}
+	pipeline_build_cv.notify_one();
+}
+
+void MainAppImpl::PipelineBuildThread(std::stop_token stop_token) {
+	TRACE_THREAD_NAME("pipeline_build");
+	std::filesystem::path           path;
+	std::vector<CompiledUserShader> compiled_shaders; // of the last build
+	int                             generation         = -1;
+	int                             built_version      = -1;
+	int                             built_spec_version = -1;
+	while (true) {
+		int file_version;
+		{
+			// Requests made during a build are coalesced into one, only the latest version is built
+			std::unique_lock lock(pipeline_build_mutex);
+			if (!pipeline_build_cv.wait(lock, stop_token, [&] {
+					return pipeline_build_source.has_value() || pipeline_build_requested_version != built_version ||
+						   pipeline_build_spec_version != built_spec_version;
+				})) return;
+			if (pipeline_build_source.has_value()) {
+				generation         = pipeline_build_generation;
+				path               = std::move(pipeline_build_source->path);
+				compiled_shaders   = std::move(pipeline_build_source->compiled_shaders);
+				build_spec_values  = std::move(pipeline_build_source->spec_values);
+				built_version      = pipeline_build_source->file_version;
+				built_spec_version = pipeline_build_spec_values == build_spec_values ? pipeline_build_spec_version : -1;
+				pipeline_build_source.reset();
+				continue;
 			}
+			file_version       = pipeline_build_requested_version;
+			built_spec_version = pipeline_build_spec_version;
+			build_spec_values  = pipeline_build_spec_values;
 		}
-		return true;
+		// Only values changed, the pipelines are created again from the SPIR-V of the last build
+		bool const bRespecialize = file_version == built_version;
+		built_version            = file_version;
+
+		TRACE_SCOPE(bRespecialize ? "respecialize" : "build");
+		auto result = std::make_unique<PipelineBuildResult>();
+		if (bRespecialize) {
+			if (compiled_shaders.empty() || !RespecializeUserPasses(compiled_shaders, *result)) continue;
+		} else {
+			if (!TryCreateUserPasses(GetShaderBuildContext(), path, *result, compiled_shaders)) {
+				result->pipeline = vk::Pipeline{};
+			}
+			result->compiled_shaders = compiled_shaders;
+		}
+		result->file_version = file_version;
+		// Result not yet picked up by the render loop was never drawn with, safe to destroy here.
+		// So is one of a playlist entry no longer shown.
+		std::unique_ptr<PipelineBuildResult> stale;
+		{
+			std::lock_guard lock(pipeline_build_mutex);
+			stale.reset(generation == pipeline_build_generation ? pipeline_build_result.exchange(result.release(), std::memory_order_acq_rel)
+																 : result.release());
+		}
+		if (stale) {
+			DestroyPipelines(*stale);
+		}
+		// Render loop may be sleeping in WaitEvents
+		WindowManager::PostEmptyEvent();
 	}
-	return false;
-};
+}
 
 MainAppImpl::~MainAppImpl() { Destroy(); }
 
 void MainAppImpl::Destroy() {
 
+	fragment_shader.StopWatching();
 	if (device) {
+		StopPipelineBuildThread();
 		CHECK_RESULT(device.waitIdle());
 
 		device.destroyPipeline(user_pipeline, GetAllocator());
 		device.destroyPipeline(fallback_pipeline, GetAllocator());
+		for (BufferPass const& pass : buffer_passes) {
+			device.destroyPipeline(pass.pipeline, GetAllocator());
+		}
+		buffer_passes.clear();
+		for (PlaylistEntry const& entry : playlist.GetEntries()) {
+			DestroyPipelines(entry.data.build);
+		}
+		playlist.Clear();
+		render_graph.Reset();
+		for (TiledImage& tiled_image : tiled_images) {
+			tiled_image.image.Destroy();
+		}
 		device.destroyShaderModule(vertex_shader_module, GetAllocator());
 		device.destroyPipelineLayout(pipeline_layout, GetAllocator());
 
-		// device.destroyDescriptorSetLayout(descriptor_set_layout, GetAllocator());
-		// device.destroyDescriptorPool(descriptor_pool, GetAllocator());
+		device.destroyDescriptorSetLayout(descriptor_set_layout, GetAllocator());
+		device.destroyDescriptorPool(descriptor_pool, GetAllocator());
+		device.destroyDescriptorSetLayout(channel_set_layout, GetAllocator());
+		device.destroyDescriptorPool(channel_descriptor_pool, GetAllocator());
+		device.destroySampler(channel_sampler, GetAllocator());
+		frame_uniforms.Destroy();
+		device.destroyCommandPool(prerecorded_command_pool, GetAllocator());
 
+		DestroyOffscreenTargets();
+		frame_timestamps.clear();
 		swapchain.Destroy();
-		device.destroyPipelineCache(pipeline_cache, GetAllocator());
+		SavePipelineCache();
+		pipeline_cache.Destroy();
 
 		// vmaDestroyAllocator(vma_allocator);
 
@@ -491,15 +1396,27 @@ void MainAppImpl::Destroy() {
 void MainAppImpl::CreateInstance() {
 	vk::ApplicationInfo applicationInfo{.apiVersion = kApiVersion};
 
-	u32 glfw_extensions_count;
+	u32 glfw_extensions_count = 0;
 
-	char const** glfw_extensions = WindowManager::GetRequiredInstanceExtensions(&glfw_extensions_count);
+	char const** glfw_extensions = user_options.bHeadless ? nullptr : WindowManager::GetRequiredInstanceExtensions(&glfw_extensions_count);
 
 	std::vector<char const*> enabledExtensions(glfw_extensions, glfw_extensions + glfw_extensions_count);
 	if (user_options.bValidationEnabled) {
 		enabled_layers = kEnabledLayers;
 		enabledExtensions.push_back(vk::EXTDebugUtilsExtensionName);
 	}
+	if (!user_options.bHeadless) {
+		auto [extensions_result, available_extensions] = vk::enumerateInstanceExtensionProperties();
+		bSurfaceMaintenance                            = extensions_result == vk::Result::eSuccess &&
+														 std::ranges::all_of(kSurfaceMaintenanceInstanceExtensions, [&](std::string_view extension) {
+															 return std::ranges::any_of(available_extensions, [&](vk::ExtensionProperties const& available_extension) {
+																 return available_extension.extensionName == extension;
+															 });
+														 });
+		if (bSurfaceMaintenance) {
+			enabledExtensions.append_range(kSurfaceMaintenanceInstanceExtensions);
+		}
+	}
 
 	vk::DebugUtilsMessengerCreateInfoEXT constexpr kDebugUtilsCreateInfo = {
 		.messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning |
@@ -538,7 +1455,16 @@ void MainAppImpl::SelectPhysicalDevice() {
 	for (vk::PhysicalDevice const& device : vulkan_physical_devices) {
 		physical_device.Assign(device);
 		CHECK_RESULT(physical_device.GetDetails());
-		if (physical_device.IsSuitable(surface, kEnabledDeviceExtensions)) {
+		if (physical_device.IsSuitable(surface, GetRequiredDeviceExtensions())) {
+			device_extensions.assign(GetRequiredDeviceExtensions().begin(), GetRequiredDeviceExtensions().end());
+			if (!user_options.bHeadless && SupportsPresentWait()) {
+				device_extensions.append_range(kPresentWaitDeviceExtensions);
+				bPresentWait = true;
+			}
+			if (bSurfaceMaintenance && SupportsSwapchainMaintenance()) {
+				device_extensions.append_range(kSwapchainMaintenanceDeviceExtensions);
+				bSwapchainMaintenance = true;
+			}
 			if (user_options.bVerbose) {
 			}
 			return;
@@ -551,12 +1477,34 @@ void MainAppImpl::SelectPhysicalDevice() {
 void MainAppImpl::GetPhysicalDeviceInfo() {
 }
 
+bool MainAppImpl::SupportsPresentWait() {
+	if (!physical_device.SupportsExtensions(kPresentWaitDeviceExtensions)) return false;
+	vk::StructureChain features{
+		vk::PhysicalDeviceFeatures2{},
+		vk::PhysicalDevicePresentIdFeaturesKHR{},
+		vk::PhysicalDevicePresentWaitFeaturesKHR{},
+	};
+	physical_device.getFeatures2(&features.get<vk::PhysicalDeviceFeatures2>());
+	return features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+		   features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+}
+
+bool MainAppImpl::SupportsSwapchainMaintenance() {
+	if (!physical_device.SupportsExtensions(kSwapchainMaintenanceDeviceExtensions)) return false;
+	vk::StructureChain features{
+		vk::PhysicalDeviceFeatures2{},
+		vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT{},
+	};
+	physical_device.getFeatures2(&features.get<vk::PhysicalDeviceFeatures2>());
+	return features.get<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().swapchainMaintenance1;
+}
+
 void MainAppImpl::CreateDevice() {
 	float const queue_priorities[] = {1.0f};
 
 	auto [result, index] = physical_device.GetQueueFamilyIndex({.flags = vk::QueueFlagBits::eGraphics, .surface = surface});
 	if (result != vk::Result::eSuccess || !index.has_value()) {
-		LOG_ERROR("Failed to get graphics queue family index with surface support");
+		LOG_ERROR("Failed to get graphics queue family index%s", surface ? " with surface support" : "");
 		CHECK_RESULT(result);
 	}
 
@@ -574,7 +1522,17 @@ void MainAppImpl::CreateDevice() {
 		vk::PhysicalDeviceVulkan11Features{},
 		vk::PhysicalDeviceVulkan12Features{},
 		vk::PhysicalDeviceVulkan13Features{.synchronization2 = vk::True, .dynamicRendering = vk::True},
+		vk::PhysicalDevicePresentIdFeaturesKHR{.presentId = vk::True},
+		vk::PhysicalDevicePresentWaitFeaturesKHR{.presentWait = vk::True},
+		vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT{.swapchainMaintenance1 = vk::True},
 	};
+	if (!bPresentWait) {
+		features.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+		features.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+	}
+	if (!bSwapchainMaintenance) {
+		features.unlink<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>();
+	}
 
 	vk::DeviceCreateInfo info{
 		.pNext                   = &features.get<vk::PhysicalDeviceFeatures2>(),
@@ -582,12 +1540,36 @@ void MainAppImpl::CreateDevice() {
 		.pQueueCreateInfos       = queue_create_infos,
 		.enabledLayerCount       = static_cast<u32>(std::size(enabled_layers)),
 		.ppEnabledLayerNames     = enabled_layers.data(),
-		.enabledExtensionCount   = static_cast<u32>(std::size(kEnabledDeviceExtensions)),
-		.ppEnabledExtensionNames = kEnabledDeviceExtensions,
+		.enabledExtensionCount   = static_cast<u32>(std::size(GetDeviceExtensions())),
+		.ppEnabledExtensionNames = GetDeviceExtensions().data(),
 	};
 
 	CHECK_RESULT(physical_device.createDevice(&info, GetAllocator(), &device));
 	queue = device.getQueue(queue_create_infos[0].queueFamilyIndex, 0);
+	if (bPresentWait) {
+		LoadDevicePresentWaitFunctionsKHR(device);
+	}
+}
+
+void MainAppImpl::CreatePipelineCache() {
+	VulkanRHI::PipelineCacheInfo info{
+		.file_path = gGlobalData.pipeline_cache_path,
+	};
+	CHECK_RESULT(pipeline_cache.Create(device, physical_device, info, GetAllocator()));
+	LogVerbose("Pipeline cache: loaded %zu bytes from %s", pipeline_cache.GetLoadedSize(), gGlobalData.pipeline_cache_path.data());
+}
+
+void MainAppImpl::SavePipelineCache() {
+	if (!pipeline_cache) return;
+	LogVerbose("Pipeline cache: %u hits, %u misses", pipeline_cache.GetHitCount(), pipeline_cache.GetMissCount());
+	vk::Result result = pipeline_cache.Save();
+	if (result != vk::Result::eSuccess) {
+		LOG_WARN("Failed to save pipeline cache: %s", vk::to_string(result).c_str());
+	} else if (pipeline_cache.IsSizeCapExceeded()) {
+		LogVerbose("Pipeline cache: not saved, size cap exceeded");
+	} else {
+		LogVerbose("Pipeline cache: saved %zu bytes to %s", pipeline_cache.GetSavedSize(), gGlobalData.pipeline_cache_path.data());
+	}
 }
 
 void MainAppImpl::CreateSwapchain() {
@@ -599,46 +1581,236 @@ void MainAppImpl::CreateSwapchain() {
 		.queue_family_index = queue_family_index,
 		// .preferred_format   = vk::Format::eR8G8B8A8Srgb,
 		.preferred_format = vk::Format::eR8G8B8A8Unorm,
+		.bPresentWait     = bPresentWait,
+		.bMaintenance1    = bSwapchainMaintenance,
 	};
 	CHECK_RESULT(swapchain.Create(device, physical_device, info, GetAllocator()));
+	color_format = swapchain.GetFormat();
 }
 
-void MainAppImpl::CreatePipelineLayout() {
-	vk::PushConstantRange push_constant_range{
-		.stageFlags = vk::ShaderStageFlagBits::eFragment,
-		.offset     = 0,
-		.size       = physical_device.GetMaxPushConstantsSize(),
-	};
+void MainAppImpl::CreateTimestampQueryPools() {
+	frame_timestamps.resize(swapchain.GetFrameData().size());
+	for (FrameTimestamps& timestamps : frame_timestamps) {
+		CHECK_RESULT(timestamps.pool.Create(device, physical_device, {.queue_family_index = queue_family_index, .query_count = 2}, GetAllocator()));
+	}
+	if (!frame_timestamps.empty() && !frame_timestamps[0].pool.IsSupported()) {
+		LogVerbose("GPU timestamps are not supported on the graphics queue");
+	}
+}
 
-	vk::PipelineLayoutCreateInfo info{
-		.setLayoutCount = 0,
-		// .pSetLayouts            = &descriptor_set_layout,
-		.pushConstantRangeCount = 1,
-		.pPushConstantRanges    = &push_constant_range,
+void MainAppImpl::CreateOffscreenTargets() {
+	render_extent = {static_cast<u32>(user_options.headless_width), static_cast<u32>(user_options.headless_height)};
+	// Half float keeps the range of HDR output for EXR, 8 bit is enough for the other formats and Y4M
+	bool const bFloat = ImageWriter::GetFileFormat(user_options.output_path) == ImageWriter::ImageFileFormat::eEXR;
+	color_format      = bFloat ? vk::Format::eR16G16B16A16Sfloat : vk::Format::eR8G8B8A8Unorm;
+	readback_format   = bFloat ? ImageWriter::PixelFormat::eRGBA16F : ImageWriter::PixelFormat::eRGBA8;
+
+	vk::DeviceSize const readback_size = vk::DeviceSize(render_extent.width) * render_extent.height * ImageWriter::GetPixelSize(readback_format);
+	offscreen_targets                  = std::vector<OffscreenTarget>(user_options.readback_buffers);
+	for (OffscreenTarget& target : offscreen_targets) {
+		CHECK_RESULT(target.image.Create(device, physical_device,
+										 {
+											 .extent = render_extent,
+											 .format = color_format,
+											 .usage  = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc |
+													  vk::ImageUsageFlagBits::eTransferDst,
+										 },
+										 GetAllocator()));
+
+		// Cached memory makes reading back on the CPU much faster, not every device has it
+		VulkanRHI::BufferInfo readback_info{
+			.size              = readback_size,
+			.usage             = vk::BufferUsageFlagBits::eTransferDst,
+			.memory_properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached,
+		};
+		if (target.readback.Create(device, physical_device, readback_info, GetAllocator()) != vk::Result::eSuccess) {
+			readback_info.memory_properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			CHECK_RESULT(target.readback.Create(device, physical_device, readback_info, GetAllocator()));
+		}
+
+		vk::CommandPoolCreateInfo pool_info{.queueFamilyIndex = queue_family_index};
+		CHECK_RESULT(device.createCommandPool(&pool_info, GetAllocator(), &target.command_pool));
+		vk::CommandBufferAllocateInfo alloc_info{
+			.commandPool        = target.command_pool,
+			.level              = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = 1,
+		};
+		CHECK_RESULT(device.allocateCommandBuffers(&alloc_info, &target.command_buffer));
+		vk::FenceCreateInfo fence_info{.flags = vk::FenceCreateFlagBits::eSignaled};
+		CHECK_RESULT(device.createFence(&fence_info, GetAllocator(), &target.fence));
+		CHECK_RESULT(target.timestamps.pool.Create(device, physical_device, {.queue_family_index = queue_family_index, .query_count = 2}, GetAllocator()));
+	}
+	LogVerbose("Headless: rendering %ux%u %s", render_extent.width, render_extent.height, vk::to_string(color_format).c_str());
+}
+
+void MainAppImpl::DestroyOffscreenTargets() {
+	// Workers may still read the readback buffers
+	(void)frame_exporter.Finish();
+	for (OffscreenTarget& target : offscreen_targets) {
+		target.image.Destroy();
+		target.readback.Destroy();
+		device.destroyCommandPool(target.command_pool, GetAllocator());
+		device.destroyFence(target.fence, GetAllocator());
+		target.timestamps.pool.Destroy();
+	}
+	offscreen_targets.clear();
+}
+
+void MainAppImpl::CreateDescriptorSetLayout() {
+	vk::DescriptorSetLayoutBinding binding{
+		.binding         = 0,
+		.descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+		.descriptorCount = 1,
+		.stageFlags      = kUserShaderStages,
 	};
+	vk::DescriptorSetLayoutCreateInfo info{
+		.bindingCount = 1,
+		.pBindings    = &binding,
+	};
+	CHECK_RESULT(device.createDescriptorSetLayout(&info, GetAllocator(), &descriptor_set_layout));
+}
 
-	CHECK_RESULT(device.createPipelineLayout(&info, GetAllocator(), &pipeline_layout));
+void MainAppImpl::CreateDescriptorPool() {
+	vk::DescriptorPoolSize pool_size{
+		.type            = vk::DescriptorType::eUniformBufferDynamic,
+		.descriptorCount = 1,
+	};
+	vk::DescriptorPoolCreateInfo info{
+		.maxSets       = 1,
+		.poolSizeCount = 1,
+		.pPoolSizes    = &pool_size,
+	};
+	CHECK_RESULT(device.createDescriptorPool(&info, GetAllocator(), &descriptor_pool));
 }
 
-void MainAppImpl::CreateVertexShaderModule() {
-	std::span<u32 const> shader_code = ShaderCodes::kVertexQuad;
+void MainAppImpl::CreateDescriptorSet() {
+	std::size_t const    slot_count = user_options.bHeadless ? offscreen_targets.size() : swapchain.GetFrameData().size();
+	vk::DeviceSize const alignment  = physical_device.GetProperties10().limits.minUniformBufferOffsetAlignment;
+	frame_uniforms_stride           = (sizeof(PushConstants) + alignment - 1) / alignment * alignment;
+	CHECK_RESULT(frame_uniforms.Create(device, physical_device,
+									   {
+										   .size              = frame_uniforms_stride * slot_count,
+										   .usage             = vk::BufferUsageFlagBits::eUniformBuffer,
+										   .memory_properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+									   },
+									   GetAllocator()));
+
+	vk::DescriptorSetAllocateInfo alloc_info{
+		.descriptorPool     = descriptor_pool,
+		.descriptorSetCount = 1,
+		.pSetLayouts        = &descriptor_set_layout,
+	};
+	CHECK_RESULT(device.allocateDescriptorSets(&alloc_info, &descriptor_set));
 
-	vk::ShaderModuleCreateInfo info{
-		.codeSize = shader_code.size() * sizeof(shader_code[0]),
-		.pCode    = reinterpret_cast<const u32*>(shader_code.data()),
+	vk::DescriptorBufferInfo buffer_info{
+		.buffer = frame_uniforms,
+		.offset = 0,
+		.range  = sizeof(PushConstants),
 	};
-	CHECK_RESULT(device.createShaderModule(&info, GetAllocator(), &vertex_shader_module));
+	vk::WriteDescriptorSet write{
+		.dstSet          = descriptor_set,
+		.dstBinding      = 0,
+		.descriptorCount = 1,
+		.descriptorType  = vk::DescriptorType::eUniformBufferDynamic,
+		.pBufferInfo     = &buffer_info,
+	};
+	device.updateDescriptorSets(1, &write, 0, nullptr);
 }
 
-void MainAppImpl::CreateFallbackPipeline() {
-	// std::optional<std::span<std::byte const>> shader_code;
-	do {
-		{
-			// Load from file
-			std::optional<std::span<std::byte>> shader_code = file_manager.ReadBinaryFile(gGlobalData.fallback_fragment_spv_path);
-			if (shader_code.has_value() && !shader_code.value().empty()) {
+// Layout and sampler of the iChannel and compute output bindings, sets are allocated with the render graph
+void MainAppImpl::CreateChannelResources() {
+	std::array<vk::DescriptorSetLayoutBinding, kBufferCount + 1> bindings;
+	for (u32 channel = 0; channel < kBufferCount; ++channel) {
+		bindings[channel] = {
+			.binding         = channel,
+			.descriptorType  = vk::DescriptorType::eCombinedImageSampler,
+			.descriptorCount = 1,
+			.stageFlags      = kUserShaderStages,
+		};
+	}
+	bindings[kOutputBinding] = {
+		.binding         = kOutputBinding,
+		.descriptorType  = vk::DescriptorType::eStorageImage,
+		.descriptorCount = 1,
+		.stageFlags      = vk::ShaderStageFlagBits::eCompute,
+	};
+	vk::DescriptorSetLayoutCreateInfo layout_info{
+		.bindingCount = static_cast<u32>(bindings.size()),
+		.pBindings    = bindings.data(),
+	};
+	CHECK_RESULT(device.createDescriptorSetLayout(&layout_info, GetAllocator(), &channel_set_layout));
+
+	vk::SamplerCreateInfo sampler_info{
+		.magFilter    = vk::Filter::eLinear,
+		.minFilter    = vk::Filter::eLinear,
+		.mipmapMode   = vk::SamplerMipmapMode::eNearest,
+		.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeV = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeW = vk::SamplerAddressMode::eClampToEdge,
+		.maxLod       = 0.0f,
+	};
+	CHECK_RESULT(device.createSampler(&sampler_info, GetAllocator(), &channel_sampler));
+}
+
+// Slice of this slot is not read by the GPU, its last frame has completed
+void MainAppImpl::WriteFrameUniforms(u32 slot, u32 width, u32 height) {
+	WriteFrameUniforms(slot, GetFrameConstants(width, height));
+}
+
+void MainAppImpl::WriteFrameUniforms(u32 slot, PushConstants const& constants) {
+	std::memcpy(frame_uniforms.GetMappedData().subspan(slot * frame_uniforms_stride).data(), &constants, sizeof(constants));
+}
+
+// Resolution is that of the passes, the mouse position is scaled from window to render pixels
+auto MainAppImpl::GetFrameConstants(u32 width, u32 height) const -> PushConstants {
+	float const scale = resolution_scaler.GetScale();
+	return {
+		.resolution = {static_cast<float>(width), static_cast<float>(height)},
+		.mouse      = {mouse.x * scale, user_options.bFlipY ? height - mouse.y * scale : mouse.y * scale},
+		.time       = time,
+		.time_delta = time_delta,
+		.frame      = frame_index,
+	};
+}
+
+void MainAppImpl::CreatePipelineLayout() {
+	vk::PushConstantRange push_constant_range{
+		.stageFlags = kUserShaderStages,
+		.offset     = 0,
+		.size       = physical_device.GetMaxPushConstantsSize(),
+	};
+
+	vk::DescriptorSetLayout const set_layouts[] = {descriptor_set_layout, channel_set_layout};
+
+	vk::PipelineLayoutCreateInfo info{
+		.setLayoutCount         = static_cast<u32>(std::size(set_layouts)),
+		.pSetLayouts            = set_layouts,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges    = &push_constant_range,
+	};
+
+	CHECK_RESULT(device.createPipelineLayout(&info, GetAllocator(), &pipeline_layout));
+}
+
+void MainAppImpl::CreateVertexShaderModule() {
+	std::span<u32 const> shader_code = ShaderCodes::kVertexQuad;
+
+	vk::ShaderModuleCreateInfo info{
+		.codeSize = shader_code.size() * sizeof(shader_code[0]),
+		.pCode    = reinterpret_cast<const u32*>(shader_code.data()),
+	};
+	CHECK_RESULT(device.createShaderModule(&info, GetAllocator(), &vertex_shader_module));
+}
+
+void MainAppImpl::CreateFallbackPipeline() {
+	// std::optional<std::span<std::byte const>> shader_code;
+	do {
+		{
+			// Load from file
+			std::optional<std::span<std::byte>> shader_code = file_manager.ReadBinaryFile(gGlobalData.fallback_fragment_spv_path);
+			if (shader_code.has_value() && !shader_code.value().empty()) {
 				LogVerbose("Loaded fallback fragment shader from file %s.", gGlobalData.fallback_fragment_spv_path.data());
-				vk::Result result = CreatePipeline(shader_code.value(), fallback_pipeline);
+				vk::Result result = CreatePipeline(shader_code.value(), color_format, fallback_pipeline);
 				if (result == vk::Result::eSuccess) continue;
 			}
 		}
@@ -649,7 +1821,7 @@ void MainAppImpl::CreateFallbackPipeline() {
 				std::optional<std::span<std::byte const>> shader_code = file_manager.ReadBinaryFile(gGlobalData.fallback_fragment_spv_path);
 				if (shader_code.has_value() && !shader_code.value().empty()) {
 					LogVerbose("Loaded compiled fallback fragment.");
-					vk::Result result = CreatePipeline(shader_code.value(), fallback_pipeline);
+					vk::Result result = CreatePipeline(shader_code.value(), color_format, fallback_pipeline);
 					if (result == vk::Result::eSuccess) continue;
 				} else {
 					LogVerbose("Failed to load compiled fallback fragment.");
@@ -665,12 +1837,14 @@ void MainAppImpl::CreateFallbackPipeline() {
 				reinterpret_cast<const std::byte*>(ShaderCodes::kFragmentFallbackDefault),
 				sizeof(ShaderCodes::kFragmentFallbackDefault),
 			};
-			CHECK_RESULT(CreatePipeline(fallback_fragment_shader_code, fallback_pipeline));
+			CHECK_RESULT(CreatePipeline(fallback_fragment_shader_code, color_format, fallback_pipeline));
 		}
 	} while (false);
 };
 
-auto MainAppImpl::CreatePipeline(std::span<std::byte const> fragment_shader_code, vk::Pipeline& pipeline) -> vk::Result {
+auto MainAppImpl::CreatePipeline(std::span<std::byte const> fragment_shader_code, vk::Format format, vk::Pipeline& pipeline,
+								 vk::SpecializationInfo const* specialization_info) -> vk::Result {
+	TRACE_SCOPE("create_pipeline");
 	vk::Result result;
 
 	vk::ShaderModuleCreateInfo shader_module_info{
@@ -712,7 +1886,7 @@ auto MainAppImpl::CreatePipeline(std::span<std::byte const> fragment_shader_code
 
 	vk::PipelineShaderStageCreateInfo shader_stages[] = {
 		{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertex_shader_module, .pName = "main"},
-		{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragment_shader_module, .pName = "main"},
+		{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragment_shader_module, .pName = "main", .pSpecializationInfo = specialization_info},
 	};
 
 	vk::PipelineVertexInputStateCreateInfo vertex_input_state{};
@@ -769,10 +1943,16 @@ auto MainAppImpl::CreatePipeline(std::span<std::byte const> fragment_shader_code
 		.pDynamicStates    = dynamic_states,
 	};
 
+	vk::PipelineCreationFeedback           pipeline_feedback{};
+	vk::PipelineCreationFeedbackCreateInfo pipeline_feedback_info{
+		.pPipelineCreationFeedback = &pipeline_feedback,
+	};
+
 	vk::PipelineRenderingCreateInfo pipeline_rendering_info{
+		.pNext                   = &pipeline_feedback_info,
 		.viewMask                = 0,
 		.colorAttachmentCount    = 1,
-		.pColorAttachmentFormats = &swapchain.GetFormat(),
+		.pColorAttachmentFormats = &format,
 		// .depthAttachmentFormat   = vk::Format::eD32Sfloat,
 		// .stencilAttachmentFormat = vk::Format::eUndefined,
 	};
@@ -796,52 +1976,329 @@ auto MainAppImpl::CreatePipeline(std::span<std::byte const> fragment_shader_code
 	if (result != vk::Result::eSuccess) {
 		return result;
 	}
+	pipeline_cache.RecordFeedback(pipeline_feedback);
+	LogVerbose("Pipeline cache %s", pipeline_feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit ? "hit" : "miss");
 
 	return vk::Result::eSuccess;
 }
 
-bool MainAppImpl::TryRecreateUserPipeline() {
-	std::chrono::high_resolution_clock::time_point compile_start_time = std::chrono::high_resolution_clock::now();
-	if (!shader_compiler.CompileShader(fragment_shader.path_string, gGlobalData.user_fragment_spv_path, user_options.compile_options)) return false;
-	std::chrono::duration<double>             compile_time    = std::chrono::high_resolution_clock::now() - compile_start_time;
-	auto                                      compile_time_ms = compile_time.count() * 1000.0f;
-	std::optional<std::span<const std::byte>> shader_code     = file_manager.ReadBinaryFile(gGlobalData.user_fragment_spv_path);
-	if (!shader_code.has_value()) {
-		LOG_ERROR("Error: %s", shader_compiler.GetErrorMessage().data());
-		return false;
+// Largest power of two square, or twice as wide, within the device limits and kMaxWorkgroupInvocations.
+// Shaders that fix their size keep it, the dispatch covers the target with it.
+auto MainAppImpl::SelectWorkgroupSize(ComputeWorkgroup const& workgroup) const -> vk::Extent2D {
+	if (!workgroup.bSpecializable) {
+		return {std::max(workgroup.size[0], 1u), std::max(workgroup.size[1], 1u)};
+	}
+	constexpr u32                   kMaxWorkgroupInvocations = 256;
+	vk::PhysicalDeviceLimits const& limits                   = physical_device.GetProperties10().limits;
+	u32 const                       max_invocations          = std::min(limits.maxComputeWorkGroupInvocations, kMaxWorkgroupInvocations);
+	vk::Extent2D                    size{1, 1};
+	while (true) {
+		if (size.width * 2 * size.height <= max_invocations && size.width * 2 <= limits.maxComputeWorkGroupSize[0]) {
+			size.width *= 2;
+		} else {
+			break;
+		}
+		if (size.width * size.height * 2 <= max_invocations && size.height * 2 <= limits.maxComputeWorkGroupSize[1]) {
+			size.height *= 2;
+		}
+	}
+	return size;
+}
+
+auto MainAppImpl::CreateComputePipeline(std::span<u32 const> compute_shader_code, vk::SpecializationInfo const& specialization_info,
+										vk::Pipeline& pipeline) -> vk::Result {
+	TRACE_SCOPE("create_pipeline");
+	vk::ShaderModuleCreateInfo const shader_module_info{
+		.codeSize = compute_shader_code.size_bytes(),
+		.pCode    = compute_shader_code.data(),
+	};
+	vk::ShaderModule shader_module;
+	vk::Result       result = device.createShaderModule(&shader_module_info, GetAllocator(), &shader_module);
+	if (result != vk::Result::eSuccess) [[unlikely]] {
+		return result;
+	}
+
+	vk::PipelineCreationFeedback           pipeline_feedback{};
+	vk::PipelineCreationFeedbackCreateInfo pipeline_feedback_info{
+		.pPipelineCreationFeedback = &pipeline_feedback,
+	};
+	vk::ComputePipelineCreateInfo const info{
+		.pNext  = &pipeline_feedback_info,
+		.stage  = {
+			.stage               = vk::ShaderStageFlagBits::eCompute,
+			.module              = shader_module,
+			.pName               = "main",
+			.pSpecializationInfo = &specialization_info,
+		},
+		.layout = pipeline_layout,
+	};
+	result = device.createComputePipelines(GetPipelineCache(), 1, &info, GetAllocator(), &pipeline);
+	device.destroyShaderModule(shader_module, GetAllocator());
+	if (result != vk::Result::eSuccess) {
+		return result;
+	}
+	pipeline_cache.RecordFeedback(pipeline_feedback);
+	LogVerbose("Pipeline cache %s", pipeline_feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit ? "hit" : "miss");
+	return vk::Result::eSuccess;
+}
+
+void MainAppImpl::LogShaderDiagnostics(std::span<ShaderDiagnostic const> diagnostics) {
+	for (ShaderDiagnostic const& diagnostic : diagnostics) {
+		switch (diagnostic.severity) {
+		case ShaderDiagnosticSeverity::eError:   LOG_ERROR("%s:%d: %s", diagnostic.file.data(), diagnostic.line, diagnostic.message.data()); break;
+		case ShaderDiagnosticSeverity::eWarning: LOG_WARN("%s:%d: %s", diagnostic.file.data(), diagnostic.line, diagnostic.message.data()); break;
+		case ShaderDiagnosticSeverity::eNote:    LogVerbose("%s:%d: %s", diagnostic.file.data(), diagnostic.line, diagnostic.message.data()); break;
+		}
+	}
+}
+
+// Diagnostics kept in the shader cache, one per line as severity, line, file and message separated by tabs
+static auto FormatCachedDiagnostics(std::span<ShaderDiagnostic const> diagnostics) -> std::string {
+	std::string text;
+	for (ShaderDiagnostic const& diagnostic : diagnostics) {
+		std::string message = diagnostic.message;
+		std::ranges::replace(message, '\n', ' ');
+		text += std::format("{}\t{}\t{}\t{}\n", std::to_underlying(diagnostic.severity), diagnostic.line, diagnostic.file, message);
 	}
-	if (shader_code.value().empty()) {
-		LOG_ERROR("Compiled fragment shader file is empty.");
+	return text;
+}
+
+static auto ParseCachedDiagnostics(std::string_view text) -> std::vector<ShaderDiagnostic> {
+	std::vector<ShaderDiagnostic> diagnostics;
+	for (auto const range : std::views::split(text, '\n')) {
+		std::string_view line(range.begin(), range.end());
+		std::string_view fields[3];
+		for (std::string_view& field : fields) {
+			std::size_t const tab = line.find('\t');
+			field                 = line.substr(0, tab);
+			line.remove_prefix(tab == std::string_view::npos ? line.size() : tab + 1);
+		}
+		int severity = 0;
+		int number   = 0;
+		if (std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), severity).ec != std::errc{} ||
+			std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), number).ec != std::errc{}) continue;
+		diagnostics.push_back({
+			.severity = static_cast<ShaderDiagnosticSeverity>(std::clamp(severity, 0, std::to_underlying(ShaderDiagnosticSeverity::eNote))),
+			.file     = std::string(fields[2]),
+			.line     = number,
+			.message  = std::string(line),
+		});
+	}
+	return diagnostics;
+}
+
+auto MainAppImpl::GetShaderBuildContext() -> ShaderBuildContext {
+	return {
+		.compiler    = &shader_compiler,
+		.spv_path    = gGlobalData.user_fragment_spv_path,
+		.spec_values = build_spec_values,
+		.build_times = &last_shader_build,
+	};
+}
+
+// Buffer passes of the shader at path whose file exists and the image pass are built, nothing is kept
+// unless all succeed. Only touches state of the calling thread, the SPIR-V goes to compiled_shaders.
+bool MainAppImpl::TryCreateUserPasses(ShaderBuildContext const& context, std::filesystem::path const& path, PipelineBuildResult& result,
+									  std::vector<CompiledUserShader>& compiled_shaders) {
+	std::vector<CompiledUserShader> shaders;
+	auto                            Fail = [&] {
+		DestroyPipelines(result);
+		result.buffer_passes.clear();
+		compiled_shaders.clear();
 		return false;
+	};
+	// Collected also for a pass that fails, fixing an included file must rebuild it
+	result.dependencies.emplace();
+	auto const TryCreatePass = [&](std::string const& pass_path, vk::Format format, CompiledUserShader& shader, vk::Pipeline& pipeline) {
+		bool const bCreated = TryCreateUserPipeline(context, pass_path, format, shader, pipeline);
+		result.dependencies->append_range(context.compiler->GetDependencies());
+		return bCreated;
+	};
+	for (u32 buffer = 0; buffer < kBufferCount; ++buffer) {
+		std::filesystem::path const buffer_path = FragmentShaderManager::GetBufferPath(path, buffer);
+		std::error_code             error;
+		if (!std::filesystem::exists(buffer_path, error)) continue;
+		CompiledUserShader& shader = shaders.emplace_back(CompiledUserShader{.pass = {.buffer = buffer}});
+		BufferPass&         pass   = result.buffer_passes.emplace_back(BufferPass{.buffer = buffer});
+		if (!TryCreatePass(buffer_path.string(), kBufferFormat, shader, pass.pipeline)) return Fail();
+		pass.input_usage    = shader.pass.input_usage;
+		pass.workgroup_size = shader.pass.workgroup_size;
+	}
+	CompiledUserShader& shader = shaders.emplace_back();
+	if (!TryCreatePass(path.string(), color_format, shader, result.pipeline)) return Fail();
+	result.input_usage    = shader.pass.input_usage;
+	result.workgroup_size = shader.pass.workgroup_size;
+	result.spec_constants = CollectSpecConstants(shaders);
+	result.spec_values.assign(context.spec_values.begin(), context.spec_values.end());
+	compiled_shaders = std::move(shaders);
+	return true;
+}
+
+// Creates the pipelines of the last successful build again with build_spec_values, skipping the compiler
+bool MainAppImpl::RespecializeUserPasses(std::span<CompiledUserShader const> shaders, PipelineBuildResult& result) {
+	std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+	for (CompiledUserShader const& shader : shaders) {
+		bool const   bImagePass = &shader == &shaders.back();
+		vk::Pipeline pipeline;
+		if (vk::Result const vk_result = CreateUserPipeline(shader, build_spec_values, pipeline); vk_result != vk::Result::eSuccess) {
+			LOG_ERROR("Failed to specialize pipeline: %s", vk::to_string(vk_result).data());
+			DestroyPipelines(result);
+			return false;
+		}
+		if (bImagePass) {
+			result.pipeline       = pipeline;
+			result.input_usage    = shader.pass.input_usage;
+			result.workgroup_size = shader.pass.workgroup_size;
+		} else {
+			BufferPass pass = shader.pass;
+			pass.pipeline   = pipeline;
+			result.buffer_passes.push_back(pass);
+		}
+	}
+	result.spec_constants              = CollectSpecConstants(shaders);
+	result.spec_values                 = build_spec_values;
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+	LogVerbose("Specialized %zu pipelines in %.3f ms", shaders.size(), time.count() * 1000.0);
+	return true;
+}
+
+// Constants of all passes by id, the first pass declaring an id names it
+auto MainAppImpl::CollectSpecConstants(std::span<CompiledUserShader const> shaders) -> std::vector<SpecConstant> {
+	std::vector<SpecConstant> constants;
+	for (CompiledUserShader const& shader : shaders) {
+		for (SpecConstant const& constant : shader.spec_constants) {
+			if (std::ranges::none_of(constants, [&](SpecConstant const& other) { return other.id == constant.id; })) {
+				constants.push_back(constant);
+			}
+		}
+	}
+	return constants;
+}
+
+// Values are set for the constants the shader declares. Compute shaders that size their
+// workgroup with constants 0 and 1 get the selected size there.
+auto MainAppImpl::CreateUserPipeline(CompiledUserShader const& shader, std::span<SpecConstantValue const> spec_values, vk::Pipeline& pipeline) -> vk::Result {
+	std::vector<vk::SpecializationMapEntry> entries;
+	std::vector<u32>                        data;
+	auto                                    Add = [&](u32 id, u32 value) {
+		entries.push_back({.constantID = id, .offset = static_cast<u32>(data.size() * sizeof(u32)), .size = sizeof(u32)});
+		data.push_back(value);
+	};
+	for (SpecConstantValue const& value : spec_values) {
+		if (std::ranges::any_of(shader.spec_constants, [&](SpecConstant const& constant) { return constant.id == value.id; })) {
+			Add(value.id, value.value);
+		}
+	}
+	if (shader.bWorkgroupSpecialized) {
+		Add(0, shader.pass.workgroup_size.width);
+		Add(1, shader.pass.workgroup_size.height);
 	}
+	vk::SpecializationInfo const specialization_info{
+		.mapEntryCount = static_cast<u32>(entries.size()),
+		.pMapEntries   = entries.data(),
+		.dataSize      = data.size() * sizeof(u32),
+		.pData         = data.data(),
+	};
+	if (shader.pass.workgroup_size.width > 0) {
+		return CreateComputePipeline(shader.spirv, specialization_info, pipeline);
+	}
+	return CreatePipeline(std::as_bytes(std::span{shader.spirv}), shader.format, pipeline, &specialization_info);
+}
+
+// Fragment shaders draw in format, compute shaders (.comp) write the output binding and get a workgroup size
+bool MainAppImpl::TryCreateUserPipeline(ShaderBuildContext const& context, std::string const& path, vk::Format format, CompiledUserShader& shader,
+										vk::Pipeline& new_pipeline) {
+	TRACE_SCOPE("build_pass");
+	// Compile time covers everything until SPIR-V is in memory, including the file round trip of the external compiler
+	ShaderCompiler&                                compiler           = *context.compiler;
+	std::chrono::high_resolution_clock::time_point compile_start_time = std::chrono::high_resolution_clock::now();
+	std::optional<std::uint64_t>                   cache_key          = compiler.ComputeCacheKey(path, user_options.compile_options);
+	char const*                                    backend_name       = "cache";
+	shader.spirv.clear();
+	std::string cached_diagnostics;
+	if (cache_key.has_value()) {
+		std::lock_guard lock(shader_cache_mutex);
+		if (std::optional<ShaderCacheEntry> cached = shader_cache.Load(cache_key.value())) {
+			shader.spirv.assign(cached->spirv.begin(), cached->spirv.end());
+			cached_diagnostics = cached->diagnostics;
+		}
+	}
+	if (!shader.spirv.empty()) {
+		// Warnings of the build that was cached are shown again
+		LogShaderDiagnostics(ParseCachedDiagnostics(cached_diagnostics));
+	} else {
+		TRACE_SCOPE("compile");
+		std::optional<std::span<u32 const>> spirv = compiler.CompileShaderToSpirv(path, context.spv_path, user_options.compile_options);
+		backend_name                              = ShaderCompilerBackendToString(compiler.GetLastBackend());
+		LogShaderDiagnostics(compiler.GetDiagnostics());
+		if (!spirv.has_value()) {
+			if (compiler.GetDiagnostics().empty()) {
+				LOG_ERROR("Error: %s", compiler.GetErrorMessage().data());
+			}
+			return false;
+		}
+		if (spirv.value().empty()) {
+			LOG_ERROR("Compiled shader is empty.");
+			return false;
+		}
+		shader.spirv.assign(spirv.value().begin(), spirv.value().end());
+		if (cache_key.has_value()) {
+			std::lock_guard lock(shader_cache_mutex);
+			(void)shader_cache.Store(cache_key.value(), shader.spirv, FormatCachedDiagnostics(compiler.GetDiagnostics()));
+		}
+	}
+	std::chrono::duration<double> compile_time    = std::chrono::high_resolution_clock::now() - compile_start_time;
+	auto                          compile_time_ms = compile_time.count() * 1000.0f;
 
 	std::chrono::high_resolution_clock::time_point pipeline_start_time = std::chrono::high_resolution_clock::now();
 
-	vk::Pipeline                  new_pipeline;
-	vk::Result                    result           = CreatePipeline(shader_code.value(), new_pipeline);
+	shader.format         = format;
+	shader.spec_constants = ReflectSpecConstants(shader.spirv);
+	if (GetShaderStage(path) == ShaderStage::eCompute) {
+		ComputeWorkgroup const workgroup = ReflectComputeWorkgroup(shader.spirv);
+		shader.pass.workgroup_size       = SelectWorkgroupSize(workgroup);
+		shader.bWorkgroupSpecialized     = workgroup.bSpecializable;
+		if (workgroup.bSpecializable) {
+			std::erase_if(shader.spec_constants, [](SpecConstant const& constant) { return constant.id <= 1; });
+		}
+		LogVerbose("Compute workgroup size: %ux%u", shader.pass.workgroup_size.width, shader.pass.workgroup_size.height);
+	}
+	vk::Result const              result           = CreateUserPipeline(shader, context.spec_values, new_pipeline);
 	std::chrono::duration<double> pipeline_time    = std::chrono::high_resolution_clock::now() - pipeline_start_time;
 	auto                          pipeline_time_ms = pipeline_time.count() * 1000.0f;
 	// CHECK_RESULT(result);
 	if (result != vk::Result::eSuccess) {
 		return false;
 	}
-	CHECK_RESULT(device.waitIdle());
-	device.destroyPipeline(user_pipeline, GetAllocator());
-	user_pipeline = new_pipeline;
-	LogVerbose("Updated shader %s. Compilation time: %.3f ms. Pipeline creation time: %.3f ms",
-			   fragment_shader.path_string.data(), compile_time_ms, pipeline_time_ms);
+	shader.pass.input_usage            = ReflectFrameInputs(shader.spirv);
+	FrameInputUsage const& input_usage = shader.pass.input_usage;
+	if (context.build_times) {
+		*context.build_times = {.backend_name = backend_name, .compile_time_ms = static_cast<float>(compile_time_ms), .pipeline_time_ms = static_cast<float>(pipeline_time_ms)};
+	}
+	LogVerbose("Updated shader %s. Compilation time (%s): %.3f ms. Pipeline creation time: %.3f ms. Total: %.3f ms",
+			   path.data(), backend_name,
+			   compile_time_ms, pipeline_time_ms, compile_time_ms + pipeline_time_ms);
+	LogVerbose("Shader reads time: %s, frame: %s, mouse: %s", Utils::FormatBool(input_usage.bTime || input_usage.bTimeDelta).data(),
+			   Utils::FormatBool(input_usage.bFrame).data(), Utils::FormatBool(input_usage.bMouse).data());
 	return true;
 };
 
 void MainAppImpl::UpdateViewport(int width, int height) {
-	viewport        = {0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f};
-	viewport_flip_y = {0.0f, static_cast<float>(height), static_cast<float>(width), -static_cast<float>(height), 0.0f, 1.0f};
+	viewport = {0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f};
 
 	// if (user_options.bFlipY) {
 	// } else {
 	// }
 };
 
+auto MainAppImpl::GetScaledExtent(u32 width, u32 height) const -> vk::Extent2D {
+	float const scale = resolution_scaler.GetScale();
+	return {
+		std::max(1u, static_cast<u32>(std::lround(static_cast<float>(width) * scale))),
+		std::max(1u, static_cast<u32>(std::lround(static_cast<float>(height) * scale))),
+	};
+}
+
 void MainAppImpl::UpdateMouse(int x, int y, int height) {
 	if (user_options.bFlipY) {
 		mouse = {static_cast<float>(x), static_cast<float>(height) - y};
@@ -851,23 +2308,20 @@ void MainAppImpl::UpdateMouse(int x, int y, int height) {
 }
 
 void MainAppImpl::UpdateTime() {
-	auto      now    = std::chrono::high_resolution_clock::now();
-	auto      d_time = now - last_time;
-	long long d_ms   = std::chrono::duration_cast<std::chrono::milliseconds>(d_time).count();
-	last_time        = now;
+	auto      now   = std::chrono::high_resolution_clock::now();
+	long long d_mks = std::chrono::duration_cast<std::chrono::microseconds>(now - last_time).count();
+	last_time       = now;
 
-	time_delta = static_cast<double>(d_ms) / 1'000.0;
-	total_shader_time_mks += d_ms;
-	time = static_cast<double>(total_shader_time_mks) / 1'000.0;
-	// time       = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count()) / 1000.0;
-	// LogVerbose("Time: %f, delta: %f", time, time_delta);
+	time_delta = static_cast<float>(static_cast<double>(d_mks) / 1'000'000.0);
+	total_shader_time_mks += d_mks;
+	time = static_cast<float>(static_cast<double>(total_shader_time_mks) / 1'000'000.0);
 }
 
 void MainAppImpl::OnDrawWindow() {
 	auto HandleSwapchainResult = [this](vk::Result result) -> bool {
 		switch (result) {
 		case vk::Result::eSuccess:           return true;
-		case vk::Result::eErrorOutOfDateKHR: bSwapchainDirty = true; return false;
+		case vk::Result::eErrorOutOfDateKHR: bSwapchainDirty = bNeedsRedraw = true; return false;
 		case vk::Result::eSuboptimalKHR:     bSwapchainDirty = true; return true;
 		default:
 			CHECK_RESULT(result);
@@ -878,116 +2332,880 @@ void MainAppImpl::OnDrawWindow() {
 	int x, y, width, height;
 	window.GetRect(x, y, width, height);
 	if (width <= 0 || height <= 0) return;
+	BeginFramePhase();
+	if (bSwapchainDirty) {
+		RecreateSwapchain(width, height);
+	}
 	CHECK_RESULT(device.waitForFences(1, &swapchain.GetCurrentFence(), vk::True, std::numeric_limits<u32>::max()));
-	CHECK_RESULT(device.resetFences(1, &swapchain.GetCurrentFence()));
+	// Frame that last used this slot has finished, its timestamps are ready and retired objects can go
+	CollectGpuFrameTime(frame_timestamps[swapchain.GetCurrentFrameIndex()]);
+	swapchain.FlushCurrentDeletionQueue();
 	device.resetCommandPool(swapchain.GetCurrentCommandPool());
-	if (!HandleSwapchainResult(swapchain.AcquireNextImage())) return;
-	if (!bPaused) {
+	EndFramePhase(FramePhase::eWaitFence);
+	vk::Result const acquire_result = swapchain.AcquireNextImage();
+	EndFramePhase(FramePhase::eAcquire);
+	if (!HandleSwapchainResult(acquire_result)) return;
+	// Reset only once something will be submitted, the fence must signal again before the next wait
+	CHECK_RESULT(device.resetFences(1, &swapchain.GetCurrentFence()));
+	if (IsBenchmarking()) {
+		time       = static_cast<float>(frame_index) * user_options.time_step;
+		time_delta = user_options.time_step;
+	} else if (!bPaused) {
 		UpdateTime();
 	}
-	RecordCommands();
-	if (!HandleSwapchainResult(swapchain.SubmitAndPresent(queue, queue))) return;
+	vk::CommandBuffer const cmd = RecordCommands();
+	EndFramePhase(FramePhase::eRecord);
+	vk::Result const present_result = swapchain.SubmitAndPresent(queue, queue, cmd);
+	EndFramePhase(FramePhase::eSubmitPresent);
+	if (!HandleSwapchainResult(present_result)) return;
 	// LogVerbose("Window drawn");
 	++frame_index;
 }
 
-void MainAppImpl::RecordCommands() {
-	int x, y, width, height;
-	window.GetRect(x, y, width, height);
-	vk::Rect2D render_rect{0, 0, static_cast<u32>(width), static_cast<u32>(height)};
+// Returns the command buffer to submit for the current frame
+auto MainAppImpl::RecordCommands() -> vk::CommandBuffer {
+	// Window may have been resized since the swapchain was recreated for this frame
+	vk::Extent2D const extent        = swapchain.GetExtent();
+	vk::Extent2D const scaled_extent = GetScaledExtent(extent.width, extent.height);
+
+	u32 const frame_slot                     = swapchain.GetCurrentFrameIndex();
+	frame_timestamps[frame_slot].frame_index = frame_index;
+	frame_timestamps[frame_slot].tile_pixels = 0;
+	WriteFrameUniforms(frame_slot, scaled_extent.width, scaled_extent.height);
+	// Render graph images swap every frame, buffers recorded once would keep drawing into the same ones
+	if (user_options.bPrerecord && !UsesRenderGraph(extent, scaled_extent) && !IsTiled()) {
+		return GetPrerecordedCommands(extent.width, extent.height);
+	}
 
 	VulkanRHI::CommandBuffer cmd = swapchain.GetCurrentCommandBuffer();
 	CHECK_RESULT(cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit}));
-	vk::Image swapchain_image = swapchain.GetCurrentImage();
-	if (user_options.bFlipY || current_pipeline == &fallback_pipeline) {
-		cmd.setViewport(0, {viewport_flip_y});
+	RecordSwapchainImageCommands(cmd, frame_slot, extent, scaled_extent);
+	CHECK_RESULT(cmd.end());
+	return cmd;
+}
+
+// Renders into the current swapchain image, through the render graph with buffer passes, a compute
+// shader or a scaled extent, and transitions it for presenting
+void MainAppImpl::RecordSwapchainImageCommands(VulkanRHI::CommandBuffer cmd, u32 frame_slot, vk::Extent2D extent, vk::Extent2D scaled_extent) {
+	VulkanRHI::TimestampQueryPool& timestamps = frame_timestamps[frame_slot].pool;
+	timestamps.Reset(cmd);
+	vk::Image const                  swapchain_image = swapchain.GetCurrentImage();
+	VulkanRHI::RenderGraphImageState image_state{
+		.layout = vk::ImageLayout::eColorAttachmentOptimal,
+		.stage  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		.access = vk::AccessFlagBits2::eColorAttachmentWrite,
+	};
+	if (IsTiled()) {
+		timestamps.Write(cmd, vk::PipelineStageFlagBits2::eTopOfPipe, 0);
+		image_state = RecordTiledCommands(cmd, frame_slot, extent, scaled_extent);
+	} else if (UsesRenderGraph(extent, scaled_extent)) {
+		timestamps.Write(cmd, vk::PipelineStageFlagBits2::eTopOfPipe, 0);
+		RecordRenderGraph(cmd, swapchain_image, swapchain.GetCurrentImageView(), frame_slot, scaled_extent, extent);
+		image_state = render_graph.GetImageState(render_graph_output);
 	} else {
-		cmd.setViewport(0, {viewport});
+		cmd.Barrier({
+			.image         = swapchain_image,
+			.aspectMask    = vk::ImageAspectFlagBits::eColor,
+			.oldLayout     = vk::ImageLayout::eUndefined,
+			.newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
+			.srcStageMask  = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+		});
+		timestamps.Write(cmd, vk::PipelineStageFlagBits2::eTopOfPipe, 0);
+		RecordDraw(cmd, {
+			.image_view   = swapchain.GetCurrentImageView(),
+			.pipeline     = *current_pipeline,
+			.bFlipY       = IsFlipY(),
+			.uniform_slot = frame_slot,
+			.width        = extent.width,
+			.height       = extent.height,
+		});
 	}
-	cmd.SetScissor(render_rect);
+	timestamps.Write(cmd, vk::PipelineStageFlagBits2::eBottomOfPipe, 1);
+	cmd.Barrier({
+		.image         = swapchain_image,
+		.aspectMask    = vk::ImageAspectFlagBits::eColor,
+		.oldLayout     = image_state.layout,
+		.newLayout     = vk::ImageLayout::ePresentSrcKHR,
+		.srcStageMask  = image_state.stage,
+		.srcAccessMask = image_state.access,
+		.dstStageMask  = vk::PipelineStageFlagBits2::eNone,
+		.dstAccessMask = vk::AccessFlagBits2::eNone,
+	});
+}
+
+void MainAppImpl::CreatePrerecordedCommandPool() {
+	vk::CommandPoolCreateInfo pool_info{
+		.flags            = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		.queueFamilyIndex = queue_family_index,
+	};
+	CHECK_RESULT(device.createCommandPool(&pool_info, GetAllocator(), &prerecorded_command_pool));
+}
+
+// Command buffer of the current frame slot and image, recorded again if the pipeline, flip, image or size changed.
+// Only buffers of this slot are touched, its previous submission has completed.
+auto MainAppImpl::GetPrerecordedCommands(u32 width, u32 height) -> vk::CommandBuffer {
+	u32 const frame_slot = swapchain.GetCurrentFrameIndex();
+	prerecorded_commands.resize(swapchain.GetFrameData().size());
+	std::vector<PrerecordedCommands>& slot_commands = prerecorded_commands[frame_slot];
+	if (slot_commands.size() < swapchain.GetImageCount()) {
+		std::vector<vk::CommandBuffer> new_buffers(swapchain.GetImageCount() - slot_commands.size());
+		vk::CommandBufferAllocateInfo  alloc_info{
+			.commandPool        = prerecorded_command_pool,
+			.level              = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = static_cast<u32>(new_buffers.size()),
+		};
+		CHECK_RESULT(device.allocateCommandBuffers(&alloc_info, new_buffers.data()));
+		for (vk::CommandBuffer new_buffer : new_buffers) {
+			slot_commands.push_back({.cmd = new_buffer});
+		}
+	}
+
+	PrerecordedCommands& commands = slot_commands[swapchain.GetCurrentImageIndex()];
+	vk::Extent2D const   extent{width, height};
+	bool const           bFlipY = IsFlipY();
+	if (commands.generation == prerecorded_generation && commands.extent == extent && commands.bFlipY == bFlipY) {
+		return commands.cmd;
+	}
+	commands.generation = prerecorded_generation;
+	commands.extent     = extent;
+	commands.bFlipY     = bFlipY;
+
+	VulkanRHI::CommandBuffer cmd = commands.cmd;
+	CHECK_RESULT(cmd.begin({}));
+	RecordSwapchainImageCommands(cmd, frame_slot, extent, extent);
+	CHECK_RESULT(cmd.end());
+	return cmd;
+}
+
+// Frames in flight may still blit from the old images
+void MainAppImpl::CreateTiledImages(vk::Extent2D extent) {
+	for (TiledImage& tiled_image : tiled_images) {
+		tiled_image.image.DestroyDeferred(swapchain.GetDeferredDeletionQueue());
+		CHECK_RESULT(tiled_image.image.Create(device, physical_device,
+											  {
+												  .extent = extent,
+												  .format = color_format,
+												  .usage  = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+											  },
+											  GetAllocator()));
+		tiled_image.layout = vk::ImageLayout::eUndefined;
+	}
+	tiled_draw_index = 0;
+	bTiledPassActive = false;
+	bTiledComplete   = false;
+	LogVerbose("Tiled images: %ux%u", extent.width, extent.height);
+}
+
+// Draws the next tiles and blits the last complete image to the swapchain image, or the one being drawn
+// until the first completes. Returns the last access of the swapchain image.
+auto MainAppImpl::RecordTiledCommands(VulkanRHI::CommandBuffer cmd, u32 frame_slot, vk::Extent2D extent, vk::Extent2D scaled_extent)
+	-> VulkanRHI::RenderGraphImageState {
+	auto const Transition = [cmd](TiledImage& tiled_image, vk::ImageLayout layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access) {
+		bool const bAttachment = tiled_image.layout == vk::ImageLayout::eColorAttachmentOptimal;
+		cmd.Barrier({
+			.image         = tiled_image.image,
+			.aspectMask    = vk::ImageAspectFlagBits::eColor,
+			.oldLayout     = tiled_image.layout,
+			.newLayout     = layout,
+			.srcStageMask  = bAttachment ? vk::PipelineStageFlagBits2::eColorAttachmentOutput : vk::PipelineStageFlagBits2::eBlit,
+			.srcAccessMask = bAttachment ? vk::AccessFlagBits2::eColorAttachmentWrite : vk::AccessFlagBits2::eNone,
+			.dstStageMask  = stage,
+			.dstAccessMask = access,
+		});
+		tiled_image.layout = layout;
+	};
+
+	if (tiled_images[0].image.GetExtent() != scaled_extent) {
+		CreateTiledImages(scaled_extent);
+	}
+	TiledImage& draw_image = tiled_images[tiled_draw_index];
+	bool const  bNewPass   = !bTiledPassActive || tiled_pipeline != *current_pipeline;
+	if (bNewPass) {
+		if (tiled_pipeline != *current_pipeline) {
+			tile_scheduler.ResetEstimate();
+		}
+		tiled_pipeline   = *current_pipeline;
+		tiled_constants  = GetFrameConstants(scaled_extent.width, scaled_extent.height);
+		bTiledPassActive = true;
+		tile_scheduler.Restart(scaled_extent.width, scaled_extent.height);
+		// Contents are replaced by the tiles, or cleared when they are shown before the pass completes
+		draw_image.layout = vk::ImageLayout::eUndefined;
+	}
+	WriteFrameUniforms(frame_slot, tiled_constants);
+
+	frame_tiles.clear();
+	frame_timestamps[frame_slot].tile_pixels = tile_scheduler.NextTiles(frame_tiles);
+	frame_scissors.clear();
+	for (Tile const& tile : frame_tiles) {
+		frame_scissors.push_back({
+			.offset = {static_cast<std::int32_t>(tile.x), static_cast<std::int32_t>(tile.y)},
+			.extent = {tile.width, tile.height},
+		});
+	}
+	Transition(draw_image, vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			   vk::AccessFlagBits2::eColorAttachmentWrite);
+	if (bNewPass && !bTiledComplete) {
+		cmd.BeginRendering({
+			.renderArea       = {{0, 0}, scaled_extent},
+			.colorAttachments = {{{
+				.imageView   = draw_image.image.GetView(),
+				.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+				.loadOp      = vk::AttachmentLoadOp::eClear,
+				.storeOp     = vk::AttachmentStoreOp::eStore,
+			}}},
+		});
+		cmd.endRendering();
+	}
+	RecordDraw(cmd, {
+		.image_view   = draw_image.image.GetView(),
+		.pipeline     = *current_pipeline,
+		.bFlipY       = IsFlipY(),
+		.uniform_slot = frame_slot,
+		.width        = scaled_extent.width,
+		.height       = scaled_extent.height,
+		.scissors     = frame_scissors,
+		.constants    = &tiled_constants,
+	});
+
+	// A completed image is shown from this frame on, the other one is drawn into next
+	bool const  bPassComplete = tile_scheduler.IsComplete();
+	TiledImage& shown_image   = bPassComplete || !bTiledComplete ? draw_image : tiled_images[1 - tiled_draw_index];
+	if (bPassComplete) {
+		tiled_draw_index = 1 - tiled_draw_index;
+		bTiledPassActive = false;
+		bTiledComplete   = true;
+	}
+	if (shown_image.layout != vk::ImageLayout::eTransferSrcOptimal) {
+		Transition(shown_image, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead);
+	}
+	vk::Image const swapchain_image = swapchain.GetCurrentImage();
 	cmd.Barrier({
 		.image         = swapchain_image,
 		.aspectMask    = vk::ImageAspectFlagBits::eColor,
 		.oldLayout     = vk::ImageLayout::eUndefined,
-		.newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
+		.newLayout     = vk::ImageLayout::eTransferDstOptimal,
 		.srcStageMask  = vk::PipelineStageFlagBits2::eNone,
 		.srcAccessMask = vk::AccessFlagBits2::eNone,
-		.dstStageMask  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-		.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+		.dstStageMask  = vk::PipelineStageFlagBits2::eBlit,
+		.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
 	});
+	vk::Extent2D const               src_extent = shown_image.image.GetExtent();
+	vk::ImageSubresourceLayers const subresource{.aspectMask = vk::ImageAspectFlagBits::eColor, .layerCount = 1};
+	vk::ImageBlit const              region{
+		.srcSubresource = subresource,
+		.srcOffsets     = {{vk::Offset3D{}, vk::Offset3D{static_cast<std::int32_t>(src_extent.width), static_cast<std::int32_t>(src_extent.height), 1}}},
+		.dstSubresource = subresource,
+		.dstOffsets     = {{vk::Offset3D{}, vk::Offset3D{static_cast<std::int32_t>(extent.width), static_cast<std::int32_t>(extent.height), 1}}},
+	};
+	cmd.blitImage(shown_image.image, vk::ImageLayout::eTransferSrcOptimal, swapchain_image, vk::ImageLayout::eTransferDstOptimal, 1, &region,
+				  vk::Filter::eLinear);
+	return {
+		.layout = vk::ImageLayout::eTransferDstOptimal,
+		.stage  = vk::PipelineStageFlagBits2::eBlit,
+		.access = vk::AccessFlagBits2::eTransferWrite,
+	};
+}
+
+void MainAppImpl::RecordDraw(VulkanRHI::CommandBuffer cmd, DrawInfo const& info) {
+	vk::Rect2D const   render_rect{0, 0, info.width, info.height};
+	float const        width         = static_cast<float>(info.width);
+	float const        height        = static_cast<float>(info.height);
+	vk::Viewport const draw_viewport = info.bFlipY ? vk::Viewport{0.0f, height, width, -height, 0.0f, 1.0f}
+												   : vk::Viewport{0.0f, 0.0f, width, height, 0.0f, 1.0f};
+	cmd.setViewport(0, {draw_viewport});
 	cmd.BeginRendering({
 		.renderArea       = render_rect,
 		.colorAttachments = {{{
-			.imageView   = swapchain.GetCurrentImageView(),
+			.imageView   = info.image_view,
 			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
 		}}},
 	});
-	cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *current_pipeline);
-	// cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
-	PushConstants constants{
-		.resolution = {static_cast<float>(width), static_cast<float>(height)},
-		// .mouse      = {mouse.x, mouse.y},
-		.mouse      = {mouse.x, user_options.bFlipY ? height - mouse.y : mouse.y},
-		.time       = time,
-		.time_delta = time_delta,
-		.frame      = frame_index,
-	};
-	cmd.pushConstants(pipeline_layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(constants), &constants);
+	cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, info.pipeline);
+	u32 const uniform_offset = static_cast<u32>(info.uniform_slot * frame_uniforms_stride);
+	cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 0, 1, &descriptor_set, 1, &uniform_offset);
+	if (info.channel_set) {
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 1, 1, &info.channel_set, 0, nullptr);
+	}
+	// Prerecorded command buffers keep the values of when they were recorded, resolution stays valid
+	PushConstants const constants = info.constants ? *info.constants : GetFrameConstants(info.width, info.height);
+	cmd.pushConstants(pipeline_layout, kUserShaderStages, 0, sizeof(constants), &constants);
 	// vk::DeviceSize offsets[] = {0};
 	// cmd.bindVertexBuffers(0, 1, &vertex_buffer, offsets);
-	cmd.draw(6, 1, 0, 0);
+	if (info.scissors.empty()) {
+		cmd.SetScissor(render_rect);
+		cmd.draw(6, 1, 0, 0);
+	}
+	for (vk::Rect2D const& scissor : info.scissors) {
+		cmd.SetScissor(scissor);
+		cmd.draw(6, 1, 0, 0);
+	}
 	cmd.endRendering();
-	cmd.Barrier({
-		.image         = swapchain_image,
-		.aspectMask    = vk::ImageAspectFlagBits::eColor,
-		.oldLayout     = vk::ImageLayout::eColorAttachmentOptimal,
-		.newLayout     = vk::ImageLayout::ePresentSrcKHR,
-		.srcStageMask  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-		.srcAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
-		.dstStageMask  = vk::PipelineStageFlagBits2::eNone,
-		.dstAccessMask = vk::AccessFlagBits2::eNone,
-	});
+}
+
+// Covers width x height with workgroups, invocations past the edge must not write
+void MainAppImpl::RecordDispatch(VulkanRHI::CommandBuffer cmd, DrawInfo const& info) {
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, info.pipeline);
+	u32 const uniform_offset = static_cast<u32>(info.uniform_slot * frame_uniforms_stride);
+	cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout, 0, 1, &descriptor_set, 1, &uniform_offset);
+	cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout, 1, 1, &info.channel_set, 0, nullptr);
+	PushConstants const constants = GetFrameConstants(info.width, info.height);
+	cmd.pushConstants(pipeline_layout, kUserShaderStages, 0, sizeof(constants), &constants);
+	cmd.dispatch((info.width + info.workgroup_size.width - 1) / info.workgroup_size.width,
+				 (info.height + info.workgroup_size.height - 1) / info.workgroup_size.height, 1);
+}
+
+// Declares Buffer A-D and the image pass, drawn at extent, and a blit to the output when it is larger
+// or the image pass is a compute shader. Run again when the passes or a size change, frames in flight
+// keep the old images and descriptor sets until they complete.
+void MainAppImpl::BuildRenderGraph(vk::Extent2D extent, vk::Extent2D output_extent) {
+	if (user_options.bHeadless) {
+		render_graph.Reset();
+		device.destroyDescriptorPool(channel_descriptor_pool, GetAllocator());
+	} else {
+		render_graph.Reset(swapchain.GetDeferredDeletionQueue());
+		swapchain.DestroyDeferred(channel_descriptor_pool);
+	}
+	channel_descriptor_pool    = vk::DescriptorPool{};
+	render_graph_extent        = extent;
+	render_graph_output_extent = output_extent;
+	bRenderGraphDirty          = false;
+
+	// Buffers without a pass are never written and read as zero
+	std::array<int, kBufferCount> buffer_pass_index;
+	buffer_pass_index.fill(-1);
+	for (std::size_t pass = 0; pass < buffer_passes.size(); ++pass) {
+		buffer_pass_index[buffer_passes[pass].buffer] = static_cast<int>(pass);
+	}
+	std::array<VulkanRHI::RenderGraphImage, kBufferCount> buffers;
+	for (u32 buffer = 0; buffer < kBufferCount; ++buffer) {
+		buffers[buffer] = render_graph.AddImage({
+			.name   = std::format("Buffer {:c}", 'A' + buffer),
+			.extent = buffer_pass_index[buffer] >= 0 ? extent : vk::Extent2D{1, 1},
+			.format = kBufferFormat,
+		});
+	}
+	// Compute shaders write a storage image, the output format usually can not be one
+	bool const bComputeImage = IsComputeShader();
+	bool const bBlit         = extent != output_extent || bComputeImage;
+
+	render_graph_output               = render_graph.AddImage({.name = "Output", .extent = output_extent, .format = color_format, .bExternal = true});
+	VulkanRHI::RenderGraphImage image = render_graph_output;
+	if (bBlit) {
+		image = render_graph.AddImage({.name = "Image", .extent = extent, .format = bComputeImage ? kBufferFormat : color_format});
+	}
+
+	// Set 1 of every pass for both parities, bindings of unsampled channels are left unwritten
+	u32 const                                   pass_count = static_cast<u32>(buffer_passes.size() + 1);
+	std::array<vk::DescriptorPoolSize, 2> const pool_sizes{{
+		{.type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = pass_count * 2 * kBufferCount},
+		{.type = vk::DescriptorType::eStorageImage, .descriptorCount = pass_count * 2},
+	}};
+	vk::DescriptorPoolCreateInfo const pool_info{
+		.maxSets       = pass_count * 2,
+		.poolSizeCount = static_cast<u32>(pool_sizes.size()),
+		.pPoolSizes    = pool_sizes.data(),
+	};
+	CHECK_RESULT(device.createDescriptorPool(&pool_info, GetAllocator(), &channel_descriptor_pool));
+	std::vector<vk::DescriptorSetLayout> const set_layouts(pass_count * 2, channel_set_layout);
+	vk::DescriptorSetAllocateInfo const        alloc_info{
+		.descriptorPool     = channel_descriptor_pool,
+		.descriptorSetCount = static_cast<u32>(set_layouts.size()),
+		.pSetLayouts        = set_layouts.data(),
+	};
+	channel_sets.resize(set_layouts.size());
+	CHECK_RESULT(device.allocateDescriptorSets(&alloc_info, channel_sets.data()));
+
+	std::vector<std::vector<VulkanRHI::RenderGraphInput>> pass_inputs(pass_count);
+	std::vector<VulkanRHI::RenderGraphImage>              pass_outputs(pass_count);
+	std::vector<vk::Extent2D>                             pass_workgroup_sizes(pass_count);
+	for (u32 pass = 0; pass < pass_count; ++pass) {
+		bool const bImagePass   = pass == buffer_passes.size();
+		u32 const  channel_mask = bImagePass ? shader_input_usage.channel_mask : buffer_passes[pass].input_usage.channel_mask;
+		for (u32 channel = 0; channel < kBufferCount; ++channel) {
+			if (!(channel_mask & (1u << channel))) continue;
+			bool const bPrevious = buffer_pass_index[channel] >= static_cast<int>(pass);
+			pass_inputs[pass].push_back({
+				.image = buffers[channel],
+				.read  = bPrevious ? VulkanRHI::RenderGraphRead::ePrevious : VulkanRHI::RenderGraphRead::eCurrent,
+			});
+		}
+		// Zero for fragment passes, the fallback pipeline is one
+		vk::Extent2D const workgroup_size = bImagePass ? (bComputeImage ? image_workgroup_size : vk::Extent2D{}) : buffer_passes[pass].workgroup_size;
+		vk::Pipeline const pipeline       = bImagePass ? *current_pipeline : buffer_passes[pass].pipeline;
+		pass_outputs[pass]                = bImagePass ? image : buffers[buffer_passes[pass].buffer];
+		pass_workgroup_sizes[pass]        = workgroup_size;
+		render_graph.AddPass({
+			.name    = bImagePass ? "Image" : std::format("Buffer {:c}", 'A' + buffer_passes[pass].buffer),
+			.inputs  = pass_inputs[pass],
+			.outputs = {pass_outputs[pass]},
+			.record  = [this, pipeline, pass, bImagePass, workgroup_size](VulkanRHI::RenderGraphPassContext const& context) {
+				DrawInfo const info{
+					.image_view     = context.output_views[0],
+					.pipeline       = pipeline,
+					.channel_set    = channel_sets[pass * 2 + context.parity],
+					.workgroup_size = workgroup_size,
+					.bFlipY         = bImagePass && IsFlipY(),
+					.uniform_slot   = render_graph_uniform_slot,
+					.width          = context.extent.width,
+					.height         = context.extent.height,
+				};
+				if (workgroup_size.width > 0) {
+					RecordDispatch(context.cmd, info);
+				} else {
+					RecordDraw(context.cmd, info);
+				}
+			},
+			.type    = workgroup_size.width > 0 ? VulkanRHI::RenderGraphPassType::eCompute : VulkanRHI::RenderGraphPassType::eGraphics,
+		});
+	}
+	if (bBlit) {
+		// Compute shaders write rows top to bottom, flipped here like fragment shaders are by the viewport
+		bool const bFlipY = bComputeImage && IsFlipY();
+		render_graph.AddPass({
+			.name    = "Blit",
+			.inputs  = {{.image = image}},
+			.outputs = {render_graph_output},
+			.record  = [extent, bFlipY](VulkanRHI::RenderGraphPassContext const& context) {
+				std::int32_t const               width  = static_cast<std::int32_t>(context.extent.width);
+				std::int32_t const               height = static_cast<std::int32_t>(context.extent.height);
+				vk::Offset3D const               src_end{static_cast<std::int32_t>(extent.width), static_cast<std::int32_t>(extent.height), 1};
+				vk::ImageSubresourceLayers const subresource{.aspectMask = vk::ImageAspectFlagBits::eColor, .layerCount = 1};
+				vk::ImageBlit const              region{
+					.srcSubresource = subresource,
+					.srcOffsets     = {{vk::Offset3D{}, src_end}},
+					.dstSubresource = subresource,
+					.dstOffsets     = {{vk::Offset3D{0, bFlipY ? height : 0, 0}, vk::Offset3D{width, bFlipY ? 0 : height, 1}}},
+				};
+				context.cmd.blitImage(context.input_images[0], vk::ImageLayout::eTransferSrcOptimal,
+									  context.output_images[0], vk::ImageLayout::eTransferDstOptimal, 1, &region, vk::Filter::eLinear);
+			},
+			.type    = VulkanRHI::RenderGraphPassType::eTransfer,
+		});
+	}
+	CHECK_RESULT(render_graph.Compile(device, physical_device, GetAllocator()));
+
+	std::vector<vk::DescriptorImageInfo> image_infos;
+	std::vector<vk::WriteDescriptorSet>  writes;
+	image_infos.reserve(pass_count * 2 * (kBufferCount + 1));
+	for (u32 pass = 0; pass < pass_count; ++pass) {
+		for (u32 parity = 0; parity < 2; ++parity) {
+			for (VulkanRHI::RenderGraphInput const& input : pass_inputs[pass]) {
+				image_infos.push_back({
+					.sampler     = channel_sampler,
+					.imageView   = render_graph.GetView(input, parity),
+					.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+				});
+				writes.push_back({
+					.dstSet          = channel_sets[pass * 2 + parity],
+					.dstBinding      = static_cast<u32>(std::ranges::find(buffers, input.image) - buffers.begin()),
+					.descriptorCount = 1,
+					.descriptorType  = vk::DescriptorType::eCombinedImageSampler,
+					.pImageInfo      = &image_infos.back(),
+				});
+			}
+			if (pass_workgroup_sizes[pass].width == 0) continue;
+			image_infos.push_back({
+				.imageView   = render_graph.GetView({.image = pass_outputs[pass]}, parity),
+				.imageLayout = vk::ImageLayout::eGeneral,
+			});
+			writes.push_back({
+				.dstSet          = channel_sets[pass * 2 + parity],
+				.dstBinding      = kOutputBinding,
+				.descriptorCount = 1,
+				.descriptorType  = vk::DescriptorType::eStorageImage,
+				.pImageInfo      = &image_infos.back(),
+			});
+		}
+	}
+	device.updateDescriptorSets(static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
+	LogVerbose("Render graph: %zu passes, %zu images in %zu allocations, %ux%u to %ux%u", render_graph.GetPassCount(),
+			   render_graph.GetImageCount(), render_graph.GetCreatedImageCount(), extent.width, extent.height,
+			   output_extent.width, output_extent.height);
+}
+
+// Draws all passes at extent into image of output_extent. Its last access is render_graph.GetImageState(render_graph_output),
+// eColorAttachmentOptimal after a fragment image pass or eTransferDstOptimal after a blit.
+void MainAppImpl::RecordRenderGraph(VulkanRHI::CommandBuffer cmd, vk::Image image, vk::ImageView view, u32 uniform_slot,
+									vk::Extent2D extent, vk::Extent2D output_extent) {
+	if (bRenderGraphDirty || render_graph_extent != extent || render_graph_output_extent != output_extent) {
+		BuildRenderGraph(extent, output_extent);
+	}
+	render_graph.SetExternalImage(render_graph_output, image, view);
+	render_graph_uniform_slot = uniform_slot;
+	render_graph.Execute(cmd);
+}
+
+void MainAppImpl::RecordOffscreenCommands(OffscreenTarget& target, bool bReadback) {
+	VulkanRHI::CommandBuffer cmd = target.command_buffer;
+	CHECK_RESULT(cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit}));
+	bool const bRenderGraph = UsesRenderGraph(render_extent, render_extent);
+	if (!bRenderGraph) {
+		cmd.Barrier({
+			.image         = target.image,
+			.aspectMask    = vk::ImageAspectFlagBits::eColor,
+			.oldLayout     = vk::ImageLayout::eUndefined,
+			.newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
+			.srcStageMask  = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+		});
+	}
+	target.timestamps.frame_index = frame_index;
+	target.timestamps.pool.Reset(cmd);
+	target.timestamps.pool.Write(cmd, vk::PipelineStageFlagBits2::eTopOfPipe, 0);
+	u32 const target_slot = static_cast<u32>(&target - offscreen_targets.data());
+	WriteFrameUniforms(target_slot, render_extent.width, render_extent.height);
+	VulkanRHI::RenderGraphImageState image_state{
+		.layout = vk::ImageLayout::eColorAttachmentOptimal,
+		.stage  = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		.access = vk::AccessFlagBits2::eColorAttachmentWrite,
+	};
+	if (bRenderGraph) {
+		RecordRenderGraph(cmd, target.image, target.image.GetView(), target_slot, render_extent, render_extent);
+		image_state = render_graph.GetImageState(render_graph_output);
+	} else {
+		RecordDraw(cmd, {
+			.image_view   = target.image.GetView(),
+			.pipeline     = *current_pipeline,
+			.bFlipY       = IsFlipY(),
+			.uniform_slot = target_slot,
+			.width        = render_extent.width,
+			.height       = render_extent.height,
+		});
+	}
+	target.timestamps.pool.Write(cmd, vk::PipelineStageFlagBits2::eBottomOfPipe, 1);
+	if (bReadback) {
+		cmd.Barrier({
+			.image         = target.image,
+			.aspectMask    = vk::ImageAspectFlagBits::eColor,
+			.oldLayout     = image_state.layout,
+			.newLayout     = vk::ImageLayout::eTransferSrcOptimal,
+			.srcStageMask  = image_state.stage,
+			.srcAccessMask = image_state.access,
+			.dstStageMask  = vk::PipelineStageFlagBits2::eCopy,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+		});
+		vk::BufferImageCopy region{
+			.bufferOffset      = 0,
+			.bufferRowLength   = 0, // tightly packed
+			.bufferImageHeight = 0,
+			.imageSubresource  = {.aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1},
+			.imageOffset       = {0, 0, 0},
+			.imageExtent       = {render_extent.width, render_extent.height, 1},
+		};
+		cmd.copyImageToBuffer(target.image, vk::ImageLayout::eTransferSrcOptimal, target.readback, 1, &region);
+		cmd.Barrier(VulkanRHI::BufferBarrier{
+			.buffer        = target.readback,
+			.srcStageMask  = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask  = vk::PipelineStageFlagBits2::eHost,
+			.dstAccessMask = vk::AccessFlagBits2::eHostRead,
+		});
+	}
 	CHECK_RESULT(cmd.end());
 }
 
-void MainAppImpl::RecreateSwapchain(int width, int height) {
-	for (auto& frame : swapchain.GetFrameData()) {
-		CHECK_RESULT(device.waitForFences(1, &frame.GetFence(), vk::True, std::numeric_limits<u32>::max()));
+// Waits for the frame in target and hands its readback to frame_exporter if it is saved
+void MainAppImpl::RetireOffscreenTarget(OffscreenTarget& target) {
+	TRACE_SCOPE("retire_frame");
+	CHECK_RESULT(device.waitForFences(1, &target.fence, vk::True, std::numeric_limits<std::uint64_t>::max()));
+	CollectGpuFrameTime(target.timestamps);
+	if (target.pending_frame < 0) {
+		return;
+	}
+	int const frame = std::exchange(target.pending_frame, -1);
+	CHECK_RESULT(target.readback.Invalidate());
+	ImageWriter::ImageData const image{
+		.width        = render_extent.width,
+		.height       = render_extent.height,
+		.pixel_format = readback_format,
+		.pixels       = target.readback.GetMappedData(),
+	};
+	frame_exporter.Submit(static_cast<u32>(&target - offscreen_targets.data()), image, frame_exporter.IsStream() ? std::string{} : frame_output.GetPath(frame));
+}
+
+// Renders frame_count frames at a fixed time step. Frame i is retired after frame i + 1 is submitted,
+// so the GPU always has work queued, and encoding and file IO run on the export threads.
+// Rendering only waits when every readback buffer is still being encoded.
+void MainAppImpl::RunHeadless() {
+	if (current_pipeline != &user_pipeline) {
+		LOG_ERROR("Failed to build %s, nothing rendered", fragment_shader.path_string.data());
+		exit_code = 1;
+		return;
+	}
+
+	bool const bStream      = ImageWriter::GetFileFormat(user_options.output_path) == ImageWriter::ImageFileFormat::eY4M;
+	u32 const  fps_scale    = 1000;
+	u32 const  thread_count = user_options.export_threads > 0 ? static_cast<u32>(user_options.export_threads)
+															  : std::clamp(std::thread::hardware_concurrency(), 1u, kMaxExportThreads);
+	// Header frame rate stays a positive rational for any time step
+	long long const fps_numerator = std::clamp(std::llround(fps_scale / static_cast<double>(user_options.time_step)), 1ll,
+											   static_cast<long long>(std::numeric_limits<u32>::max()));
+	FrameExporterInfo const export_info{
+		.thread_count    = thread_count,
+		.slot_count      = static_cast<u32>(offscreen_targets.size()),
+		.stream_path     = bStream ? std::string(user_options.output_path) : std::string{},
+		.width           = render_extent.width,
+		.height          = render_extent.height,
+		.fps_numerator   = static_cast<u32>(fps_numerator),
+		.fps_denominator = fps_scale,
+	};
+	if (!frame_exporter.Start(export_info)) {
+		LOG_ERROR("Failed to open %s", export_info.stream_path.data());
+		exit_code = 1;
+		return;
+	}
+
+	std::chrono::high_resolution_clock::time_point const render_start_time = std::chrono::high_resolution_clock::now();
+	OffscreenTarget*                                     previous_target   = nullptr;
+	for (int frame = 0; frame < user_options.frame_count; ++frame) {
+		u32 const        slot             = static_cast<u32>(frame % offscreen_targets.size());
+		OffscreenTarget& target           = offscreen_targets[slot];
+		auto const       frame_start_time = std::chrono::steady_clock::now();
+		{
+			TRACE_SCOPE("wait_slot");
+			frame_exporter.WaitForSlot(slot);
+			CHECK_RESULT(device.waitForFences(1, &target.fence, vk::True, std::numeric_limits<std::uint64_t>::max()));
+		}
+		CHECK_RESULT(device.resetFences(1, &target.fence));
+		device.resetCommandPool(target.command_pool);
+
+		time        = static_cast<float>(frame) * user_options.time_step;
+		time_delta  = user_options.time_step;
+		frame_index = frame;
+
+		bool const bSave = frame_output.IsSaved(frame);
+		{
+			TRACE_SCOPE("record");
+			RecordOffscreenCommands(target, bSave);
+		}
+		vk::CommandBufferSubmitInfo command_buffer_info{.commandBuffer = target.command_buffer};
+		vk::SubmitInfo2             submit_info{
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos    = &command_buffer_info,
+		};
+		{
+			TRACE_SCOPE("submit");
+			CHECK_RESULT(queue.submit2(1, &submit_info, target.fence));
+		}
+		target.pending_frame = bSave ? frame : -1;
+		if (previous_target) {
+			RetireOffscreenTarget(*previous_target);
+		}
+		previous_target = &target;
+		benchmark.AddCpuFrameTime(frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start_time).count());
 	}
+	if (previous_target) {
+		RetireOffscreenTarget(*previous_target);
+	}
+	if (!frame_exporter.Finish()) {
+		for (std::string const& path : frame_exporter.GetFailedPaths()) {
+			LOG_ERROR("Failed to write %s", path.data());
+		}
+		exit_code = 1;
+	}
+
+	std::chrono::duration<double> const render_time = std::chrono::high_resolution_clock::now() - render_start_time;
+	LogVerbose("Headless: %d frames, %u saved in %.3f ms on %u export threads", user_options.frame_count,
+			   frame_exporter.GetWrittenCount(), render_time.count() * 1000.0, thread_count);
+}
+
+// Old swapchain and its views are destroyed deferred, frames in flight are not waited for
+void MainAppImpl::RecreateSwapchain(int width, int height) {
+	TRACE_SCOPE("recreate_swapchain");
 	CHECK_RESULT(swapchain.Recreate(width, height));
 	bSwapchainDirty = false;
+	++prerecorded_generation;
 	// std::printf("Recr with size %dx%d\n", width, height);
 }
 
-static std::chrono::high_resolution_clock::time_point last_frame_time = std::chrono::high_resolution_clock::now();
+// Shows rolling frame time statistics in the window title and verbose log
+void MainAppImpl::ReportFrameStats() {
+	auto const now = std::chrono::steady_clock::now();
+	if (now - last_frame_stats_time < kFrameStatsInterval) return;
+	last_frame_stats_time = now;
+
+	if (!gpu_frame_times_ms.IsEmpty()) {
+		Utils::SampleStats const gpu = gpu_frame_times_ms.ComputeStats();
+		char                     title_buffer[512];
+		std::snprintf(title_buffer, sizeof(title_buffer), "%s - GPU %.3f ms (min %.3f, p99 %.3f)",
+					  window_title.data(), gpu.avg, gpu.min, gpu.p99);
+		window.SetText(title_buffer);
+		LogVerbose("GPU frame time: min %.3f ms, avg %.3f ms, p99 %.3f ms (%u frames)", gpu.min, gpu.avg, gpu.p99, gpu.count);
+	}
+	if (!user_options.bVerbose) return;
+	if (bTiledPassActive && IsTiled()) {
+		LogVerbose("Tiled: %.1f%% of the image, %ju pixels per frame", tile_scheduler.GetProgress() * 100.0f, tile_scheduler.GetPixelsPerFrame());
+	}
+	if (frame_pacer.GetInfo().interval.count() > 0) {
+		Utils::SampleStats const pacing = frame_pacer.GetErrorStats();
+		LogVerbose("Pacing error: p50 %.3f ms, p99 %.3f ms, max %.3f ms, %u missed", pacing.p50, pacing.p99, pacing.max, frame_pacer.GetMissedCount());
+	}
+	for (std::size_t phase = 0; phase < frame_phase_times_ms.size(); ++phase) {
+		if (frame_phase_times_ms[phase].IsEmpty()) continue;
+		Utils::SampleStats const cpu = frame_phase_times_ms[phase].ComputeStats();
+		LogVerbose("  CPU %-14s p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+				   kFramePhaseNames[phase], cpu.p50, cpu.p95, cpu.p99, cpu.max);
+	}
+}
+
+void MainAppImpl::BeginFramePhase() { frame_phase_start = std::chrono::steady_clock::now(); }
+
+// Records the time since the previous phase ended and starts the next one
+void MainAppImpl::EndFramePhase(FramePhase phase) {
+	auto const now = std::chrono::steady_clock::now();
+	frame_phase_times_ms[std::to_underlying(phase)].Push(std::chrono::duration<float, std::milli>(now - frame_phase_start).count());
+	Tracer::Get().AddZone(kFramePhaseNames[std::to_underlying(phase)], frame_phase_start, now);
+	frame_phase_start = now;
+}
+
+void MainAppImpl::CollectGpuFrameTime(FrameTimestamps& timestamps) {
+	std::optional<double> const gpu_time_ms = timestamps.pool.ReadElapsedMs(0, 1);
+	if (!gpu_time_ms.has_value()) return;
+	gpu_frame_times_ms.Push(static_cast<float>(gpu_time_ms.value()));
+	// Tiled frames take the budget at any scale, they only teach the scheduler the cost of a pixel
+	if (timestamps.tile_pixels > 0) {
+		tile_scheduler.AddTime(timestamps.tile_pixels, static_cast<float>(gpu_time_ms.value()));
+	} else if (resolution_scaler.AddFrameTime(static_cast<float>(gpu_time_ms.value()))) {
+		LogVerbose("Render scale: %.3f", resolution_scaler.GetScale());
+	}
+	benchmark.AddGpuFrameTime(timestamps.frame_index, static_cast<float>(gpu_time_ms.value()));
+}
+
+// One row per sample, oldest first, so phases with skipped frames do not misalign columns
+void MainAppImpl::SaveFramePhaseCsv() const {
+	if (user_options.phase_csv_path.empty()) return;
+	std::FILE* file = std::fopen(user_options.phase_csv_path.data(), "w");
+	if (!file) {
+		LOG_ERROR("Failed to open %s", user_options.phase_csv_path.data());
+		return;
+	}
+	std::fprintf(file, "phase,sample,ms\n");
+	for (std::size_t phase = 0; phase < frame_phase_times_ms.size(); ++phase) {
+		u32 sample = 0;
+		frame_phase_times_ms[phase].ForEach([&](float value) {
+			std::fprintf(file, "%s,%u,%.4f\n", kFramePhaseNames[phase], sample++, value);
+		});
+	}
+	std::fclose(file);
+	LogVerbose("Frame phase times written to %s", user_options.phase_csv_path.data());
+}
+
+void MainAppImpl::SaveTrace() const {
+	if (user_options.trace_path.empty()) return;
+	if (!Tracer::Get().Write(user_options.trace_path)) {
+		LOG_ERROR("Failed to write trace to %s", user_options.trace_path.data());
+		return;
+	}
+	LogVerbose("Trace written to %s", user_options.trace_path.data());
+}
+
+void MainAppImpl::PinMouse(int width, int height) {
+	mouse.x = static_cast<float>(width) * 0.5f;
+	mouse.y = static_cast<float>(height) * 0.5f;
+}
+
+void MainAppImpl::SaveBenchmarkResults() {
+	vk::PhysicalDeviceProperties const& properties = physical_device.GetProperties10();
+	BenchmarkReport const               report{
+		.shader           = fragment_shader.path_string,
+		.device           = properties.deviceName.data(),
+		.driver_version   = properties.driverVersion,
+		.bHeadless        = user_options.bHeadless,
+		.width            = viewport.width,
+		.height           = viewport.height,
+		.time_step        = user_options.time_step,
+		.compile_backend  = last_shader_build.backend_name,
+		.compile_time_ms  = last_shader_build.compile_time_ms,
+		.pipeline_time_ms = last_shader_build.pipeline_time_ms,
+	};
+	if (!benchmark.Write(user_options.benchmark_output, report)) {
+		LOG_ERROR("Failed to open %s", user_options.benchmark_output.data());
+		exit_code = 1;
+		return;
+	}
+	LogVerbose("Benchmark results written to %s", user_options.benchmark_output.data());
+}
+
+void MainAppImpl::InitFramePacer() {
+	float const              fps_limit = user_options.fps_limit;
+	std::chrono::nanoseconds interval{0};
+	if (fps_limit > 0.0f) {
+		interval = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / fps_limit));
+	}
+	frame_pacer.Init({.interval = interval, .spin_slack = std::chrono::microseconds(user_options.pacer_slack_us)});
+	bPaceOnPresent = bPresentWait && bFpsFromRefreshRate;
+	LogVerbose("Frame pacing: %s", bPaceOnPresent ? "presentation" : fps_limit > 0.0f ? "timer" : "off");
+}
 
 void MainAppImpl::WaitForFrameTimeLeft() {
-	auto fps_limit = user_options.fps_limit;
-	if (fps_limit == kFpsUnlimited || fps_limit == 0) return;
-	auto now             = std::chrono::high_resolution_clock::now();
-	auto elapsed         = now - last_time;
-	auto frame_time_left = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<float>(1.0f / fps_limit) - elapsed);
-	if (frame_time_left > std::chrono::milliseconds(0)) {
-		std::this_thread::sleep_for(frame_time_left);
+	u64 const present_id = swapchain.GetLastPresentId();
+	if (bPaceOnPresent && present_id != last_paced_present_id) {
+		// One frame may stay queued, waiting for the last one would leave the GPU idle between frames
+		last_paced_present_id = present_id;
+		vk::Result result     = swapchain.WaitForPresent(present_id - 1, kPresentWaitTimeout);
+		if (result != vk::Result::eTimeout && result != vk::Result::eSuboptimalKHR && result != vk::Result::eErrorOutOfDateKHR) {
+			CHECK_RESULT(result);
+		}
+		frame_pacer.Track();
+		return;
 	}
-	last_time = now;
+	// Timer pacing, also used while paused when nothing new is presented
+	frame_pacer.Wait();
 }
 
 void MainAppImpl::MainLoop() {
+	bool bIdle = false; // since the last paced frame
 	do {
-		WindowManager::PollEvents();
-		// if (bPaused) {
-		// 	WindowManager::WaitEvents();
-		// } else {
-		// }
-		// WindowManager::WaitEventsTimeout(0.1);
+		// Nothing changes on screen by itself, sleep until input, resize, a file change
+		// or a finished pipeline build posts an event
+		// A tiled image is drawn to completion, also when paused or not animated
+		bool const bAnimating = IsBenchmarking() || (!bPaused && IsShaderAnimated()) || (bTiledPassActive && IsTiled());
+		bIdle |= !bAnimating && !bNeedsRedraw;
+		{
+			TRACE_SCOPE("poll_events");
+			if (bAnimating || bNeedsRedraw) {
+				WindowManager::PollEvents();
+			} else if (playlist.IsTimed()) {
+				// Wake up for the next playlist switch
+				WindowManager::WaitEventsTimeout(playlist.GetTimeToSwitch());
+			} else {
+				WindowManager::WaitEvents();
+			}
+		}
 		if (glfwWindowShouldClose(reinterpret_cast<GLFWwindow*>(window.GetHandle()))) [[unlikely]]
 			break;
-		bool bUpdated = UpdateUserFragmentShader();
-		if (!bPaused || bUpdated) {
+		UpdatePlaylist();
+		bool const bUpdated = !IsBenchmarking() && UpdateUserFragmentShader();
+		bool const bDraw    = bAnimating || bUpdated || bNeedsRedraw;
+		if (bDraw) {
+			bNeedsRedraw                = false;
+			auto const frame_start_time = std::chrono::steady_clock::now();
+			int const  drawn_frame      = frame_index;
 			OnDrawWindow();
+			if (frame_index != drawn_frame) {
+				benchmark.AddCpuFrameTime(drawn_frame, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start_time).count());
+			}
 		};
+		ReportFrameStats();
+		if (IsBenchmarking() && benchmark.IsDone(frame_index)) break;
+		// Redraws on input are limited like animated frames, e.g. while dragging the mouse
+		if (!bDraw) {
+			bIdle = true;
+			continue;
+		}
+		// Deadline from before waiting for events is long gone, not a missed frame
+		if (bIdle) {
+			frame_pacer.Reset();
+			bIdle = false;
+		}
+		BeginFramePhase();
 		WaitForFrameTimeLeft();
+		EndFramePhase(FramePhase::eFrameLimit);
 	} while (true);
 };
 
@@ -1018,15 +3236,39 @@ private:
 
 void PrintUsage() {
 	UserOptions default_options{};
-	std::printf("Usage: %ls <fragment_shader_file> ", gGlobalData.executable_path.filename().c_str());
+	Logger::Get().Flush();
+	std::printf("Usage: %ls <fragment_shader_file|directory>... ", gGlobalData.executable_path.filename().c_str());
 	std::printf("[--help] ");
 	std::printf("[--validation=%s] ", Utils::FormatBool(default_options.bValidationEnabled).data());
 	std::printf("[--verbose=%s] ", Utils::FormatBool(default_options.bVerbose).data());
+	std::printf("[--log-level=trace] ");
 	std::printf("[--update-on-save=%s] ", Utils::FormatBool(default_options.bUpdateOnSave).data());
 	std::printf("[--flip-y=%s] ", Utils::FormatBool(default_options.bFlipY).data());
 	std::printf("[--start-paused=%s] ", Utils::FormatBool(default_options.bStartPaused).data());
 	std::printf("[--transparent=%s] ", Utils::FormatBool(default_options.bTransparent).data());
+	std::printf("[--in-process-compiler=%s] ", Utils::FormatBool(default_options.bInProcessCompiler).data());
+	std::printf("[--poll-files=%s] ", Utils::FormatBool(default_options.bPollFiles).data());
+	std::printf("[--headless=%s] ", Utils::FormatBool(default_options.bHeadless).data());
+	std::printf("[--prerecord=%s] ", Utils::FormatBool(default_options.bPrerecord).data());
+	std::printf("[--size=%dx%d] ", default_options.headless_width, default_options.headless_height);
+	std::printf("[--frames=%d] ", default_options.frame_count);
+	std::printf("[--timestep=%f] ", default_options.time_step);
+	std::printf("[--output=%s] ", default_options.output_path.data());
+	std::printf("[--save-frames=last] ");
+	std::printf("[--readback-buffers=%d] ", default_options.readback_buffers);
+	std::printf("[--export-threads=<int>] ");
+	std::printf("[--phase-csv=<path>] ");
+	std::printf("[--trace=<path>] ");
+	std::printf("[--benchmark=<frames>] ");
+	std::printf("[--benchmark-warmup=%d] ", default_options.benchmark_warmup);
+	std::printf("[--benchmark-output=%s] ", default_options.benchmark_output.data());
 	std::printf("[--fps-limit=%f] ", default_options.fps_limit);
+	std::printf("[--pacer-slack=%d] ", default_options.pacer_slack_us);
+	std::printf("[--render-scale=%f] ", default_options.render_scale);
+	std::printf("[--target-ms=<float>] ");
+	std::printf("[--tile-budget-ms=<float>] ");
+	std::printf("[--playlist-interval=<float>] ");
+	std::printf("[--precompile-threads=<int>] ");
 	std::printf("[--compile_options=%s] ", default_options.compile_options.data());
 	std::printf("\n");
 }
@@ -1035,13 +3277,46 @@ void PrintHelp() {
 	PrintUsage();
 	std::printf("  --validation=<bool>   Enable Vulkan validation layers\n");
 	std::printf("  --verbose=<bool>      Enable verbose logging\n");
+	std::printf("  --log-level=<level>   Discard messages below trace, info, warning or error\n");
 	std::printf("  --update-on-save=<bool> Update the shader on save\n");
 	std::printf("  --flip-y=<bool>       Flip the Y axis\n");
 	std::printf("  --start-paused=<bool> Start paused\n");
 	std::printf("  --transparent=<bool>  Make the window transparent\n");
+	std::printf("  --in-process-compiler=<bool> Compile GLSL and Slang in process when available instead of running glslc or slangc\n");
+	std::printf("  --poll-files=<bool>   Poll the shader file instead of using inotify\n");
 	std::printf("  --fps-limit=<float>   FPS limit. Use monitor refresh rate by default. Disable with 0\n");
+	std::printf("  --pacer-slack=<int>   Microseconds before a frame deadline spent spinning instead of sleeping\n");
+	std::printf("  --render-scale=<float> Render at this fraction of the window size and upscale, 0.25 to 1\n");
+	std::printf("  --target-ms=<float>   Adjust the render scale to hold this GPU frame time in milliseconds\n");
+	std::printf("  --tile-budget-ms=<float> Draw single pass fragment shaders in tiles over several frames, each frame taking\n");
+	std::printf("                        about this GPU time. The last complete image is shown meanwhile.\n");
+	std::printf("  --playlist-interval=<float> Seconds each shader of a playlist is shown, 0 to switch with Page Up/Down only\n");
+	std::printf("  --precompile-threads=<int> Threads building the playlist up front, 0 for up to %u\n", MainAppImpl::kMaxPrecompileThreads);
+	std::printf("  --headless=<bool>     Render offscreen without a window and write frames to disk\n");
+	std::printf("  --prerecord=<bool>    Record command buffers once, shaders read per-frame values from the uniform buffer at set 0, binding 0\n");
+	std::printf("  --size=<w>x<h>        Headless render resolution\n");
+	std::printf("  --frames=<int>        Number of frames to render in headless mode\n");
+	std::printf("  --timestep=<float>    Time step between headless frames in seconds\n");
+	std::printf("  --output=<path>       Headless output file, .png, .ppm, .exr or a .y4m video stream. %%d or %%04d is replaced with the frame number\n");
+	std::printf("  --save-frames=<list>  Frames to write: all, last or a list like 0,10,20-30. All by default for a .y4m stream\n");
+	std::printf("  --readback-buffers=<int> Frames in flight or being encoded in headless mode, at least 2\n");
+	std::printf("  --export-threads=<int> Threads encoding headless frames, 0 for up to %u\n", MainAppImpl::kMaxExportThreads);
+	std::printf("  --phase-csv=<path>    Write the last CPU frame phase times to a CSV file on exit\n");
+	std::printf("  --trace=<path>        Write frame phases and shader builds as Chrome trace event JSON on exit\n");
+	std::printf("  --benchmark=<frames>  Render this many frames with a fixed timestep after a warm-up, write statistics and exit\n");
+	std::printf("  --benchmark-warmup=<int> Frames rendered before measuring\n");
+	std::printf("  --benchmark-output=<path> JSON file the benchmark results are written to\n");
 
 	std::printf("  --compile_options=<string> Options for shader compilation\n");
+	std::printf("\nFiles <name>.bufferA<ext> to <name>.bufferD<ext> next to the shader are drawn first as Buffer A-D,\n"
+				"every pass samples them as iChannel0-3 at set 1, bindings 0-3\n");
+	std::printf("\nCompute shaders (.comp) write the rgba16f storage image at set 1, binding 4, one invocation per pixel.\n"
+				"With layout(local_size_x_id = 0, local_size_y_id = 1) the workgroup size is chosen for the device\n");
+	std::printf("\nSeveral shaders or a directory make a playlist, all are built at startup and Page Up/Down\n"
+				"switches between them instantly\n");
+	std::printf("\nSpecialization constants, layout(constant_id = N) const, change without recompiling:\n"
+				"Alt+1-9 toggles or increments the first nine, Alt+Shift+1-9 decrements, Alt+0 resets them.\n"
+				"<name><ext>.spec next to the shader sets them with name = value lines\n");
 }
 
 auto ArgParser::ParseBoolKwarg(const std::string_view arg, const std::string_view key, bool& value) -> char const* {
@@ -1075,17 +3350,71 @@ auto ArgParser::ParseNumKwarg(const std::string_view arg, const std::string_view
 }
 
 auto ArgParser::ParseKwargs(const std::string_view arg) -> char const* {
-	bool value;
-	int  value_int;
+	bool             value;
+	int              value_int;
+	std::string_view value_str;
 	if (!ParseBoolKwarg(arg, "--validation", value)) user_options->bValidationEnabled = value;
 	else if (!ParseBoolKwarg(arg, "--verbose", value)) user_options->bVerbose = value;
 	else if (!ParseBoolKwarg(arg, "--update-on-save", value)) user_options->bUpdateOnSave = value;
 	else if (!ParseBoolKwarg(arg, "--flip-y", value)) user_options->bFlipY = value;
 	else if (!ParseBoolKwarg(arg, "--start-paused", value)) user_options->bStartPaused = value;
 	else if (!ParseBoolKwarg(arg, "--transparent", value)) user_options->bTransparent = value;
+	else if (!ParseBoolKwarg(arg, "--in-process-compiler", value)) user_options->bInProcessCompiler = value;
+	else if (!ParseBoolKwarg(arg, "--poll-files", value)) user_options->bPollFiles = value;
+	else if (!ParseBoolKwarg(arg, "--headless", value)) user_options->bHeadless = value;
+	else if (!ParseBoolKwarg(arg, "--prerecord", value)) user_options->bPrerecord = value;
 	else if (!ParseNumKwarg(arg, "--fps-limit", value_int)) {
 		if (value_int < 0) value_int = -1;
 		user_options->fps_limit = static_cast<float>(value_int);
+	} else if (!ParseNumKwarg(arg, "--pacer-slack", value_int)) {
+		if (value_int < 0) return arg.data();
+		user_options->pacer_slack_us = value_int;
+	} else if (!ParseNumKwarg(arg, "--benchmark-warmup", value_int)) {
+		if (value_int < 0) return arg.data();
+		user_options->benchmark_warmup = value_int;
+	} else if (!ParseNumKwarg(arg, "--benchmark", value_int)) {
+		if (value_int <= 0) return arg.data();
+		user_options->benchmark_frames = value_int;
+	} else if (Utils::ParseString(arg, "--benchmark-output=", user_options->benchmark_output)) {
+	} else if (!ParseNumKwarg(arg, "--readback-buffers", value_int)) {
+		if (value_int < 2) return arg.data();
+		user_options->readback_buffers = value_int;
+	} else if (!ParseNumKwarg(arg, "--export-threads", value_int)) {
+		if (value_int < 0) return arg.data();
+		user_options->export_threads = value_int;
+	} else if (!ParseNumKwarg(arg, "--frames", value_int)) {
+		if (value_int <= 0) return arg.data();
+		user_options->frame_count = value_int;
+	} else if (Utils::ParseFloat(arg, "--render-scale=", user_options->render_scale)) {
+		if (!(user_options->render_scale >= 0.25f && user_options->render_scale <= 1.0f)) return arg.data();
+	} else if (Utils::ParseFloat(arg, "--target-ms=", user_options->target_ms)) {
+		if (!(user_options->target_ms >= 0.0f)) return arg.data();
+	} else if (Utils::ParseFloat(arg, "--tile-budget-ms=", user_options->tile_budget_ms)) {
+		if (!(user_options->tile_budget_ms >= 0.0f)) return arg.data();
+	} else if (Utils::ParseFloat(arg, "--playlist-interval=", user_options->playlist_interval)) {
+		if (!(user_options->playlist_interval >= 0.0f)) return arg.data();
+	} else if (!ParseNumKwarg(arg, "--precompile-threads", value_int)) {
+		if (value_int < 0) return arg.data();
+		user_options->precompile_threads = value_int;
+	} else if (Utils::ParseFloat(arg, "--timestep=", user_options->time_step)) {
+		if (!(user_options->time_step > 0.0f)) return arg.data();
+	} else if (Utils::ParseString(arg, "--size=", value_str)) {
+		if (std::sscanf(value_str.data(), "%dx%d", &user_options->headless_width, &user_options->headless_height) != 2 ||
+			user_options->headless_width <= 0 || user_options->headless_height <= 0) return arg.data();
+	} else if (Utils::ParseString(arg, "--output=", user_options->output_path)) {
+		std::optional<ImageWriter::ImageFileFormat> const format = ImageWriter::GetFileFormat(user_options->output_path);
+		if (!format.has_value()) return arg.data();
+		std::string path;
+		bool        bHasPlaceholder;
+		if (format != ImageWriter::ImageFileFormat::eY4M && !FormatOutputPattern(user_options->output_path, 0, path, bHasPlaceholder)) return arg.data();
+	} else if (Utils::ParseString(arg, "--save-frames=", value_str)) {
+		user_options->save_frames = value_str;
+	} else if (Utils::ParseString(arg, "--phase-csv=", user_options->phase_csv_path)) {
+	} else if (Utils::ParseString(arg, "--trace=", user_options->trace_path)) {
+	} else if (Utils::ParseString(arg, "--log-level=", value_str)) {
+		std::optional<LogLevel> const level = LogLevelFromString(value_str);
+		if (!level.has_value()) return arg.data();
+		user_options->log_level = level.value();
 	} else if (Utils::ParseString(arg, "--compile_options=", user_options->compile_options)) {
 	} else return arg.data();
 	return nullptr;
@@ -1102,7 +3431,7 @@ auto ArgParser::Parse() -> char const* {
 	return nullptr;
 }
 
-void MainAppImpl::Run(int argc, char const* const* argv) {
+int MainAppImpl::Run(int argc, char const* const* argv) {
 	gGlobalData.executable_path        = std::filesystem::absolute(argv[0]);
 	gGlobalData.executable_path_string = gGlobalData.executable_path.string();
 	gGlobalData.executable_dir         = gGlobalData.executable_path.parent_path();
@@ -1115,49 +3444,132 @@ void MainAppImpl::Run(int argc, char const* const* argv) {
 	gGlobalData.window_state_path          = gGlobalData.config_dir + "/WindowState.ini";
 	gGlobalData.fallback_fragment_spv_path = gGlobalData.temp_dir_string + "/Fallback.frag.spv";
 	gGlobalData.user_fragment_spv_path     = gGlobalData.temp_dir_string + "/FragOutput.frag.spv";
+	gGlobalData.pipeline_cache_path        = gGlobalData.temp_dir_string + "/ShaderPlayground.pipeline_cache";
+	gGlobalData.shader_cache_dir           = gGlobalData.temp_dir_string + "/ShaderPlayground.spirv_cache";
+	gGlobalData.slang_module_cache_dir     = gGlobalData.temp_dir_string + "/ShaderPlayground.slang_modules";
 
 	for (std::string_view const arg : std::span(argv + 1, argc - 1)) {
 		if (arg == "--help") {
 			PrintHelp();
-			return;
+			return 0;
 		}
 	}
 	if (argc < 2) {
 		LOG_ERROR("No fragment shader file specified");
 		PrintUsage();
-		return;
+		return 1;
 	}
-	fragment_shader.Update(argv[1]);
+	int shader_arg_count = 1;
+	while (shader_arg_count + 1 < argc && !std::string_view(argv[shader_arg_count + 1]).starts_with("--")) {
+		++shader_arg_count;
+	}
+	std::vector<std::filesystem::path> const shader_paths = CollectShaderPaths(std::span(argv + 1, shader_arg_count));
+	if (shader_paths.empty()) {
+		LOG_ERROR("No shader files in %s", argv[1]);
+		return 1;
+	}
+	fragment_shader.Update(shader_paths[0].string());
 
-	ArgParser arg_parser(argc - 2, argv + 2, user_options);
+	ArgParser arg_parser(argc - 1 - shader_arg_count, argv + 1 + shader_arg_count, user_options);
 
 	if (char const* unknown_arg = arg_parser.Parse(); unknown_arg) {
 		LOG_ERROR("Error in argument: %s", unknown_arg);
 		PrintUsage();
-		return;
+		return 1;
+	}
+	Logger::Get().SetLevel(user_options.log_level);
+	if (!user_options.trace_path.empty()) {
+		Tracer::Get().Start();
+		TRACE_THREAD_NAME("main");
+	}
+	benchmark.Init({.warmup_frames = user_options.benchmark_warmup, .frames = user_options.benchmark_frames});
+	if (IsBenchmarking()) {
+		// Fixed timestep and as many frames as the GPU can do, nothing that depends on the user or files
+		user_options.fps_limit      = kFpsUnlimited;
+		user_options.bStartPaused   = false;
+		user_options.bUpdateOnSave  = false;
+		user_options.target_ms      = 0.0f;
+		user_options.tile_budget_ms = 0.0f;
+		if (user_options.bHeadless) {
+			user_options.frame_count = benchmark.GetFrameCount();
+			user_options.save_frames = "";
+		}
+	}
+	if (shader_paths.size() > 1) {
+		if (user_options.bHeadless || IsBenchmarking()) {
+			LOG_WARN("Rendering only %s, playlists need a window", fragment_shader.path_string.data());
+		} else {
+			playlist.Init(shader_paths, {.interval = user_options.playlist_interval});
+		}
+	}
+	if (!user_options.save_frames.has_value()) {
+		bool const bStream       = ImageWriter::GetFileFormat(user_options.output_path) == ImageWriter::ImageFileFormat::eY4M;
+		user_options.save_frames = bStream ? "all" : "last";
+	}
+	if (user_options.bHeadless && !frame_output.Init(user_options.output_path, user_options.save_frames.value(), user_options.frame_count)) {
+		LOG_ERROR("Invalid frame selection: %s", user_options.save_frames->data());
+		return 1;
 	}
 
 	if (user_options.bVerbose) {
+		Logger::Get().Flush();
 		std::printf("UserOptions:\n");
 		std::printf("  bVerbose: %s\n", Utils::FormatBool(user_options.bVerbose).data());
 		std::printf("  bFlipY: %s\n", Utils::FormatBool(user_options.bFlipY).data());
 		std::printf("  bUpdateOnSave: %s\n", Utils::FormatBool(user_options.bUpdateOnSave).data());
 		std::printf("  bValidationEnabled: %s\n", Utils::FormatBool(user_options.bValidationEnabled).data());
 		std::printf("  fps-limit: %.1f\n", user_options.fps_limit);
+		std::printf("  render-scale: %.3f, target-ms: %.3f\n", user_options.render_scale, user_options.target_ms);
+		std::printf("  tile-budget-ms: %.3f\n", user_options.tile_budget_ms);
+		if (!playlist.IsEmpty()) {
+			std::printf("  playlist: %zu shaders, interval %.1f s, precompile-threads %d\n", playlist.GetSize(), user_options.playlist_interval,
+						user_options.precompile_threads);
+		}
 		std::printf("  start-paused: %s\n", Utils::FormatBool(user_options.bStartPaused).data());
+		std::printf("  in-process-compiler: %s\n", Utils::FormatBool(user_options.bInProcessCompiler).data());
+		if (user_options.bHeadless) {
+			std::printf("  headless: %dx%d, %d frames, timestep %f, output %s, save %s\n",
+						user_options.headless_width, user_options.headless_height, user_options.frame_count,
+						user_options.time_step, user_options.output_path.data(), user_options.save_frames->data());
+			std::printf("  export: %d readback buffers, %d threads\n", user_options.readback_buffers, user_options.export_threads);
+		}
+		if (IsBenchmarking()) {
+			std::printf("  benchmark: %d frames after %d warm-up, output %s\n",
+						user_options.benchmark_frames, user_options.benchmark_warmup, user_options.benchmark_output.data());
+		}
 		std::printf("\n");
 	}
 
 	Init();
 	start_time = std::chrono::high_resolution_clock::now();
+	if (IsBenchmarking()) {
+		PinMouse(static_cast<int>(viewport.width), static_cast<int>(viewport.height));
+	}
+	if (user_options.bHeadless) {
+		RunHeadless();
+		if (IsBenchmarking()) SaveBenchmarkResults();
+		SaveTrace();
+		return exit_code;
+	}
 	MainLoop();
+	SaveFramePhaseCsv();
+	SaveTrace();
+	if (IsBenchmarking()) {
+		// Pick up the timestamps of the frames still in flight
+		CHECK_RESULT(device.waitIdle());
+		for (FrameTimestamps& timestamps : frame_timestamps) {
+			CollectGpuFrameTime(timestamps);
+		}
+		SaveBenchmarkResults();
+	}
 
 	window_state = WindowState::FromWindow(window);
 	window_state.SaveToFile(gGlobalData.window_state_path);
+	return exit_code;
 }
 
-void MainApplication::Run(int argc, char** argv) {
+int MainApplication::Run(int argc, char** argv) {
 	MainAppImpl app;
 	gApp = &app;
-	app.Run(argc, argv);
+	return app.Run(argc, argv);
 }
@@ -2,5 +2,6 @@ export module Application;
 
 export class MainApplication {
 public:
-	void Run(int argc, char** argv);
+	// Returns process exit code
+	int Run(int argc, char** argv);
 };
@@ -13,6 +13,9 @@ export struct ApplicationGlobalData {
 	std::string_view      fallback_fragment_shader_file_path = "Source/Shaders/Fallback.frag";
 	std::string           fallback_fragment_spv_path;
 	std::string           user_fragment_spv_path;
+	std::string           pipeline_cache_path;
+	std::string           shader_cache_dir;
+	std::string           slang_module_cache_dir;
 	std::string           window_state_path;
 };
 
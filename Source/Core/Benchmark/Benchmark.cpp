@@ -0,0 +1,72 @@
+module Benchmark;
+
+import std;
+import Utils;
+
+namespace {
+void WriteJsonString(std::FILE* file, std::string_view str) {
+	std::fputc('"', file);
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			std::fprintf(file, "\\%c", c);
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			std::fprintf(file, "\\u%04x", c);
+		} else {
+			std::fputc(c, file);
+		}
+	}
+	std::fputc('"', file);
+}
+
+void WriteJsonStats(std::FILE* file, char const* name, std::span<float> samples) {
+	Utils::SampleStats const stats = Utils::ComputeStatsInPlace(samples);
+	std::fprintf(file, "  \"%s\": {\"count\": %u, \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+				 name, stats.count, stats.min, stats.avg, stats.p50, stats.p95, stats.p99, stats.max);
+}
+} // namespace
+
+void Benchmark::Init(BenchmarkInfo const& info) {
+	this->info = info;
+	cpu_frame_times_ms.clear();
+	gpu_frame_times_ms.clear();
+	if (IsEnabled()) {
+		cpu_frame_times_ms.reserve(info.frames);
+		gpu_frame_times_ms.reserve(info.frames);
+	}
+}
+
+void Benchmark::AddCpuFrameTime(int frame, float ms) {
+	if (IsMeasured(frame)) cpu_frame_times_ms.push_back(ms);
+}
+
+void Benchmark::AddGpuFrameTime(int frame, float ms) {
+	if (IsMeasured(frame)) gpu_frame_times_ms.push_back(ms);
+}
+
+bool Benchmark::Write(std::string_view path, BenchmarkReport const& report) {
+	std::FILE* file = std::fopen(std::string(path).data(), "w");
+	if (!file) return false;
+	std::fprintf(file, "{\n  \"shader\": ");
+	WriteJsonString(file, report.shader);
+	std::fprintf(file, ",\n  \"device\": ");
+	WriteJsonString(file, report.device);
+	std::fprintf(file, ",\n  \"driver_version\": %u,\n", report.driver_version);
+	std::fprintf(file, "  \"headless\": %s,\n", Utils::FormatBool(report.bHeadless).data());
+	std::fprintf(file, "  \"width\": %.0f,\n  \"height\": %.0f,\n", report.width, report.height);
+	std::fprintf(file, "  \"warmup_frames\": %d,\n  \"frames\": %d,\n", info.warmup_frames, info.frames);
+	std::fprintf(file, "  \"time_step\": %f,\n", report.time_step);
+	std::fprintf(file, "  \"compile_backend\": ");
+	WriteJsonString(file, report.compile_backend);
+	std::fprintf(file, ",\n  \"compile_time_ms\": %.4f,\n", report.compile_time_ms);
+	std::fprintf(file, "  \"pipeline_time_ms\": %.4f,\n", report.pipeline_time_ms);
+	WriteJsonStats(file, "cpu_frame_ms", cpu_frame_times_ms);
+	std::fprintf(file, ",\n");
+	if (gpu_frame_times_ms.empty()) {
+		std::fprintf(file, "  \"gpu_frame_ms\": null");
+	} else {
+		WriteJsonStats(file, "gpu_frame_ms", gpu_frame_times_ms);
+	}
+	std::fprintf(file, "\n}\n");
+	std::fclose(file);
+	return true;
+}
@@ -0,0 +1,53 @@
+export module Benchmark;
+
+import std;
+
+using u32 = std::uint32_t;
+
+export struct BenchmarkInfo {
+	// Frames rendered before measuring
+	int warmup_frames = 60;
+	// Frames measured, 0 if not benchmarking
+	int frames = 0;
+};
+
+// What the frames were rendered with, written along with their times
+export struct BenchmarkReport {
+	std::string_view shader;
+	std::string_view device;
+	u32              driver_version   = 0;
+	bool             bHeadless        = false;
+	float            width            = 0.0f;
+	float            height           = 0.0f;
+	float            time_step        = 0.0f;
+	std::string_view compile_backend  = "none";
+	float            compile_time_ms  = 0.0f;
+	float            pipeline_time_ms = 0.0f;
+};
+
+// Keeps every frame time of a benchmark run after the warm-up, frames are numbered from 0.
+// GPU times arrive frames later than CPU ones, both are kept apart and may differ in count.
+export class Benchmark {
+public:
+	void Init(BenchmarkInfo const& info);
+
+	bool IsEnabled() const { return info.frames > 0; }
+	bool IsMeasured(int frame) const { return IsEnabled() && frame >= info.warmup_frames; }
+	bool IsDone(int frame) const { return frame >= GetFrameCount(); }
+	auto GetFrameCount() const -> int { return info.warmup_frames + info.frames; }
+
+	// Times of frames not measured are ignored
+	void AddCpuFrameTime(int frame, float ms);
+	void AddGpuFrameTime(int frame, float ms);
+
+	// Writes report and statistics of the frame times as JSON, gpu_frame_ms is null without GPU times.
+	// Reorders the frame times. Returns false if path can not be opened.
+	bool Write(std::string_view path, BenchmarkReport const& report);
+
+	auto GetInfo() const -> BenchmarkInfo const& { return info; }
+
+private:
+	BenchmarkInfo      info;
+	std::vector<float> cpu_frame_times_ms;
+	std::vector<float> gpu_frame_times_ms;
+};
@@ -9,7 +9,7 @@ public:
 	[[nodiscard]] auto ReadFile(std::string_view const filename) -> std::optional<std::string>;
 	[[nodiscard]] auto ReadBinaryFile(std::string_view const filename) -> std::optional<std::span<std::byte>>;
 	[[nodiscard]] auto ReadBinaryFileUnique(std::string_view const filename) -> std::optional<std::vector<std::byte>>;
-	[[nodiscard]] auto GetFileVersion(std::string_view const filename) -> int;
+	[[nodiscard]] auto GetFileVersion(std::string_view const filename) -> std::int64_t;
 
 private:
 	std::vector<std::byte> file_buffer;
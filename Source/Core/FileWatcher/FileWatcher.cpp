@@ -0,0 +1,224 @@
+module;
+#ifdef __linux__
+#include <poll.h>        // poll
+#include <sys/eventfd.h> // eventfd
+#include <sys/inotify.h> // inotify_init1, inotify_add_watch
+#include <unistd.h>      // read, write, close
+#endif
+module FileWatcher;
+
+import std;
+import Utils;
+
+FileWatcher::~FileWatcher() { Stop(); }
+
+bool FileWatcher::Start(FileWatcherInfo const& info) {
+	Stop();
+	this->info = info;
+#ifdef __linux__
+	if (!info.bForcePolling) {
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		wake_fd    = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (inotify_fd < 0 || wake_fd < 0) {
+			if (inotify_fd >= 0) close(inotify_fd);
+			if (wake_fd >= 0) close(wake_fd);
+			inotify_fd = -1;
+			wake_fd    = -1;
+		}
+	}
+#endif
+	{
+		std::lock_guard lock(files_mutex);
+		bDirectoriesDirty = true;
+	}
+	thread = std::jthread([this](std::stop_token stop_token) { ThreadMain(stop_token); });
+	return true;
+}
+
+void FileWatcher::Stop() {
+	if (thread.joinable()) {
+		thread.request_stop();
+#ifdef __linux__
+		if (wake_fd >= 0) {
+			std::uint64_t const one = 1;
+			(void)write(wake_fd, &one, sizeof(one));
+		}
+#endif
+		thread.join();
+	}
+#ifdef __linux__
+	if (inotify_fd >= 0) close(inotify_fd);
+	if (wake_fd >= 0) close(wake_fd);
+#endif
+	inotify_fd = -1;
+	wake_fd    = -1;
+	watched_directories.clear();
+}
+
+void FileWatcher::SetFiles(std::span<std::filesystem::path const> paths) {
+	std::vector<FileState> new_files;
+	new_files.reserve(paths.size());
+	for (std::filesystem::path const& path : paths) {
+		new_files.push_back({.path = std::filesystem::absolute(path).lexically_normal()});
+	}
+	{
+		std::lock_guard lock(files_mutex);
+		// Files already watched keep their state, a change not yet seen is still reported
+		for (FileState& state : new_files) {
+			auto it = std::ranges::find(files, state.path, &FileState::path);
+			if (it != files.end()) {
+				state = *it;
+			} else {
+				(void)Refresh(state);
+			}
+		}
+		files             = std::move(new_files);
+		bDirectoriesDirty = true;
+	}
+#ifdef __linux__
+	if (wake_fd >= 0) {
+		std::uint64_t const one = 1;
+		(void)write(wake_fd, &one, sizeof(one));
+	}
+#endif
+}
+
+bool FileWatcher::Refresh(FileState& state) {
+	std::error_code                 error;
+	std::filesystem::file_time_type write_time = std::filesystem::last_write_time(state.path, error);
+	bool const                      bExists    = !error;
+	std::uintmax_t                  size       = bExists ? std::filesystem::file_size(state.path, error) : 0;
+	if (bExists == state.bExists && write_time == state.write_time && size == state.size) {
+		return false;
+	}
+	state.write_time = write_time;
+	state.size       = size;
+	state.bExists    = bExists;
+
+	std::uint64_t hash = 0;
+	if (bExists) {
+		std::optional<std::vector<std::byte>> content = Utils::ReadBinaryFile(state.path.string());
+		if (!content.has_value()) {
+			return false;
+		}
+		hash = Utils::HashBytes(content.value());
+	}
+	if (hash == state.hash) {
+		return false;
+	}
+	state.hash = hash;
+	return true;
+}
+
+void FileWatcher::CheckFiles(std::span<std::string const> changed_names) {
+	bool bChanged = false;
+	{
+		std::lock_guard lock(files_mutex);
+		for (FileState& state : files) {
+			if (!changed_names.empty() &&
+				std::ranges::find(changed_names, state.path.filename().string()) == changed_names.end()) {
+				continue;
+			}
+			bChanged |= Refresh(state);
+		}
+	}
+	if (bChanged) {
+		version.fetch_add(1, std::memory_order_acq_rel);
+		if (info.on_change) {
+			info.on_change();
+		}
+	}
+}
+
+void FileWatcher::ThreadMain(std::stop_token stop_token) {
+	while (!stop_token.stop_requested()) {
+		if (inotify_fd >= 0) {
+			WaitInotify(stop_token);
+		} else {
+			WaitPolling(stop_token);
+		}
+	}
+}
+
+void FileWatcher::WaitPolling(std::stop_token const& stop_token) {
+	std::mutex                  sleep_mutex;
+	std::condition_variable_any sleep_cv;
+	std::unique_lock            lock(sleep_mutex);
+	sleep_cv.wait_for(lock, stop_token, info.poll_interval, [] { return false; });
+	if (stop_token.stop_requested()) return;
+	CheckFiles({});
+}
+
+void FileWatcher::UpdateWatchedDirectories() {
+#ifdef __linux__
+	std::vector<std::filesystem::path> directories;
+	{
+		std::lock_guard lock(files_mutex);
+		if (!bDirectoriesDirty) return;
+		bDirectoriesDirty = false;
+		for (FileState const& state : files) {
+			std::filesystem::path directory = state.path.parent_path();
+			if (std::ranges::find(directories, directory) == directories.end()) {
+				directories.push_back(std::move(directory));
+			}
+		}
+	}
+	for (auto const& [descriptor, directory] : watched_directories) {
+		if (std::ranges::find(directories, directory) == directories.end()) {
+			inotify_rm_watch(inotify_fd, descriptor);
+		}
+	}
+	std::erase_if(watched_directories, [&directories](auto const& entry) {
+		return std::ranges::find(directories, entry.second) == directories.end();
+	});
+	// Completed writes and renames into the directory, partial writes are not reported
+	constexpr std::uint32_t kMask = IN_CLOSE_WRITE | IN_MOVED_TO;
+	for (std::filesystem::path const& directory : directories) {
+		if (std::ranges::find(watched_directories, directory, &std::pair<int, std::filesystem::path>::second) != watched_directories.end()) {
+			continue;
+		}
+		int descriptor = inotify_add_watch(inotify_fd, directory.c_str(), kMask);
+		if (descriptor >= 0) {
+			watched_directories.emplace_back(descriptor, directory);
+		}
+	}
+#endif
+}
+
+void FileWatcher::WaitInotify(std::stop_token const& stop_token) {
+#ifdef __linux__
+	UpdateWatchedDirectories();
+
+	pollfd fds[] = {
+		{.fd = inotify_fd, .events = POLLIN},
+		{.fd = wake_fd, .events = POLLIN},
+	};
+	if (poll(fds, std::size(fds), -1) <= 0) return;
+	if (fds[1].revents & POLLIN) {
+		std::uint64_t value;
+		(void)read(wake_fd, &value, sizeof(value));
+	}
+	if (stop_token.stop_requested() || !(fds[0].revents & POLLIN)) return;
+
+	// Drain all pending events, an atomic save produces several of them
+	std::vector<std::string> changed_names;
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+		if (length <= 0) break;
+		for (char* ptr = buffer; ptr < buffer + length;) {
+			inotify_event const* event = reinterpret_cast<inotify_event const*>(ptr);
+			if (event->len > 0) {
+				std::string name(event->name);
+				if (std::ranges::find(changed_names, name) == changed_names.end()) {
+					changed_names.push_back(std::move(name));
+				}
+			}
+			ptr += sizeof(inotify_event) + event->len;
+		}
+	}
+	if (!changed_names.empty()) {
+		CheckFiles(changed_names);
+	}
+#endif
+}
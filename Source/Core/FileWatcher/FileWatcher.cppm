@@ -0,0 +1,66 @@
+export module FileWatcher;
+
+import std;
+
+export struct FileWatcherInfo {
+	// Called on the watcher thread after a watched file changed its contents
+	std::function<void()>     on_change     = {};
+	std::chrono::milliseconds poll_interval = std::chrono::milliseconds(100);
+	// Use stat polling even where inotify is available
+	bool bForcePolling = false;
+};
+
+// Watches a set of files from a background thread. Files are watched through their directory
+// so editors saving by writing a temporary file and renaming it over the original are handled.
+// A change is reported only if the contents differ, touching the file is ignored.
+export class FileWatcher {
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(FileWatcher const&)            = delete;
+	FileWatcher& operator=(FileWatcher const&) = delete;
+
+	bool Start(FileWatcherInfo const& info);
+	void Stop();
+
+	// Replaces the set of watched files, ones watched before keep their state
+	void SetFiles(std::span<std::filesystem::path const> paths);
+
+	// Incremented on every detected change, cheap to read every frame
+	auto GetVersion() const -> std::uint32_t { return version.load(std::memory_order_acquire); }
+	bool IsRunning() const { return thread.joinable(); }
+	bool IsUsingInotify() const { return inotify_fd >= 0; }
+
+private:
+	struct FileState {
+		std::filesystem::path           path;
+		std::filesystem::file_time_type write_time = {};
+		std::uintmax_t                  size       = 0;
+		std::uint64_t                   hash       = 0;
+		bool                            bExists    = false;
+	};
+
+	void ThreadMain(std::stop_token stop_token);
+	void WaitInotify(std::stop_token const& stop_token);
+	void WaitPolling(std::stop_token const& stop_token);
+	// Returns true if contents changed since the last check
+	static bool Refresh(FileState& state);
+	void        CheckFiles(std::span<std::string const> changed_names);
+	void        UpdateWatchedDirectories();
+
+	FileWatcherInfo info;
+	std::jthread    thread;
+
+	std::mutex             files_mutex;
+	std::vector<FileState> files;
+	bool                   bDirectoriesDirty = false; // guarded by files_mutex
+
+	// inotify watch descriptor -> directory, watcher thread only
+	std::vector<std::pair<int, std::filesystem::path>> watched_directories;
+
+	int inotify_fd = -1;
+	int wake_fd    = -1;
+
+	std::atomic<std::uint32_t> version = 0;
+};
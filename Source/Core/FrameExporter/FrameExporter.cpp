@@ -0,0 +1,106 @@
+module FrameExporter;
+
+import std;
+import ImageWriter;
+
+bool FrameExporter::Start(FrameExporterInfo const& info) {
+	Finish();
+	this->info = info;
+	busy_slots.assign(info.slot_count, false);
+	next_sequence = 0;
+	next_write    = 0;
+	written_count = 0;
+	failed_paths.clear();
+	bStopping = false;
+	if (!info.stream_path.empty()) {
+		stream.open(info.stream_path, std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			return false;
+		}
+		std::string const header = ImageWriter::EncodeY4MHeader(info.width, info.height, info.fps_numerator, info.fps_denominator);
+		stream.write(header.data(), header.size());
+	}
+	for (u32 worker = 0; worker < std::max(info.thread_count, 1u); ++worker) {
+		workers.emplace_back([this] { Worker(); });
+	}
+	return true;
+}
+
+void FrameExporter::Submit(u32 slot, ImageWriter::ImageData const& image, std::string path) {
+	{
+		std::lock_guard lock(mutex);
+		busy_slots[slot] = true;
+		jobs.push_back({.slot = slot, .sequence = next_sequence++, .image = image, .path = std::move(path)});
+	}
+	cv.notify_all();
+}
+
+void FrameExporter::WaitForSlot(u32 slot) {
+	std::unique_lock lock(mutex);
+	cv.wait(lock, [&] { return !busy_slots[slot]; });
+}
+
+bool FrameExporter::Finish() {
+	if (workers.empty()) {
+		return failed_paths.empty();
+	}
+	{
+		std::lock_guard lock(mutex);
+		bStopping = true;
+	}
+	cv.notify_all();
+	workers.clear();
+	if (stream.is_open()) {
+		stream.close();
+		if (!stream) failed_paths.push_back(info.stream_path);
+	}
+	return failed_paths.empty();
+}
+
+void FrameExporter::ReleaseSlot(u32 slot) {
+	{
+		std::lock_guard lock(mutex);
+		busy_slots[slot] = false;
+	}
+	cv.notify_all();
+}
+
+void FrameExporter::Worker() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock lock(mutex);
+			cv.wait(lock, [&] { return !jobs.empty() || bStopping; });
+			if (jobs.empty()) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		bool bWritten;
+		if (stream.is_open()) {
+			// Frames are converted in parallel and appended in submission order
+			std::vector<std::uint8_t> const frame = ImageWriter::EncodeY4MFrame(job.image);
+			ReleaseSlot(job.slot);
+			std::unique_lock lock(mutex);
+			cv.wait(lock, [&] { return next_write == job.sequence; });
+			lock.unlock();
+			stream.write(reinterpret_cast<char const*>(frame.data()), frame.size());
+			bWritten = static_cast<bool>(stream);
+			lock.lock();
+			++next_write;
+		} else {
+			bWritten = ImageWriter::WriteImage(job.path, job.image);
+			ReleaseSlot(job.slot);
+		}
+
+		{
+			std::lock_guard lock(mutex);
+			if (bWritten) {
+				++written_count;
+			} else {
+				failed_paths.push_back(job.path.empty() ? info.stream_path : std::move(job.path));
+			}
+		}
+		cv.notify_all();
+	}
+}
@@ -0,0 +1,70 @@
+export module FrameExporter;
+
+import std;
+import ImageWriter;
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+export struct FrameExporterInfo {
+	u32 thread_count = 2;
+	// Frames that may be waiting or encoding at once, one per buffer their pixels point into
+	u32 slot_count = 3;
+	// Y4M stream every frame is appended to in submission order, empty to write image files
+	std::string stream_path;
+	u32         width           = 0; // of the stream
+	u32         height          = 0;
+	u32         fps_numerator   = 60;
+	u32         fps_denominator = 1;
+};
+
+// Encodes and writes rendered frames on worker threads. Pixels of a frame are not copied, the
+// buffer of its slot must not be reused before WaitForSlot returns. The bounded number of slots
+// is the backpressure, the renderer waits for a slot when encoding falls behind.
+export class FrameExporter {
+public:
+	FrameExporter() = default;
+
+	FrameExporter(FrameExporter const&)            = delete;
+	FrameExporter& operator=(FrameExporter const&) = delete;
+
+	~FrameExporter() { Finish(); }
+
+	[[nodiscard]] bool Start(FrameExporterInfo const& info);
+
+	// path is the image file the frame is written to, unused for a stream
+	void Submit(u32 slot, ImageWriter::ImageData const& image, std::string path);
+	// Blocks until the pixels of the frame submitted in slot are no longer read
+	void WaitForSlot(u32 slot);
+	// Writes all submitted frames and stops the workers. False if any write failed.
+	bool Finish();
+
+	auto GetWrittenCount() const -> u32 { return written_count; }
+	// Files that failed to be written, complete after Finish
+	auto GetFailedPaths() const -> std::span<std::string const> { return failed_paths; }
+	bool IsStream() const { return stream.is_open(); }
+
+private:
+	struct Job {
+		u32                    slot     = 0;
+		u64                    sequence = 0;
+		ImageWriter::ImageData image;
+		std::string            path;
+	};
+
+	void Worker();
+	void ReleaseSlot(u32 slot);
+
+	FrameExporterInfo         info;
+	std::mutex                mutex;
+	std::condition_variable   cv; // job queued, slot released or stream turn passed
+	std::deque<Job>           jobs;
+	std::vector<bool>         busy_slots;
+	std::vector<std::jthread> workers;
+	std::ofstream             stream;
+	u64                       next_sequence = 0;
+	u64                       next_write    = 0; // sequence whose turn it is to append to the stream
+	u32                       written_count = 0;
+	std::vector<std::string>  failed_paths;
+	bool                      bStopping = false;
+};
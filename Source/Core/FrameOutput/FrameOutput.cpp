@@ -0,0 +1,100 @@
+module FrameOutput;
+
+import std;
+import ImageWriter;
+
+bool FormatOutputPattern(std::string_view pattern, int frame, std::string& path, bool& bHasPlaceholder) {
+	path.clear();
+	bHasPlaceholder = false;
+	for (std::size_t pos = 0; pos < pattern.size(); ++pos) {
+		if (pattern[pos] != '%') {
+			path += pattern[pos];
+			continue;
+		}
+		std::string_view const spec = pattern.substr(pos + 1);
+		if (spec.starts_with('%')) {
+			path += '%';
+			++pos;
+			continue;
+		}
+		int width = 0;
+		if (spec.starts_with('0')) {
+			auto const [end, error] = std::from_chars(spec.data() + 1, spec.data() + spec.size(), width);
+			if (error != std::errc{} || width < 0 || width > 16 || end == spec.data() + spec.size() || *end != 'd') return false;
+			pos += end - spec.data() + 1;
+		} else if (spec.starts_with('d')) {
+			pos += 1;
+		} else {
+			return false;
+		}
+		if (bHasPlaceholder) return false;
+		bHasPlaceholder = true;
+		path += std::format("{:0{}}", frame, width);
+	}
+	return true;
+}
+
+bool ParseFrameSelection(std::string_view selection, int frame_count, std::vector<bool>& frames) {
+	frames.assign(frame_count, false);
+	if (selection == "all") {
+		frames.assign(frame_count, true);
+		return true;
+	}
+	if (selection == "last") {
+		frames.back() = true;
+		return true;
+	}
+	while (!selection.empty()) {
+		std::size_t const      comma = selection.find(',');
+		std::string_view const item  = selection.substr(0, comma);
+		selection.remove_prefix(comma == std::string_view::npos ? selection.size() : comma + 1);
+
+		// Frame number or range, nothing else in the item
+		std::size_t const dash  = item.find('-');
+		auto const        Parse = [](std::string_view text, int& value) {
+			auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			return !text.empty() && error == std::errc{} && end == text.data() + text.size();
+		};
+		int first = 0, last = 0;
+		if (!Parse(item.substr(0, dash), first)) return false;
+		if (dash == std::string_view::npos) {
+			last = first;
+		} else if (!Parse(item.substr(dash + 1), last)) {
+			return false;
+		}
+		if (first < 0 || last < first) return false;
+		for (int frame = first; frame <= last && frame < frame_count; ++frame) {
+			frames[frame] = true;
+		}
+	}
+	return true;
+}
+
+bool FrameOutput::Init(std::string_view pattern, std::string_view selection, int frame_count) {
+	this->pattern = pattern;
+	bStream       = ImageWriter::GetFileFormat(pattern) == ImageWriter::ImageFileFormat::eY4M;
+	if (!ParseFrameSelection(selection, frame_count, frames)) return false;
+	saved_count = static_cast<int>(std::ranges::count(frames, true));
+	return true;
+}
+
+auto FrameOutput::GetPath(int frame) const -> std::string {
+	if (bStream) {
+		return pattern;
+	}
+	std::string formatted;
+	bool        bHasPlaceholder = false;
+	if (!FormatOutputPattern(pattern, frame, formatted, bHasPlaceholder) || bHasPlaceholder) {
+		return formatted;
+	}
+	// No placeholder: only add the frame number when several frames are written
+	if (saved_count <= 1) {
+		return formatted;
+	}
+	std::filesystem::path path(formatted);
+	std::filesystem::path extension = path.extension();
+	path.replace_extension();
+	path += std::format("_{:04}", frame);
+	path += extension;
+	return path.string();
+}
@@ -0,0 +1,28 @@
+export module FrameOutput;
+
+import std;
+
+// Replaces the frame number placeholder of an output pattern, "%d" or zero-padded like "%04d".
+// "%%" is a literal '%'. Fails for any other '%' and for more than one placeholder.
+export bool FormatOutputPattern(std::string_view pattern, int frame, std::string& path, bool& bHasPlaceholder);
+
+// "all", "last" or comma separated frame numbers and ranges, e.g. "0,10,20-30"
+export bool ParseFrameSelection(std::string_view selection, int frame_count, std::vector<bool>& frames);
+
+// Which frames of a headless run are saved and the files they go to. A y4m pattern is a single
+// stream of all saved frames, any other gets the frame number through its placeholder or, without
+// one, appended to the file name when more than one frame is saved.
+export class FrameOutput {
+public:
+	// Returns false if selection is invalid, pattern was checked with FormatOutputPattern
+	bool Init(std::string_view pattern, std::string_view selection, int frame_count);
+
+	bool IsSaved(int frame) const { return frame >= 0 && frame < std::ssize(frames) && frames[frame]; }
+	auto GetPath(int frame) const -> std::string;
+
+private:
+	std::string       pattern;
+	std::vector<bool> frames;
+	bool              bStream     = false;
+	int               saved_count = 0;
+};
@@ -0,0 +1,53 @@
+module FramePacer;
+
+import std;
+import Utils;
+
+void FramePacer::Init(FramePacerInfo const& info) {
+	this->info = info;
+	Reset();
+	error_ms.Clear();
+	missed_count = 0;
+}
+
+void FramePacer::SetInterval(std::chrono::nanoseconds interval) {
+	if (interval == info.interval) return;
+	info.interval = interval;
+	Reset();
+}
+
+void FramePacer::Wait() {
+	if (info.interval <= std::chrono::nanoseconds(0)) return;
+	Clock::time_point now = Clock::now();
+	if (next_deadline == Clock::time_point{}) {
+		next_deadline = now + info.interval;
+	}
+	if (next_deadline - now > info.spin_slack) {
+		std::this_thread::sleep_until(next_deadline - info.spin_slack);
+	}
+	while ((now = Clock::now()) < next_deadline) {
+		std::this_thread::yield();
+	}
+	Advance(now);
+}
+
+void FramePacer::Track() {
+	if (info.interval <= std::chrono::nanoseconds(0)) return;
+	Clock::time_point const now = Clock::now();
+	if (next_deadline == Clock::time_point{}) {
+		next_deadline = now + info.interval;
+		return;
+	}
+	Advance(now);
+}
+
+void FramePacer::Advance(Clock::time_point now) {
+	// A frame late by more than an interval restarts the schedule instead of rushing to catch up
+	if (now - next_deadline > info.interval) {
+		++missed_count;
+		next_deadline = now + info.interval;
+		return;
+	}
+	error_ms.Push(std::chrono::duration<float, std::milli>(now - next_deadline).count());
+	next_deadline += info.interval;
+}
@@ -0,0 +1,45 @@
+export module FramePacer;
+
+import std;
+import Utils;
+
+using u32 = std::uint32_t;
+
+export struct FramePacerInfo {
+	// Time between frames, 0 disables waiting
+	std::chrono::nanoseconds interval = std::chrono::nanoseconds(0);
+	// Last part before a deadline is spun instead of slept, sleeps overshoot by about this much
+	std::chrono::microseconds spin_slack = std::chrono::microseconds(1500);
+};
+
+// Paces frames on an absolute schedule, deadline n is start + n * interval,
+// so waking up late does not shift the following frames.
+export class FramePacer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	void Init(FramePacerInfo const& info);
+	void SetInterval(std::chrono::nanoseconds interval);
+
+	// Sleeps until spin_slack before the next deadline, then spins until it
+	void Wait();
+	// For frames paced by something else, e.g. waiting for presentation.
+	// Records the error against the schedule and advances it without waiting.
+	void Track();
+	// Starts the schedule over on the next Wait or Track, e.g. after a pause
+	void Reset() { next_deadline = {}; }
+
+	// Lateness of wake-ups relative to their deadlines in milliseconds, negative if early
+	auto GetErrorStats() const -> Utils::SampleStats { return error_ms.ComputeStats(); }
+	// Deadlines missed by more than a whole interval, the schedule is restarted after each
+	auto GetMissedCount() const -> u32 { return missed_count; }
+	auto GetInfo() const -> FramePacerInfo const& { return info; }
+
+private:
+	void Advance(Clock::time_point now);
+
+	FramePacerInfo         info;
+	Clock::time_point      next_deadline = {};
+	Utils::SampleRing<256> error_ms;
+	u32                    missed_count = 0;
+};
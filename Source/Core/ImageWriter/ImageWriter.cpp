@@ -0,0 +1,342 @@
+module ImageWriter;
+
+import std;
+
+namespace ImageWriter {
+
+namespace {
+
+using u8  = std::uint8_t;
+using u16 = std::uint16_t;
+using u64 = std::uint64_t;
+
+constexpr auto HalfToFloat(u16 half) -> float {
+	u32 const sign     = (half & 0x8000u) << 16;
+	u32 const exponent = (half >> 10) & 0x1f;
+	u32 const mantissa = half & 0x3ff;
+	if (exponent == 0x1f) {
+		return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+	}
+	if (exponent == 0) {
+		// Zero or subnormal
+		float const value = static_cast<float>(mantissa) * 0x1p-24f;
+		return sign ? -value : value;
+	}
+	return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+constexpr auto FloatToHalf(float value) -> u16 {
+	u32 const bits     = std::bit_cast<u32>(value);
+	u32 const sign     = (bits >> 16) & 0x8000;
+	u32 const exponent = (bits >> 23) & 0xff;
+	u32       mantissa = bits & 0x7fffff;
+	if (exponent == 0xff) {
+		return static_cast<u16>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	int const half_exponent = static_cast<int>(exponent) - 127 + 15;
+	if (half_exponent >= 0x1f) {
+		return static_cast<u16>(sign | 0x7c00);
+	}
+	if (half_exponent <= 0) {
+		if (half_exponent < -10) {
+			return static_cast<u16>(sign);
+		}
+		mantissa |= 0x800000;
+		u32 const shift         = static_cast<u32>(14 - half_exponent);
+		u32       half_mantissa = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) ++half_mantissa;
+		return static_cast<u16>(sign | half_mantissa);
+	}
+	u32 half = sign | (static_cast<u32>(half_exponent) << 10) | (mantissa >> 13);
+	// Rounding may carry into the exponent, which gives the correct result
+	if (mantissa & 0x1000) ++half;
+	return static_cast<u16>(half);
+}
+
+// Reads channel c of pixel i as a float in [0, 1] for unorm, unclamped for half
+auto ReadChannel(ImageData const& image, std::size_t pixel, u32 channel) -> float {
+	if (image.pixel_format == PixelFormat::eRGBA16F) {
+		u16 half;
+		std::memcpy(&half, image.pixels.data() + pixel * 8 + channel * 2, sizeof(half));
+		return HalfToFloat(half);
+	}
+	return std::to_integer<u8>(image.pixels[pixel * 4 + channel]) / 255.0f;
+}
+
+auto ReadChannel8(ImageData const& image, std::size_t pixel, u32 channel) -> u8 {
+	if (image.pixel_format == PixelFormat::eRGBA8) {
+		return std::to_integer<u8>(image.pixels[pixel * 4 + channel]);
+	}
+	return static_cast<u8>(std::clamp(ReadChannel(image, pixel, channel), 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+struct ByteWriter {
+	std::vector<u8> data;
+
+	void Bytes(std::span<u8 const> bytes) { data.insert(data.end(), bytes.begin(), bytes.end()); }
+	void String(std::string_view str) { data.insert(data.end(), str.begin(), str.end()); }
+	void U8(u8 value) { data.push_back(value); }
+	void U16LE(u16 value) {
+		U8(static_cast<u8>(value));
+		U8(static_cast<u8>(value >> 8));
+	}
+	void U32LE(u32 value) {
+		U16LE(static_cast<u16>(value));
+		U16LE(static_cast<u16>(value >> 16));
+	}
+	void U64LE(u64 value) {
+		U32LE(static_cast<u32>(value));
+		U32LE(static_cast<u32>(value >> 32));
+	}
+	void U32BE(u32 value) {
+		U16LE(std::byteswap(static_cast<u16>(value >> 16)));
+		U16LE(std::byteswap(static_cast<u16>(value)));
+	}
+	void F32LE(float value) { U32LE(std::bit_cast<u32>(value)); }
+};
+
+auto EncodePPM(ImageData const& image) -> std::vector<u8> {
+	ByteWriter writer;
+	writer.String(std::format("P6\n{} {}\n255\n", image.width, image.height));
+	std::size_t const pixel_count = std::size_t(image.width) * image.height;
+	writer.data.reserve(writer.data.size() + pixel_count * 3);
+	for (std::size_t pixel = 0; pixel < pixel_count; ++pixel) {
+		for (u32 channel = 0; channel < 3; ++channel) {
+			writer.U8(ReadChannel8(image, pixel, channel));
+		}
+	}
+	return std::move(writer.data);
+}
+
+constexpr auto kCrcTable = [] {
+	std::array<u32, 256> table{};
+	for (u32 n = 0; n < 256; ++n) {
+		u32 c = n;
+		for (int k = 0; k < 8; ++k) {
+			c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		}
+		table[n] = c;
+	}
+	return table;
+}();
+
+auto Crc32(std::span<u8 const> bytes, u32 crc = 0) -> u32 {
+	crc = ~crc;
+	for (u8 const byte : bytes) {
+		crc = kCrcTable[(crc ^ byte) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+auto Adler32(std::span<u8 const> bytes) -> u32 {
+	u32 a = 1, b = 0;
+	for (u8 const byte : bytes) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+void WritePngChunk(ByteWriter& writer, char const (&type)[5], std::span<u8 const> chunk) {
+	writer.U32BE(static_cast<u32>(chunk.size()));
+	std::size_t const crc_begin = writer.data.size();
+	writer.String({type, 4});
+	writer.Bytes(chunk);
+	writer.U32BE(Crc32(std::span(writer.data).subspan(crc_begin)));
+}
+
+// Uncompressed deflate: exports are throughput bound, the encoder should not be the bottleneck
+auto EncodePNG(ImageData const& image) -> std::vector<u8> {
+	std::vector<u8> raw;
+	raw.reserve((std::size_t(image.width) * 4 + 1) * image.height);
+	for (u32 y = 0; y < image.height; ++y) {
+		raw.push_back(0); // filter: none
+		for (u32 x = 0; x < image.width; ++x) {
+			std::size_t const pixel = std::size_t(y) * image.width + x;
+			for (u32 channel = 0; channel < 4; ++channel) {
+				raw.push_back(ReadChannel8(image, pixel, channel));
+			}
+		}
+	}
+
+	ByteWriter zlib;
+	zlib.U8(0x78);
+	zlib.U8(0x01);
+	constexpr std::size_t kMaxBlockSize = 65535;
+	for (std::size_t offset = 0; offset < raw.size(); offset += kMaxBlockSize) {
+		std::size_t const size = std::min(kMaxBlockSize, raw.size() - offset);
+		zlib.U8(offset + size == raw.size() ? 1 : 0); // BFINAL, BTYPE = stored
+		zlib.U16LE(static_cast<u16>(size));
+		zlib.U16LE(static_cast<u16>(~size));
+		zlib.Bytes(std::span(raw).subspan(offset, size));
+	}
+	zlib.U32BE(Adler32(raw));
+
+	ByteWriter header;
+	header.U32BE(image.width);
+	header.U32BE(image.height);
+	header.U8(8); // bit depth
+	header.U8(6); // color type: RGBA
+	header.U8(0); // compression
+	header.U8(0); // filter
+	header.U8(0); // interlace
+
+	ByteWriter writer;
+	writer.Bytes(std::array<u8, 8>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'});
+	WritePngChunk(writer, "IHDR", header.data);
+	WritePngChunk(writer, "IDAT", zlib.data);
+	WritePngChunk(writer, "IEND", {});
+	return std::move(writer.data);
+}
+
+// Single part scanline file, half float channels, no compression
+auto EncodeEXR(ImageData const& image) -> std::vector<u8> {
+	ByteWriter writer;
+	writer.U32LE(20000630); // magic
+	writer.U32LE(2);        // version, single part scanline
+
+	auto Attribute = [&writer](std::string_view name, std::string_view type, u32 size) {
+		writer.String(name);
+		writer.U8(0);
+		writer.String(type);
+		writer.U8(0);
+		writer.U32LE(size);
+	};
+
+	// Channels are stored in alphabetical order
+	constexpr std::pair<char, u32> kChannels[] = {{'A', 3}, {'B', 2}, {'G', 1}, {'R', 0}};
+	Attribute("channels", "chlist", std::size(kChannels) * 18 + 1);
+	for (auto const& [name, index] : kChannels) {
+		writer.U8(name);
+		writer.U8(0);
+		writer.U32LE(1); // HALF
+		writer.U32LE(0); // pLinear and reserved
+		writer.U32LE(1); // x sampling
+		writer.U32LE(1); // y sampling
+	}
+	writer.U8(0);
+
+	Attribute("compression", "compression", 1);
+	writer.U8(0);
+	for (std::string_view window : {"dataWindow", "displayWindow"}) {
+		Attribute(window, "box2i", 16);
+		writer.U32LE(0);
+		writer.U32LE(0);
+		writer.U32LE(image.width - 1);
+		writer.U32LE(image.height - 1);
+	}
+	Attribute("lineOrder", "lineOrder", 1);
+	writer.U8(0);
+	Attribute("pixelAspectRatio", "float", 4);
+	writer.F32LE(1.0f);
+	Attribute("screenWindowCenter", "v2f", 8);
+	writer.F32LE(0.0f);
+	writer.F32LE(0.0f);
+	Attribute("screenWindowWidth", "float", 4);
+	writer.F32LE(1.0f);
+	writer.U8(0);
+
+	u32 const row_data_size = image.width * static_cast<u32>(std::size(kChannels)) * sizeof(u16);
+	u64 const rows_begin    = writer.data.size() + std::size_t(image.height) * sizeof(u64);
+	for (u32 y = 0; y < image.height; ++y) {
+		writer.U64LE(rows_begin + u64(y) * (row_data_size + 2 * sizeof(u32)));
+	}
+	for (u32 y = 0; y < image.height; ++y) {
+		writer.U32LE(y);
+		writer.U32LE(row_data_size);
+		for (auto const& [name, index] : kChannels) {
+			for (u32 x = 0; x < image.width; ++x) {
+				std::size_t const pixel = std::size_t(y) * image.width + x;
+				if (image.pixel_format == PixelFormat::eRGBA16F) {
+					writer.U8(std::to_integer<u8>(image.pixels[pixel * 8 + index * 2]));
+					writer.U8(std::to_integer<u8>(image.pixels[pixel * 8 + index * 2 + 1]));
+				} else {
+					writer.U16LE(FloatToHalf(ReadChannel(image, pixel, index)));
+				}
+			}
+		}
+	}
+	return std::move(writer.data);
+}
+
+} // namespace
+
+auto GetFileFormat(std::string_view path) -> std::optional<ImageFileFormat> {
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::ranges::transform(extension, extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == ".ppm") return ImageFileFormat::ePPM;
+	if (extension == ".png") return ImageFileFormat::ePNG;
+	if (extension == ".exr") return ImageFileFormat::eEXR;
+	if (extension == ".y4m") return ImageFileFormat::eY4M;
+	return std::nullopt;
+}
+
+bool WriteImage(std::string_view path, ImageData const& image) {
+	std::optional<ImageFileFormat> format = GetFileFormat(path);
+	if (!format.has_value() || format.value() == ImageFileFormat::eY4M || image.width == 0 || image.height == 0 ||
+		image.pixels.size() < std::size_t(image.width) * image.height * GetPixelSize(image.pixel_format)) {
+		return false;
+	}
+	std::vector<u8> data;
+	switch (format.value()) {
+	case ImageFileFormat::ePPM: data = EncodePPM(image); break;
+	case ImageFileFormat::ePNG: data = EncodePNG(image); break;
+	case ImageFileFormat::eEXR: data = EncodeEXR(image); break;
+	case ImageFileFormat::eY4M: return false;
+	}
+	std::ofstream file(std::string(path), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+	file.write(reinterpret_cast<char const*>(data.data()), data.size());
+	return static_cast<bool>(file);
+}
+
+auto EncodeY4MHeader(u32 width, u32 height, u32 fps_numerator, u32 fps_denominator) -> std::string {
+	return std::format("YUV4MPEG2 W{} H{} F{}:{} Ip A1:1 C420jpeg\n", width, height, fps_numerator, fps_denominator);
+}
+
+auto EncodeY4MFrame(ImageData const& image) -> std::vector<u8> {
+	constexpr std::string_view kFrameMarker  = "FRAME\n";
+	u32 const                  chroma_width  = (image.width + 1) / 2;
+	u32 const                  chroma_height = (image.height + 1) / 2;
+	std::size_t const          luma_size     = std::size_t(image.width) * image.height;
+	std::size_t const          chroma_size   = std::size_t(chroma_width) * chroma_height;
+
+	std::vector<u8> data(kFrameMarker.size() + luma_size + chroma_size * 2);
+	std::ranges::copy(kFrameMarker, data.begin());
+	u8* const luma = data.data() + kFrameMarker.size();
+	u8* const cb   = luma + luma_size;
+	u8* const cr   = cb + chroma_size;
+
+	auto const ToByte = [](float value) { return static_cast<u8>(std::clamp(value, 0.0f, 255.0f) + 0.5f); };
+	auto const Luma   = [](float r, float g, float b) { return 0.2126f * r + 0.7152f * g + 0.0722f * b; };
+	auto const Read   = [&](u32 x, u32 y, u32 channel) {
+		return std::clamp(ReadChannel(image, std::size_t(y) * image.width + x, channel), 0.0f, 1.0f);
+	};
+	for (u32 y = 0; y < image.height; ++y) {
+		for (u32 x = 0; x < image.width; ++x) {
+			luma[std::size_t(y) * image.width + x] = ToByte(16.0f + 219.0f * Luma(Read(x, y, 0), Read(x, y, 1), Read(x, y, 2)));
+		}
+	}
+	for (u32 chroma_y = 0; chroma_y < chroma_height; ++chroma_y) {
+		for (u32 chroma_x = 0; chroma_x < chroma_width; ++chroma_x) {
+			// Edge pixels are repeated for odd sizes
+			float r = 0.0f, g = 0.0f, b = 0.0f;
+			for (u32 sample = 0; sample < 4; ++sample) {
+				u32 const x = std::min(chroma_x * 2 + (sample & 1), image.width - 1);
+				u32 const y = std::min(chroma_y * 2 + (sample >> 1), image.height - 1);
+				r += Read(x, y, 0) * 0.25f;
+				g += Read(x, y, 1) * 0.25f;
+				b += Read(x, y, 2) * 0.25f;
+			}
+			float const       y_value = Luma(r, g, b);
+			std::size_t const index   = std::size_t(chroma_y) * chroma_width + chroma_x;
+			cb[index]                 = ToByte(128.0f + 224.0f * (b - y_value) / 1.8556f);
+			cr[index]                 = ToByte(128.0f + 224.0f * (r - y_value) / 1.5748f);
+		}
+	}
+	return data;
+}
+
+} // namespace ImageWriter
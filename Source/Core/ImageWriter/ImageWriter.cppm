@@ -0,0 +1,46 @@
+export module ImageWriter;
+
+import std;
+
+export namespace ImageWriter {
+
+using u32 = std::uint32_t;
+
+enum class ImageFileFormat {
+	ePPM,
+	ePNG,
+	eEXR,
+	eY4M, // raw video stream, written frame by frame with EncodeY4MHeader and EncodeY4MFrame
+};
+
+enum class PixelFormat {
+	eRGBA8,   // unorm, 4 bytes per pixel
+	eRGBA16F, // half float, 8 bytes per pixel
+};
+
+// Tightly packed rows, top row first
+struct ImageData {
+	u32                        width        = 0;
+	u32                        height       = 0;
+	PixelFormat                pixel_format = PixelFormat::eRGBA8;
+	std::span<std::byte const> pixels;
+};
+
+constexpr inline auto GetPixelSize(PixelFormat format) -> u32 {
+	return format == PixelFormat::eRGBA16F ? 8 : 4;
+}
+
+// Format from the file extension, empty if not supported
+auto GetFileFormat(std::string_view path) -> std::optional<ImageFileFormat>;
+
+// Converts between pixel formats as needed. PPM drops alpha, EXR is written as half float RGBA.
+// Fails for Y4M, a stream is not a single image.
+[[nodiscard]] bool WriteImage(std::string_view path, ImageData const& image);
+
+// Stream header of 4:2:0 frames at fps_numerator / fps_denominator frames per second
+auto EncodeY4MHeader(u32 width, u32 height, u32 fps_numerator, u32 fps_denominator) -> std::string;
+// FRAME marker and Y, Cb, Cr planes in BT.709 limited range, chroma averaged over 2x2 pixels.
+// Alpha is dropped.
+auto EncodeY4MFrame(ImageData const& image) -> std::vector<std::uint8_t>;
+
+} // namespace ImageWriter
@@ -34,21 +34,217 @@ void MessageCallbackDefault(LogLevel level, char const* message) {
 	}
 }
 
+auto LogLevelFromString(std::string_view name) -> std::optional<LogLevel> {
+	if (name == "trace") return LogLevel::Trace;
+	if (name == "info") return LogLevel::Info;
+	if (name == "warning") return LogLevel::Warning;
+	if (name == "error") return LogLevel::Error;
+	return std::nullopt;
+}
+
 Logger& Logger::Get() {
 	static Logger logger;
 	return logger;
 }
 
+Logger::Logger() : records(std::make_unique<Record[]>(kCapacity)) {
+	for (std::size_t i = 0; i < kCapacity; ++i) {
+		records[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	thread = std::jthread([this](std::stop_token stop_token) { ThreadMain(stop_token); });
+	bRunning.store(true, std::memory_order_release);
+}
+
+Logger::~Logger() {
+	thread.request_stop();
+	published.fetch_add(1, std::memory_order_release);
+	published.notify_one();
+	thread.join();
+	bRunning.store(false, std::memory_order_release);
+}
+
 void Logger::LogFormat(LogLevel level, char const* format, ...) {
-	char buffer[kMessageBufferSize];
+	if (!IsEnabled(level)) return;
+	// Formatted straight into the record, a dropped message is not formatted
+	bool const    bQueued  = level != LogLevel::Fatal && bRunning.load(std::memory_order_acquire);
+	std::uint64_t position = 0;
+	Record*       record   = bQueued ? Acquire(position) : nullptr;
+	if (bQueued && !record) return;
+	char         buffer[kMessageBufferSize];
+	char*        message = record ? record->message : buffer;
 	std::va_list args;
 	va_start(args, format);
-	int size = vsnprintf(buffer, sizeof(buffer) - 1, format, args);
+	vsnprintf(message, kMessageBufferSize - 1, format, args);
 	va_end(args);
-	buffer[sizeof(buffer) - 1] = '\0';
-	MessageCallbackDefault(level, buffer);
+	message[kMessageBufferSize - 1] = '\0';
+	if (record) {
+		record->level        = level;
+		record->bRateLimited = false;
+		Publish(*record, position);
+	} else {
+		Flush();
+		MessageCallbackDefault(level, message);
+	}
 }
 
 void Logger::Log(LogLevel level, char const* message) {
-	MessageCallbackDefault(level, message);	
-}
\ No newline at end of file
+	Push(level, false, message);
+}
+
+void Logger::LogRateLimited(LogLevel level, char const* message) {
+	Push(level, true, message);
+}
+
+void Logger::Push(LogLevel level, bool bRateLimited, char const* message) {
+	if (!IsEnabled(level)) return;
+	if (level == LogLevel::Fatal || !bRunning.load(std::memory_order_acquire)) {
+		Flush();
+		MessageCallbackDefault(level, message);
+		return;
+	}
+	std::uint64_t position;
+	Record*       record = Acquire(position);
+	if (!record) return;
+	std::size_t const size = std::min(std::strlen(message), std::size_t{kMessageBufferSize - 1});
+	std::memcpy(record->message, message, size);
+	record->message[size] = '\0';
+	record->level         = level;
+	record->bRateLimited  = bRateLimited;
+	Publish(*record, position);
+}
+
+// Bounded multi-producer queue, a record is free for the producer at position when its sequence equals
+// the position and written when it is position + 1
+auto Logger::Acquire(std::uint64_t& position) -> Record* {
+	position = enqueue_position.load(std::memory_order_relaxed);
+	for (;;) {
+		Record&            record = records[position & (kCapacity - 1)];
+		std::int64_t const diff   = static_cast<std::int64_t>(record.sequence.load(std::memory_order_acquire) - position);
+		if (diff == 0) {
+			if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &record;
+		} else if (diff < 0) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		} else {
+			position = enqueue_position.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void Logger::Publish(Record& record, std::uint64_t position) {
+	record.sequence.store(position + 1, std::memory_order_release);
+	published.fetch_add(1, std::memory_order_release);
+	published.notify_one();
+}
+
+void Logger::Flush() {
+	if (!bRunning.load(std::memory_order_acquire)) return;
+	std::uint64_t const target = enqueue_position.load(std::memory_order_acquire);
+	for (std::uint64_t position = written.load(std::memory_order_acquire); position < target;
+		 position               = written.load(std::memory_order_acquire)) {
+		written.wait(position, std::memory_order_acquire);
+	}
+	std::uint64_t const request = repeat_flush_requests.fetch_add(1, std::memory_order_acq_rel) + 1;
+	published.fetch_add(1, std::memory_order_release);
+	published.notify_one();
+	for (std::uint64_t done = repeat_flushes.load(std::memory_order_acquire); done < request;
+		 done               = repeat_flushes.load(std::memory_order_acquire)) {
+		repeat_flushes.wait(done, std::memory_order_acquire);
+	}
+}
+
+auto Logger::Drain() -> bool {
+	std::uint64_t       position = written.load(std::memory_order_relaxed);
+	std::uint64_t const start    = position;
+	for (;;) {
+		Record& record = records[position & (kCapacity - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != position + 1) break;
+		Write(record);
+		record.sequence.store(position + kCapacity, std::memory_order_release);
+		++position;
+	}
+	if (std::uint64_t const count = dropped.exchange(0, std::memory_order_relaxed)) {
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "%llu log messages dropped", static_cast<unsigned long long>(count));
+		MessageCallbackDefault(LogLevel::Warning, buffer);
+	}
+	if (position == start) return false;
+	written.store(position, std::memory_order_release);
+	written.notify_all();
+	return true;
+}
+
+void Logger::Write(Record const& record) {
+	if (!record.bRateLimited) {
+		MessageCallbackDefault(record.level, record.message);
+		return;
+	}
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	for (char const* c = record.message; *c; ++c) {
+		hash = (hash ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+	}
+	auto const now    = std::chrono::steady_clock::now();
+	auto       repeat = std::ranges::find(repeats, hash, &Repeat::hash);
+	if (repeat != repeats.end() && now - repeat->time < kRepeatInterval) {
+		++repeat->count;
+		return;
+	}
+	if (repeat == repeats.end()) {
+		repeat      = repeats.begin() + next_repeat;
+		next_repeat = (next_repeat + 1) % kRepeatCount;
+	}
+	// Count of the interval that passed or of the replaced message, unless already written
+	WriteRepeat(*repeat);
+	repeat->hash  = hash;
+	repeat->time  = now;
+	repeat->level = record.level;
+	std::memcpy(repeat->message, record.message, sizeof(repeat->message));
+	MessageCallbackDefault(record.level, record.message);
+}
+
+void Logger::WriteRepeat(Repeat& repeat) {
+	if (repeat.count == 0) return;
+	char buffer[kMessageBufferSize + 48];
+	std::snprintf(buffer, sizeof(buffer), "%s (repeated %u times)", repeat.message, repeat.count);
+	MessageCallbackDefault(repeat.level, buffer);
+	repeat.count = 0;
+}
+
+// Writes the counts whose interval passed, or all of them. Returns whether counts are left pending.
+auto Logger::WriteRepeats(bool bAll) -> bool {
+	auto const now      = std::chrono::steady_clock::now();
+	bool       bPending = false;
+	for (Repeat& repeat : repeats) {
+		if (bAll || now - repeat.time >= kRepeatInterval) {
+			WriteRepeat(repeat);
+		} else {
+			bPending |= repeat.count > 0;
+		}
+	}
+	return bPending;
+}
+
+void Logger::ThreadMain(std::stop_token stop_token) {
+	while (!stop_token.stop_requested()) {
+		std::uint64_t const seen    = published.load(std::memory_order_acquire);
+		std::uint64_t const request = repeat_flush_requests.load(std::memory_order_acquire);
+		Drain();
+		bool const bFlush   = request != repeat_flushes.load(std::memory_order_relaxed);
+		bool const bPending = WriteRepeats(bFlush);
+		if (bFlush) {
+			repeat_flushes.store(request, std::memory_order_release);
+			repeat_flushes.notify_all();
+		}
+		if (stop_token.stop_requested()) break;
+		if (!bPending) {
+			published.wait(seen, std::memory_order_acquire);
+		} else if (published.load(std::memory_order_acquire) == seen) {
+			// Atomic waits have no timeout, the interval of a pending count is polled
+			std::this_thread::sleep_for(kRepeatPollInterval);
+		}
+	}
+	Drain();
+	WriteRepeats(true);
+	repeat_flushes.store(repeat_flush_requests.load(std::memory_order_acquire), std::memory_order_release);
+	repeat_flushes.notify_all();
+}
@@ -1,4 +1,8 @@
+module;
+#include "LogConstants.hpp"
 export module Log;
+export import :Trace;
+import std;
 
 export
 enum class LogLevel {
@@ -9,7 +13,11 @@ enum class LogLevel {
 	Fatal,
 };	
 
+export auto LogLevelFromString(std::string_view name) -> std::optional<LogLevel>;
 
+// Messages are formatted on the calling thread into a fixed ring of records and written by a
+// background thread. When the ring is full new messages are dropped and their count reported.
+// Fatal messages are written synchronously after the ring is flushed.
 export
 class Logger {
 public:
@@ -19,7 +27,64 @@ public:
 	// Logging function
 	void LogFormat(LogLevel level, char const* format, ...);
 	void Log(LogLevel level, char const* message);
+	// Repeats of the same message within kRepeatInterval are counted instead of written,
+	// the count is written once the interval passes, on Flush and on shutdown
+	void LogRateLimited(LogLevel level, char const* message);
+
+	// Messages below the level are discarded before formatting
+	void SetLevel(LogLevel level) { min_level.store(level, std::memory_order_relaxed); }
+	auto GetLevel() const -> LogLevel { return min_level.load(std::memory_order_relaxed); }
+	bool IsEnabled(LogLevel level) const { return level >= GetLevel(); }
+
+	// Blocks until all messages logged before and pending repeat counts are written
+	void Flush();
+
+	static constexpr std::size_t kCapacity           = 256; // power of two
+	static constexpr auto        kRepeatInterval     = std::chrono::seconds(1);
+	static constexpr auto        kRepeatPollInterval = std::chrono::milliseconds(10);
+
 private:
-	Logger() = default;
-};
+	Logger();
+	~Logger();
+
+	struct Record {
+		std::atomic<std::uint64_t> sequence;
+		LogLevel                   level;
+		bool                       bRateLimited;
+		char                       message[kMessageBufferSize];
+	};
 
+	// Recently written rate limited messages, the oldest is replaced
+	struct Repeat {
+		std::uint64_t                         hash = 0;
+		std::chrono::steady_clock::time_point time;
+		std::uint32_t                         count = 0; // suppressed since time
+		LogLevel                              level = LogLevel::Trace;
+		char                                  message[kMessageBufferSize];
+	};
+	static constexpr std::size_t kRepeatCount = 64;
+
+	auto Acquire(std::uint64_t& position) -> Record*;
+	void Publish(Record& record, std::uint64_t position);
+	void Push(LogLevel level, bool bRateLimited, char const* message);
+	auto Drain() -> bool;
+	void Write(Record const& record);
+	void WriteRepeat(Repeat& repeat);
+	auto WriteRepeats(bool bAll) -> bool;
+	void ThreadMain(std::stop_token stop_token);
+
+	std::unique_ptr<Record[]> records;
+	alignas(64) std::atomic<std::uint64_t> enqueue_position      = 0;
+	alignas(64) std::atomic<std::uint64_t> published             = 0; // wakes the thread
+	alignas(64) std::atomic<std::uint64_t> written               = 0; // dequeue position, wakes Flush
+	std::atomic<std::uint64_t>             dropped               = 0;
+	std::atomic<std::uint64_t>             repeat_flush_requests = 0; // by Flush
+	std::atomic<std::uint64_t>             repeat_flushes        = 0; // requests done, wakes Flush
+	std::atomic<LogLevel>                  min_level             = LogLevel::Trace;
+	std::atomic<bool>                      bRunning              = false;
+
+	std::array<Repeat, kRepeatCount> repeats; // used by the thread only
+	std::size_t                      next_repeat = 0;
+
+	std::jthread thread;
+};
@@ -1,29 +1,69 @@
 #pragma once
 
+// Levels below LOG_MIN_LEVEL are compiled out: 0 trace, 1 info, 2 warning, 3 error.
+// The rest are filtered at runtime with Logger::SetLevel before their arguments are evaluated.
 #ifdef NO_LOGGING
-#define LOG_TRACE(fmt, ...)
-#define LOG_INFO(fmt, ...)
-#define LOG_WARN(fmt, ...)
-#define LOG_ERROR(fmt, ...)
-#else // NO_LOGGING
+#undef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 4
+#elif !defined(LOG_MIN_LEVEL)
+#define LOG_MIN_LEVEL 0
+#endif // NO_LOGGING
+
+#define LOG_IF_ENABLED(level, call) \
+	do { \
+		if (static_cast<int>(level) >= LOG_MIN_LEVEL && Logger::Get().IsEnabled(level)) Logger::Get().call; \
+	} while (0)
+
+#if LOG_MIN_LEVEL <= 0
 #define LOG_TRACE(fmt, ...) \
-	Logger::Get().LogFormat(LogLevel::Trace, fmt, ## __VA_ARGS__)
+	LOG_IF_ENABLED(LogLevel::Trace, LogFormat(LogLevel::Trace, fmt, ## __VA_ARGS__))
+#else
+#define LOG_TRACE(fmt, ...) do {} while (0)
+#endif
 
+#if LOG_MIN_LEVEL <= 1
 #define LOG_INFO(fmt, ...) \
-	Logger::Get().LogFormat(LogLevel::Info, fmt, ## __VA_ARGS__)
+	LOG_IF_ENABLED(LogLevel::Info, LogFormat(LogLevel::Info, fmt, ## __VA_ARGS__))
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
 
+#if LOG_MIN_LEVEL <= 2
 #define LOG_WARN(fmt, ...) \
-	Logger::Get().LogFormat(LogLevel::Warning, fmt, ## __VA_ARGS__)
+	LOG_IF_ENABLED(LogLevel::Warning, LogFormat(LogLevel::Warning, fmt, ## __VA_ARGS__))
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
 
+#if LOG_MIN_LEVEL <= 3
 #define LOG_ERROR(fmt, ...) \
-	Logger::Get().LogFormat(LogLevel::Error, fmt, ## __VA_ARGS__)
+	LOG_IF_ENABLED(LogLevel::Error, LogFormat(LogLevel::Error, fmt, ## __VA_ARGS__))
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
 
 #define LOG_MESSAGE(level, message) \
-	Logger::Get().Log(level, message)
-#endif // NO_LOGGING
+	LOG_IF_ENABLED(level, Log(level, message))
+
+// Repeats of the same message within a second are counted, e.g. for validation messages
+#define LOG_MESSAGE_RATE_LIMITED(level, message) \
+	LOG_IF_ENABLED(level, LogRateLimited(level, message))
+
+// Scoped zone written to the trace, the name must be a string literal
+#ifdef NO_TRACING
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+#else // NO_TRACING
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) \
+	TraceZone const TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) \
+	Tracer::Get().SetThreadName(name)
+#endif // NO_TRACING
 
 
 extern void HandleLogFatalError(char const* file, int line, char const* fmt, ...);
 
 #define LOG_FATAL(fmt, ...) \
-	HandleLogFatalError(__FILE__, __LINE__, fmt, ## __VA_ARGS__)
\ No newline at end of file
+	HandleLogFatalError(__FILE__, __LINE__, fmt, ## __VA_ARGS__)
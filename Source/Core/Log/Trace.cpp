@@ -0,0 +1,80 @@
+module Log;
+import std;
+
+thread_local Tracer::ThreadBuffer* Tracer::thread_buffer = nullptr;
+
+Tracer& Tracer::Get() {
+	static Tracer tracer;
+	return tracer;
+}
+
+void Tracer::Start() {
+	start = std::chrono::steady_clock::now();
+	bEnabled.store(true, std::memory_order_release);
+}
+
+auto Tracer::GetThreadBuffer() -> ThreadBuffer& {
+	if (thread_buffer) [[likely]] return *thread_buffer;
+	auto buffer         = std::make_unique<ThreadBuffer>();
+	buffer->chunks      = std::make_unique<std::unique_ptr<Chunk>[]>(kMaxChunks);
+	buffer->chunks[0]   = std::make_unique<Chunk>();
+	buffer->chunk_count = 1;
+	std::lock_guard lock(threads_mutex);
+	buffer->id    = static_cast<std::uint32_t>(threads.size() + 1);
+	thread_buffer = threads.emplace_back(std::move(buffer)).get();
+	return *thread_buffer;
+}
+
+void Tracer::AddZone(char const* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+	if (!IsEnabled()) return;
+	ThreadBuffer&     buffer      = GetThreadBuffer();
+	std::size_t const chunk_count = buffer.chunk_count.load(std::memory_order_relaxed);
+	Chunk*            chunk       = buffer.chunks[chunk_count - 1].get();
+	std::size_t       count       = chunk->count.load(std::memory_order_relaxed);
+	if (count == kChunkSize) {
+		if (chunk_count == kMaxChunks) return;
+		buffer.chunks[chunk_count] = std::make_unique<Chunk>();
+		chunk                      = buffer.chunks[chunk_count].get();
+		count                      = 0;
+		buffer.chunk_count.store(chunk_count + 1, std::memory_order_release);
+	}
+	chunk->zones[count] = {.name = name, .begin = begin, .end = end};
+	chunk->count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(char const* name) {
+	if (!IsEnabled()) return;
+	GetThreadBuffer().name.store(name, std::memory_order_release);
+}
+
+bool Tracer::Write(std::filesystem::path const& path) const {
+	std::FILE* file = std::fopen(path.string().c_str(), "w");
+	if (!file) return false;
+	auto const ToMicroseconds = [](std::chrono::steady_clock::duration duration) {
+		return std::chrono::duration<double, std::micro>(duration).count();
+	};
+	std::fprintf(file, "{\"traceEvents\":[\n");
+	char const* separator = "";
+	{
+		std::lock_guard lock(threads_mutex);
+		for (std::unique_ptr<ThreadBuffer> const& thread : threads) {
+			if (char const* name = thread->name.load(std::memory_order_acquire)) {
+				std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+							 separator, thread->id, name);
+				separator = ",\n";
+			}
+			std::size_t const chunk_count = thread->chunk_count.load(std::memory_order_acquire);
+			for (std::size_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index) {
+				Chunk const&      chunk = *thread->chunks[chunk_index];
+				std::size_t const count = chunk.count.load(std::memory_order_acquire);
+				for (Zone const& zone : std::span(chunk.zones).first(count)) {
+					std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+								 separator, zone.name, thread->id, ToMicroseconds(zone.begin - start), ToMicroseconds(zone.end - zone.begin));
+					separator = ",\n";
+				}
+			}
+		}
+	}
+	std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	return std::fclose(file) == 0;
+}
@@ -0,0 +1,75 @@
+export module Log:Trace;
+import std;
+
+// Scoped zones recorded to per-thread buffers and written as Chrome trace event JSON, for
+// chrome://tracing or Perfetto. Recording takes no lock, a thread takes one only for its first zone.
+export
+class Tracer {
+public:
+	static Tracer& Get();
+
+	// Zones are recorded from now on
+	void Start();
+	bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+
+	// Names must outlive the tracer, e.g. string literals
+	void AddZone(char const* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+	void SetThreadName(char const* name);
+
+	// Writes the zones of all threads recorded so far, times are relative to Start
+	bool Write(std::filesystem::path const& path) const;
+
+	static constexpr std::size_t kChunkSize = 4096; // zones
+	static constexpr std::size_t kMaxChunks = 1024; // per thread, later zones are dropped
+
+private:
+	Tracer() = default;
+
+	struct Zone {
+		char const*                           name;
+		std::chrono::steady_clock::time_point begin;
+		std::chrono::steady_clock::time_point end;
+	};
+
+	// Zones below count are complete and never change
+	struct Chunk {
+		std::array<Zone, kChunkSize> zones;
+		std::atomic<std::size_t>     count = 0;
+	};
+
+	// Written only by its thread, read by Write
+	struct ThreadBuffer {
+		std::uint32_t                             id;
+		std::atomic<char const*>                  name = nullptr;
+		std::unique_ptr<std::unique_ptr<Chunk>[]> chunks;
+		std::atomic<std::size_t>                  chunk_count = 0;
+	};
+
+	auto GetThreadBuffer() -> ThreadBuffer&;
+
+	static thread_local ThreadBuffer* thread_buffer;
+
+	std::atomic<bool>                          bEnabled = false;
+	std::chrono::steady_clock::time_point      start;
+	mutable std::mutex                         threads_mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+};
+
+// Records the time until the end of the scope while the tracer is enabled
+export
+class TraceZone {
+public:
+	explicit TraceZone(char const* name) : name(name) {
+		if (Tracer::Get().IsEnabled()) begin = std::chrono::steady_clock::now();
+	}
+	~TraceZone() {
+		if (begin != std::chrono::steady_clock::time_point{}) Tracer::Get().AddZone(name, begin, std::chrono::steady_clock::now());
+	}
+
+	TraceZone(TraceZone const&)            = delete;
+	TraceZone& operator=(TraceZone const&) = delete;
+
+private:
+	char const*                           name;
+	std::chrono::steady_clock::time_point begin = {};
+};
@@ -0,0 +1,48 @@
+module Playlist;
+
+import std;
+import ShaderCompiler;
+import Utils;
+
+namespace {
+// Whether source defines main, shared code included or imported by shaders does not
+auto HasEntryPoint(std::string_view source) -> bool {
+	auto const IsIdentifierChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	for (std::size_t pos = source.find("main"); pos != std::string_view::npos; pos = source.find("main", pos + 1)) {
+		std::size_t const next = source.find_first_not_of(" \t\r\n", pos + 4);
+		if ((pos == 0 || !IsIdentifierChar(source[pos - 1])) && next != std::string_view::npos && source[next] == '(') return true;
+	}
+	return false;
+}
+} // namespace
+
+auto CollectShaderPaths(std::span<char const* const> args) -> std::vector<std::filesystem::path> {
+	auto const IsImageShader = [](std::filesystem::path const& path) {
+		return IsShaderFile(path.string()) && !path.stem().extension().string().starts_with(".buffer");
+	};
+	std::vector<std::filesystem::path> paths;
+	for (std::filesystem::path const arg : args) {
+		std::error_code error;
+		if (!std::filesystem::is_directory(arg, error)) {
+			paths.push_back(arg);
+			continue;
+		}
+		std::vector<std::filesystem::path> directory_paths;
+		std::vector<std::filesystem::path> dependencies;
+		for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(arg, error)) {
+			if (!entry.is_regular_file(error) || !IsShaderFile(entry.path().string())) continue;
+			std::optional<std::string> const source = Utils::ReadFile(entry.path().string());
+			if (!source.has_value()) continue;
+			for (std::string const& name : FindShaderDependencies(source.value())) {
+				dependencies.push_back((arg / name).lexically_normal());
+			}
+			if (IsImageShader(entry.path()) && HasEntryPoint(source.value())) {
+				directory_paths.push_back(entry.path().lexically_normal());
+			}
+		}
+		std::erase_if(directory_paths, [&](std::filesystem::path const& path) { return std::ranges::contains(dependencies, path); });
+		std::ranges::sort(directory_paths);
+		paths.append_range(directory_paths);
+	}
+	return paths;
+}
@@ -0,0 +1,94 @@
+export module Playlist;
+
+import std;
+
+using u32 = std::uint32_t;
+
+// Shader files given on the command line, directories are replaced by the shaders in them.
+// Buffer pass files are drawn with their image shader and not listed on their own, neither are
+// files of a directory without an entry point or included or imported by another one.
+export auto CollectShaderPaths(std::span<char const* const> args) -> std::vector<std::filesystem::path>;
+
+export struct PlaylistInfo {
+	// Seconds each entry is shown, 0 to switch only on request
+	float interval = 0.0f;
+};
+
+// Shaders shown in turn. All are built up front, switching between them only swaps what was
+// built, Data of an entry. The shown entry's Data is owned by the caller while it is shown.
+export template <typename Data>
+class Playlist {
+public:
+	struct Entry {
+		std::filesystem::path           path;
+		Data                            data;
+		std::filesystem::file_time_type build_time; // files written later are rebuilt when shown
+	};
+
+	void Init(std::span<std::filesystem::path const> paths, PlaylistInfo const& info) {
+		this->info = info;
+		entries.clear();
+		for (std::filesystem::path const& path : paths) {
+			entries.push_back({.path = path});
+		}
+		index = 0;
+	}
+	void Clear() { entries.clear(); }
+
+	// Builds the entries after the shown first one on thread_count threads, each takes the next
+	// unbuilt entry. build gets the index of its thread for per-thread state and returns whether
+	// the entry was built. Returns the number of entries built.
+	template <typename Build>
+	auto Precompile(u32 thread_count, Build const& build) -> u32 {
+		std::atomic<std::size_t> next_entry  = 1;
+		std::atomic<u32>         built_count = 0;
+		{
+			std::vector<std::jthread> workers;
+			for (u32 worker = 0; worker < thread_count; ++worker) {
+				workers.emplace_back([this, worker, &build, &next_entry, &built_count] {
+					for (std::size_t index = next_entry++; index < entries.size(); index = next_entry++) {
+						Entry& entry     = entries[index];
+						entry.build_time = std::filesystem::file_time_type::clock::now();
+						if (build(worker, entry)) ++built_count;
+					}
+				});
+			}
+		}
+		entries[0].build_time = std::filesystem::file_time_type::clock::now();
+		RestartInterval();
+		return built_count;
+	}
+
+	// Index of the entry shown after the current one, direction -1 for the one before
+	auto GetNextIndex(int direction = 1) const -> std::size_t {
+		return (index + entries.size() + direction) % entries.size();
+	}
+	// Makes index the shown entry and restarts its interval
+	void SetIndex(std::size_t index) {
+		this->index = index;
+		RestartInterval();
+	}
+	void RestartInterval() { switch_time = std::chrono::steady_clock::now(); }
+
+	// Whether entries switch by themselves
+	bool IsTimed() const { return !entries.empty() && info.interval > 0.0f; }
+	bool IsSwitchDue() const { return IsTimed() && GetTimeToSwitch() <= 0.0; }
+	// Seconds until the shown entry's interval has passed
+	auto GetTimeToSwitch() const -> double {
+		std::chrono::duration<double> const shown = std::chrono::steady_clock::now() - switch_time;
+		return std::max(info.interval - shown.count(), 0.0);
+	}
+
+	bool IsEmpty() const { return entries.empty(); }
+	auto GetSize() const -> std::size_t { return entries.size(); }
+	auto GetIndex() const -> std::size_t { return index; }
+	auto GetInfo() const -> PlaylistInfo const& { return info; }
+	auto GetEntries() -> std::span<Entry> { return entries; }
+	auto operator[](std::size_t index) -> Entry& { return entries[index]; }
+
+private:
+	PlaylistInfo                          info;
+	std::vector<Entry>                    entries; // empty for a single shader
+	std::size_t                           index = 0;
+	std::chrono::steady_clock::time_point switch_time;
+};
@@ -0,0 +1,39 @@
+module ResolutionScaler;
+
+import std;
+import Utils;
+
+namespace {
+// Largest change of one adjustment, a single noisy interval cannot swing the scale far
+constexpr float kMaxStep = 1.25f;
+} // namespace
+
+void ResolutionScaler::Init(ResolutionScalerInfo const& info) {
+	this->info   = info;
+	scale        = std::clamp(info.scale, info.min_scale, info.max_scale);
+	settle_count = 0;
+	frame_times_ms.clear();
+	frame_times_ms.reserve(info.interval);
+}
+
+bool ResolutionScaler::AddFrameTime(float gpu_ms) {
+	if (!IsAdaptive() || gpu_ms <= 0.0f) return false;
+	if (settle_count > 0) {
+		--settle_count;
+		return false;
+	}
+	frame_times_ms.push_back(gpu_ms);
+	if (frame_times_ms.size() < info.interval) return false;
+
+	float const measured_ms = Utils::ComputeStatsInPlace(frame_times_ms).p50;
+	frame_times_ms.clear();
+	float const ratio = info.target_ms / measured_ms;
+	if (std::abs(ratio - 1.0f) <= info.tolerance) return false;
+
+	float const step      = std::clamp(std::sqrt(ratio), 1.0f / kMaxStep, kMaxStep);
+	float const new_scale = std::clamp(scale * step, info.min_scale, info.max_scale);
+	if (new_scale == scale) return false;
+	scale        = new_scale;
+	settle_count = info.settle_frames;
+	return true;
+}
@@ -0,0 +1,41 @@
+export module ResolutionScaler;
+
+import std;
+import Utils;
+
+using u32 = std::uint32_t;
+
+export struct ResolutionScalerInfo {
+	// Fraction of the window size rendered, kept fixed without a target
+	float scale = 1.0f;
+	// GPU frame time to hold in milliseconds, 0 disables adjusting
+	float target_ms = 0.0f;
+	float min_scale = 0.25f;
+	float max_scale = 1.0f;
+	// Frames measured before each adjustment, their median is compared to the target
+	u32 interval = 30;
+	// Frames ignored after a change, they were recorded at the old scale
+	u32 settle_frames = 4;
+	// Relative distance from the target that is left alone, keeps the scale from oscillating
+	float tolerance = 0.05f;
+};
+
+// Adjusts the render scale from measured GPU frame times. Fragment cost grows with the pixel count,
+// so the scale moves by the square root of the ratio between target and measured time.
+export class ResolutionScaler {
+public:
+	void Init(ResolutionScalerInfo const& info);
+
+	// Adds the GPU time of one frame, returns true if the scale changed
+	bool AddFrameTime(float gpu_ms);
+
+	auto GetScale() const -> float { return scale; }
+	bool IsAdaptive() const { return info.target_ms > 0.0f; }
+	auto GetInfo() const -> ResolutionScalerInfo const& { return info; }
+
+private:
+	ResolutionScalerInfo info;
+	float                scale        = 1.0f;
+	u32                  settle_count = 0;
+	std::vector<float>   frame_times_ms;
+};
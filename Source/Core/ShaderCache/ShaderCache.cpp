@@ -0,0 +1,133 @@
+module ShaderCache;
+
+import std;
+import FileIOUtils;
+
+static constexpr u32 kSpirvMagic = 0x07230203;
+
+bool ShaderCache::Init(ShaderCacheInfo const& info) {
+	this->info = info;
+	bEnabled   = false;
+	total_size = 0;
+
+	std::error_code error;
+	std::filesystem::create_directories(info.directory, error);
+	if (error) {
+		return false;
+	}
+	for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(info.directory, error)) {
+		if (entry.path().extension() == ".spv") {
+			total_size += entry.file_size(error);
+		}
+	}
+	bEnabled = true;
+	Evict();
+	return true;
+}
+
+auto ShaderCache::GetEntryPath(u64 key) const -> std::filesystem::path {
+	return info.directory / std::format("{:016x}.spv", key);
+}
+
+auto ShaderCache::GetDiagnosticsPath(u64 key) const -> std::filesystem::path {
+	return info.directory / std::format("{:016x}.log", key);
+}
+
+auto ShaderCache::Load(u64 key) -> std::optional<ShaderCacheEntry> {
+	if (!bEnabled) {
+		return std::nullopt;
+	}
+	std::filesystem::path const           path = GetEntryPath(key);
+	std::optional<std::vector<std::byte>> code = Utils::ReadBinaryFile(path.string());
+	if (!code.has_value() || code.value().size() < sizeof(u32) || code.value().size() % sizeof(u32) != 0) {
+		++miss_count;
+		return std::nullopt;
+	}
+	spirv.resize(code.value().size() / sizeof(u32));
+	std::memcpy(spirv.data(), code.value().data(), code.value().size());
+	if (spirv[0] != kSpirvMagic) {
+		++miss_count;
+		return std::nullopt;
+	}
+
+	diagnostics = Utils::ReadFile(GetDiagnosticsPath(key).string()).value_or(std::string{});
+
+	// Mark as recently used
+	std::error_code error;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	++hit_count;
+	return ShaderCacheEntry{.spirv = spirv, .diagnostics = diagnostics};
+}
+
+bool ShaderCache::Store(u64 key, std::span<u32 const> code, std::string_view diagnostics) {
+	if (!bEnabled || code.empty()) {
+		return false;
+	}
+	std::filesystem::path const path      = GetEntryPath(key);
+	std::filesystem::path const temp_path = std::filesystem::path(path).concat(".tmp");
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(reinterpret_cast<char const*>(code.data()), code.size_bytes());
+		if (!file) {
+			return false;
+		}
+	}
+
+	// Written before the SPIR-V, a reader finding the entry finds its diagnostics too
+	std::error_code             error;
+	std::filesystem::path const diagnostics_path = GetDiagnosticsPath(key);
+	if (diagnostics.empty()) {
+		std::filesystem::remove(diagnostics_path, error);
+	} else {
+		std::ofstream file(diagnostics_path, std::ios::binary | std::ios::trunc);
+		file.write(diagnostics.data(), diagnostics.size());
+		if (!file) {
+			std::filesystem::remove(temp_path, error);
+			return false;
+		}
+	}
+
+	std::uintmax_t const old_size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+	std::filesystem::rename(temp_path, path, error);
+	if (error) {
+		std::filesystem::remove(temp_path, error);
+		return false;
+	}
+	total_size = total_size - std::min(old_size, total_size) + code.size_bytes();
+	Evict();
+	return true;
+}
+
+void ShaderCache::Evict() {
+	if (total_size <= info.max_size) {
+		return;
+	}
+	struct Entry {
+		std::filesystem::path           path;
+		std::filesystem::file_time_type last_use;
+		std::uintmax_t                  size;
+	};
+	std::vector<Entry> entries;
+	std::error_code    error;
+	for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(info.directory, error)) {
+		if (entry.path().extension() != ".spv") continue;
+		entries.push_back({entry.path(), entry.last_write_time(error), entry.file_size(error)});
+	}
+	std::ranges::sort(entries, std::less{}, &Entry::last_use);
+
+	// Recount, other sessions may share the directory
+	total_size = 0;
+	for (Entry const& entry : entries) {
+		total_size += entry.size;
+	}
+	for (Entry const& entry : entries) {
+		if (total_size <= info.max_size) break;
+		if (std::filesystem::remove(entry.path, error)) {
+			total_size -= entry.size;
+			std::filesystem::remove(std::filesystem::path(entry.path).replace_extension(".log"), error);
+		}
+	}
+}
@@ -0,0 +1,45 @@
+export module ShaderCache;
+
+import std;
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+export struct ShaderCacheInfo {
+	std::filesystem::path directory;
+	// Least recently used entries are removed above this total
+	std::uintmax_t max_size = 64 * 1024 * 1024;
+};
+
+export struct ShaderCacheEntry {
+	std::span<u32 const> spirv;
+	std::string_view     diagnostics; // compiler output stored with it, empty for a clean build
+};
+
+// Compiled SPIR-V stored on disk by content key, shared between sessions.
+// One file per entry and one for its diagnostics, last write time tracks the last use.
+export class ShaderCache {
+public:
+	bool Init(ShaderCacheInfo const& info);
+
+	// Returned views stay valid until the next Load
+	[[nodiscard]] auto Load(u64 key) -> std::optional<ShaderCacheEntry>;
+	bool               Store(u64 key, std::span<u32 const> code, std::string_view diagnostics = {});
+
+	auto GetHitCount() const -> u32 { return hit_count; }
+	auto GetMissCount() const -> u32 { return miss_count; }
+	auto GetTotalSize() const -> std::uintmax_t { return total_size; }
+
+private:
+	auto GetEntryPath(u64 key) const -> std::filesystem::path;
+	auto GetDiagnosticsPath(u64 key) const -> std::filesystem::path;
+	void Evict();
+
+	ShaderCacheInfo  info;
+	std::vector<u32> spirv;
+	std::string      diagnostics;
+	std::uintmax_t   total_size = 0;
+	u32              hit_count  = 0;
+	u32              miss_count = 0;
+	bool             bEnabled   = false;
+};
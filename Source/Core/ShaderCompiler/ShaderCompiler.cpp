@@ -1,14 +1,109 @@
 module;
 // #include <cassert> // assert
 #include <cstdarg> // va_start, va_end
+#include <cstdio>  // popen, pclose
+#ifdef SHADER_PLAYGROUND_SHADERC
+#include <shaderc/shaderc.h>
+#endif
+#ifdef SHADER_PLAYGROUND_SLANG
+#include <slang.h>
+#include <slang-com-ptr.h>
+#endif
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#endif
 module ShaderCompiler;
 
 import std;
-import FileIOUtils;
+import Utils;
 
-bool ShaderCompiler::Init() { return true; };
+#ifdef SHADER_PLAYGROUND_SLANG
+// Library module loaded by a Slang session, kept as a binary in the module cache directory
+struct SlangLibrary {
+	std::string                     name;
+	std::filesystem::path           path;
+	std::filesystem::file_time_type write_time;
+	bool                            bCached = false; // binary written for this write_time
+};
+#endif
+
+struct InProcessCompiler {
+#ifdef SHADER_PLAYGROUND_SHADERC
+	shaderc_compiler_t compiler = nullptr;
+#endif
+#ifdef SHADER_PLAYGROUND_SLANG
+	// Imported modules stay loaded between compilations, the user file is loaded again under a new name
+	// each time. A new session is created when an imported file or the options change, or after
+	// kMaxSlangSessionCompiles to drop the old user modules, libraries are then loaded from their binaries.
+	Slang::ComPtr<slang::ISession> slang_session;
+	std::string                    slang_session_options;
+	u32                            slang_session_compiles = 0;
+	std::vector<SlangLibrary>      slang_libraries;
+#endif
+};
+
+ShaderCompiler::ShaderCompiler() = default;
 ShaderCompiler::~ShaderCompiler() { Destroy(); }
-void ShaderCompiler::Destroy() { buffer.clear(); }
+
+#ifdef SHADER_PLAYGROUND_SLANG
+namespace {
+
+constexpr u32              kMaxSlangSessionCompiles = 32;
+constexpr std::string_view kSlangUserModulePrefix   = "shader_playground_user_";
+
+// Creating the global session takes hundreds of milliseconds, it is created once and shared by all
+// compilers. It is not thread safe, neither are sessions created from it.
+std::mutex                           gSlangMutex;
+Slang::ComPtr<slang::IGlobalSession> gSlangGlobalSession;
+
+auto GetSlangGlobalSession() -> slang::IGlobalSession* {
+	if (!gSlangGlobalSession && SLANG_FAILED(slang::createGlobalSession(gSlangGlobalSession.writeRef()))) {
+		gSlangGlobalSession = nullptr;
+	}
+	return gSlangGlobalSession.get();
+}
+
+} // namespace
+#endif // SHADER_PLAYGROUND_SLANG
+
+bool ShaderCompiler::Init() {
+#if defined(SHADER_PLAYGROUND_SHADERC) || defined(SHADER_PLAYGROUND_SLANG)
+	if (!in_process) {
+		in_process = std::make_unique<InProcessCompiler>();
+#ifdef SHADER_PLAYGROUND_SHADERC
+		in_process->compiler = shaderc_compiler_initialize();
+#endif
+	}
+#endif
+	return true;
+};
+
+void ShaderCompiler::Destroy() {
+#ifdef SHADER_PLAYGROUND_SHADERC
+	if (in_process) {
+		shaderc_compiler_release(in_process->compiler);
+	}
+#endif
+#ifdef SHADER_PLAYGROUND_SLANG
+	if (in_process) {
+		std::lock_guard lock(gSlangMutex);
+		in_process->slang_session = nullptr;
+	}
+#endif
+	in_process.reset();
+	buffer.clear();
+	spirv.clear();
+	diagnostics.clear();
+}
+
+bool ShaderCompiler::HasInProcessBackend() const {
+#if defined(SHADER_PLAYGROUND_SHADERC) || defined(SHADER_PLAYGROUND_SLANG)
+	return in_process != nullptr;
+#else
+	return false;
+#endif
+}
 
 int FormatAndResize(std::vector<std::byte>& buffer, char const* format, ...) {
 	va_list args;
@@ -26,36 +121,878 @@ int FormatAndResize(std::vector<std::byte>& buffer, char const* format, ...) {
 	return size;
 }
 
+static void AssignToBuffer(std::vector<std::byte>& buffer, std::string_view const str) {
+	buffer.resize(str.size() + 1);
+	std::memcpy(buffer.data(), str.data(), str.size());
+	buffer.back() = std::byte{0};
+}
+
+static auto GetFileExtension(std::string_view const path) -> std::string_view {
+	return path.substr(path.find_last_of('.') + 1);
+}
+
 bool ShaderCompiler::CompileShader(std::string_view path, std::string_view output_file_path, std::string_view compile_options) {
-	std::basic_string_view<char> const file_extension = path.substr(path.find_last_of('.') + 1);
+	last_backend = ShaderCompilerBackend::eExternalProcess;
+	return RunExternalCompiler(path, output_file_path, compile_options);
+}
+
+auto GetShaderStage(std::string_view path) -> ShaderStage {
+	return GetFileExtension(path) == "comp" ? ShaderStage::eCompute : ShaderStage::eFragment;
+}
+
+static auto GetExternalCompilerName(std::string_view const file_extension) -> char const* {
+	if (file_extension == "glsl" || file_extension == "frag" || file_extension == "comp") return "glslc";
+	if (file_extension == "slang") return "slangc";
+	return nullptr;
+}
+
+auto IsShaderFile(std::string_view path) -> bool {
+	return GetExternalCompilerName(GetFileExtension(path)) != nullptr;
+}
+
+// Runs command and captures its stdout, returns exit status or -1 if it could not be started
+static int RunCommand(char const* command, std::string& output) {
+	std::FILE* pipe = popen(command, "r");
+	if (!pipe) {
+		return -1;
+	}
+	char read_buffer[512];
+	while (std::size_t read = std::fread(read_buffer, 1, sizeof(read_buffer), pipe)) {
+		output.append(read_buffer, read);
+	}
+	return pclose(pipe);
+}
+
+// Prerequisites of a Makefile rule "target: a.h b.h \\" as written by glslc -MD and slangc -depfile.
+// Spaces in names are escaped with a backslash.
+static auto ParseDepfile(std::string_view text) -> std::vector<std::filesystem::path> {
+	std::vector<std::filesystem::path> paths;
+	std::size_t const                  colon_pos = text.find(": ");
+	if (colon_pos == std::string_view::npos) return paths;
+	text.remove_prefix(colon_pos + 2);
+	std::string name;
+	for (std::size_t i = 0; i <= text.size(); ++i) {
+		char const c = i < text.size() ? text[i] : '\n';
+		if (c == '\\' && i + 1 < text.size() && text[i + 1] == ' ') {
+			name += ' ';
+			++i;
+		} else if (c == '\\' && i + 1 < text.size() && (text[i + 1] == '\n' || text[i + 1] == '\r')) {
+			// Line continuation
+		} else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+			if (!name.empty()) paths.emplace_back(std::move(name));
+			name.clear();
+		} else {
+			name += c;
+		}
+	}
+	return paths;
+}
+
+bool ShaderCompiler::RunExternalCompiler(std::string_view path, std::string_view output_file_path, std::string_view compile_options) {
+	diagnostics.clear();
+	std::basic_string_view<char> const file_extension = GetFileExtension(path);
 
 	char const* user_options     = compile_options.empty() ? "" : compile_options.data();
-	char const* compiler         = "";
+	char const* compiler         = GetExternalCompilerName(file_extension);
 	char const* entry_flag       = "";
 	char const* target           = "";
 	char const* compiler_options = "";
-	if (file_extension == "glsl" || file_extension == "frag") {
-		compiler   = "glslc";
-		entry_flag = "-fentry-point=";
-	} else if (file_extension == "slang") {
-		compiler         = "slangc";
+	char const* depfile_flag     = "";
+	if (!compiler) {
+		FormatAndResize(buffer, "Unknown file extension: %s", file_extension.data());
+		return false;
+	}
+	if (file_extension == "slang") {
 		entry_flag       = "-entry ";
 		compiler_options = "-target spirv";
+		depfile_flag     = "-depfile";
 	} else {
-		FormatAndResize(buffer, "Unknown file extension: %s", file_extension.data());
-		return false;
+		entry_flag   = "-fentry-point=";
+		depfile_flag = "-MD -MF";
 	}
+	// Removed first, a depfile left by an earlier run must not be read if this one writes none
+	std::string const depfile_path = std::format("{}.d", output_file_path);
+	std::error_code   error;
+	std::filesystem::remove(depfile_path, error);
 
-	FormatAndResize(buffer, "%s %s %s -o %s %s%s %s %s",
+	// Capture compiler output to turn it into diagnostics
+	FormatAndResize(buffer, "%s %s %s -o %s %s%s %s %s %s %s 2>&1",
 					compiler, compiler_options, path.data(),
-					output_file_path.data(), entry_flag, "main", target, user_options);
+					output_file_path.data(), entry_flag, "main", depfile_flag, depfile_path.data(), target, user_options);
 
-	if (std::system(reinterpret_cast<char*>(buffer.data()))) {
+	std::string output;
+	int const   status = RunCommand(reinterpret_cast<char*>(buffer.data()), output);
+	if (status == -1) {
+		FormatAndResize(buffer, "Failed to run %s", compiler);
 		return false;
 	}
+
+	ParseDiagnostics(output);
+	AssignToBuffer(buffer, output);
+	if (status != 0) {
+		return false;
+	}
+	if (std::optional<std::string> depfile = Utils::ReadFile(depfile_path)) {
+		SetDependencies(path, ParseDepfile(depfile.value()));
+	}
 	return true;
 }
 
+void ShaderCompiler::SetDependencies(std::string_view path, std::vector<std::filesystem::path> paths) {
+	std::filesystem::path const shader_path = std::filesystem::absolute(path).lexically_normal();
+	for (std::filesystem::path& dependency : paths) {
+		dependency = std::filesystem::absolute(dependency).lexically_normal();
+	}
+	std::ranges::sort(paths);
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	std::erase(paths, shader_path);
+	dependencies = std::move(paths);
+}
+
+auto ShaderCompiler::CompileShaderToSpirv(std::string_view path, std::string_view output_file_path, std::string_view compile_options) -> std::optional<std::span<u32 const>> {
+	last_backend = SelectBackend(path, compile_options);
+	if (last_backend == ShaderCompilerBackend::eInProcess) {
+		if (!CompileInProcess(path, compile_options)) {
+			return std::nullopt;
+		}
+		return spirv;
+	}
+
+	if (!RunExternalCompiler(path, output_file_path, compile_options)) {
+		return std::nullopt;
+	}
+	std::optional<std::vector<std::byte>> code = Utils::ReadBinaryFile(output_file_path);
+	if (!code.has_value() || code.value().empty() || code.value().size() % sizeof(u32) != 0) {
+		FormatAndResize(buffer, "Failed to read compiled shader %s", output_file_path.data());
+		return std::nullopt;
+	}
+	spirv.resize(code.value().size() / sizeof(u32));
+	std::memcpy(spirv.data(), code.value().data(), code.value().size());
+	return spirv;
+}
+
+// Parses "file:line: severity: message" lines emitted by glslang/glslc
+// and "file(line): severity code: message" lines emitted by Slang
+void ShaderCompiler::ParseDiagnostics(std::string_view output) {
+	diagnostics.clear();
+	constexpr std::pair<std::string_view, ShaderDiagnosticSeverity> kSeverities[] = {
+		{": error: ", ShaderDiagnosticSeverity::eError},
+		{": warning: ", ShaderDiagnosticSeverity::eWarning},
+		{": note: ", ShaderDiagnosticSeverity::eNote},
+		{"): error ", ShaderDiagnosticSeverity::eError},
+		{"): warning ", ShaderDiagnosticSeverity::eWarning},
+		{"): note", ShaderDiagnosticSeverity::eNote},
+	};
+	while (!output.empty()) {
+		std::size_t const      line_end = output.find('\n');
+		std::string_view const line     = output.substr(0, line_end);
+		output.remove_prefix(line_end == std::string_view::npos ? output.size() : line_end + 1);
+
+		for (auto const& [marker, severity] : kSeverities) {
+			std::size_t const marker_pos = line.find(marker);
+			if (marker_pos == std::string_view::npos) continue;
+			// Slang puts the diagnostic code between severity and message
+			bool const       bSlang  = marker.starts_with(')');
+			std::string_view message = line.substr(marker_pos + marker.size());
+			if (bSlang) {
+				std::size_t const code_end = message.find(": ");
+				message.remove_prefix(code_end == std::string_view::npos ? 0 : code_end + 2);
+			}
+			ShaderDiagnostic diagnostic{
+				.severity = severity,
+				.message  = std::string(message),
+			};
+			std::string_view location  = line.substr(0, marker_pos);
+			std::size_t      colon_pos = location.find_last_of(bSlang ? '(' : ':');
+			if (colon_pos != std::string_view::npos) {
+				std::string_view line_number = location.substr(colon_pos + 1);
+				if (std::from_chars(line_number.data(), line_number.data() + line_number.size(), diagnostic.line).ec == std::errc{}) {
+					location = location.substr(0, colon_pos);
+				}
+			}
+			diagnostic.file = location;
+			diagnostics.push_back(std::move(diagnostic));
+			break;
+		}
+	}
+}
+
+#ifdef SHADER_PLAYGROUND_SHADERC
+namespace {
+
+struct InProcessOptions {
+	std::vector<std::pair<std::string, std::string>> macros;
+	std::vector<std::string>                         include_dirs;
+	std::optional<shaderc_optimization_level>        optimization_level;
+	std::optional<shaderc_env_version>               target_env_version;
+	std::optional<shaderc_spirv_version>             target_spirv_version;
+	bool                                             bDebugInfo = false;
+};
+
+// Understands the glslc flags that make sense for a single fragment shader.
+// Anything else makes the caller use the external compiler.
+bool ParseInProcessOptions(std::string_view options, InProcessOptions& out) {
+	constexpr std::string_view kWhitespaces = " \t\n\r";
+
+	auto NextToken = [&options, kWhitespaces]() -> std::string_view {
+		std::size_t const begin = options.find_first_not_of(kWhitespaces);
+		if (begin == std::string_view::npos) return {};
+		std::size_t const end   = options.find_first_of(kWhitespaces, begin);
+		std::string_view  token = options.substr(begin, end - begin);
+		options.remove_prefix(end == std::string_view::npos ? options.size() : end);
+		return token;
+	};
+
+	constexpr std::pair<std::string_view, shaderc_env_version> kTargetEnvs[] = {
+		{"vulkan1.0", shaderc_env_version_vulkan_1_0},
+		{"vulkan1.1", shaderc_env_version_vulkan_1_1},
+		{"vulkan1.2", shaderc_env_version_vulkan_1_2},
+		{"vulkan1.3", shaderc_env_version_vulkan_1_3},
+	};
+	constexpr std::pair<std::string_view, shaderc_spirv_version> kTargetSpirvs[] = {
+		{"spv1.0", shaderc_spirv_version_1_0},
+		{"spv1.1", shaderc_spirv_version_1_1},
+		{"spv1.2", shaderc_spirv_version_1_2},
+		{"spv1.3", shaderc_spirv_version_1_3},
+		{"spv1.4", shaderc_spirv_version_1_4},
+		{"spv1.5", shaderc_spirv_version_1_5},
+		{"spv1.6", shaderc_spirv_version_1_6},
+	};
+
+	for (std::string_view token = NextToken(); !token.empty(); token = NextToken()) {
+		if (token.starts_with("-D") && token.size() > 2) {
+			std::string_view  definition = token.substr(2);
+			std::size_t const equal_pos  = definition.find('=');
+			if (equal_pos == std::string_view::npos) {
+				out.macros.emplace_back(definition, "");
+			} else {
+				out.macros.emplace_back(definition.substr(0, equal_pos), definition.substr(equal_pos + 1));
+			}
+		} else if (token == "-I") {
+			std::string_view dir = NextToken();
+			if (dir.empty()) return false;
+			out.include_dirs.emplace_back(dir);
+		} else if (token.starts_with("-I")) {
+			out.include_dirs.emplace_back(token.substr(2));
+		} else if (token == "-O") {
+			out.optimization_level = shaderc_optimization_level_performance;
+		} else if (token == "-Os") {
+			out.optimization_level = shaderc_optimization_level_size;
+		} else if (token == "-O0") {
+			out.optimization_level = shaderc_optimization_level_zero;
+		} else if (token == "-g") {
+			out.bDebugInfo = true;
+		} else if (token.starts_with("--target-env=")) {
+			auto it = std::ranges::find(kTargetEnvs, token.substr(sizeof("--target-env=") - 1), &std::pair<std::string_view, shaderc_env_version>::first);
+			if (it == std::end(kTargetEnvs)) return false;
+			out.target_env_version = it->second;
+		} else if (token.starts_with("--target-spv=")) {
+			auto it = std::ranges::find(kTargetSpirvs, token.substr(sizeof("--target-spv=") - 1), &std::pair<std::string_view, shaderc_spirv_version>::first);
+			if (it == std::end(kTargetSpirvs)) return false;
+			out.target_spirv_version = it->second;
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct IncludeContext {
+	std::vector<std::string> const*     include_dirs;
+	std::vector<std::filesystem::path>* dependencies; // resolved includes, the first candidate of missing ones
+};
+
+struct IncludeResult {
+	shaderc_include_result result;
+	std::string            source_name;
+	std::string            content;
+};
+
+shaderc_include_result* ResolveInclude(void* user_data, char const* requested_source, int type,
+									   char const* requesting_source, std::size_t include_depth) {
+	IncludeContext const* context = static_cast<IncludeContext*>(user_data);
+	IncludeResult*        include = new IncludeResult{};
+
+	std::vector<std::filesystem::path> candidates;
+	if (type == shaderc_include_type_relative) {
+		candidates.push_back(std::filesystem::path(requesting_source).parent_path() / requested_source);
+	}
+	for (std::string const& dir : *context->include_dirs) {
+		candidates.push_back(std::filesystem::path(dir) / requested_source);
+	}
+	for (std::filesystem::path const& candidate : candidates) {
+		std::string candidate_string = candidate.lexically_normal().string();
+		if (std::optional<std::string> content = Utils::ReadFile(candidate_string)) {
+			include->source_name = std::move(candidate_string);
+			include->content     = std::move(content.value());
+			break;
+		}
+	}
+	// Empty source name reports an error with content as the message
+	if (include->source_name.empty()) {
+		include->content = std::string("Cannot find or open include file: ") + requested_source;
+		if (!candidates.empty()) context->dependencies->push_back(candidates.front().lexically_normal());
+	} else {
+		context->dependencies->emplace_back(include->source_name);
+	}
+
+	include->result = {
+		.source_name        = include->source_name.data(),
+		.source_name_length = include->source_name.size(),
+		.content            = include->content.data(),
+		.content_length     = include->content.size(),
+		.user_data          = include,
+	};
+	return &include->result;
+}
+
+void ReleaseInclude(void* user_data, shaderc_include_result* include_result) {
+	delete static_cast<IncludeResult*>(include_result->user_data);
+}
+
+} // namespace
+#endif // SHADER_PLAYGROUND_SHADERC
+
+#ifdef SHADER_PLAYGROUND_SHADERC
+static auto CreateCompileOptions(InProcessOptions const& parsed_options, IncludeContext* include_context) -> shaderc_compile_options_t {
+	shaderc_compile_options_t options = shaderc_compile_options_initialize();
+	for (auto const& [name, value] : parsed_options.macros) {
+		shaderc_compile_options_add_macro_definition(options, name.data(), name.size(), value.data(), value.size());
+	}
+	if (parsed_options.optimization_level.has_value()) {
+		shaderc_compile_options_set_optimization_level(options, parsed_options.optimization_level.value());
+	}
+	if (parsed_options.target_env_version.has_value()) {
+		shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, parsed_options.target_env_version.value());
+	}
+	if (parsed_options.target_spirv_version.has_value()) {
+		shaderc_compile_options_set_target_spirv(options, parsed_options.target_spirv_version.value());
+	}
+	if (parsed_options.bDebugInfo) {
+		shaderc_compile_options_set_generate_debug_info(options);
+	}
+	shaderc_compile_options_set_include_callbacks(options, ResolveInclude, ReleaseInclude, include_context);
+	return options;
+}
+
+static auto GetDefaultShaderKind(std::string_view path) -> shaderc_shader_kind {
+	return GetShaderStage(path) == ShaderStage::eCompute ? shaderc_glsl_default_compute_shader : shaderc_glsl_default_fragment_shader;
+}
+#endif // SHADER_PLAYGROUND_SHADERC
+
+#ifdef SHADER_PLAYGROUND_SLANG
+namespace {
+
+struct SlangOptions {
+	std::vector<std::pair<std::string, std::string>> macros;
+	std::vector<std::string>                         include_dirs;
+	std::optional<SlangOptimizationLevel>            optimization_level;
+	bool                                             bDebugInfo = false;
+};
+
+// Understands the slangc flags that only change the session, anything else makes the caller use slangc
+bool ParseSlangOptions(std::string_view options, SlangOptions& out) {
+	std::istringstream stream{std::string(options)};
+	for (std::string token; stream >> token;) {
+		if (token.starts_with("-D") && token.size() > 2) {
+			std::size_t const equal_pos = token.find('=');
+			if (equal_pos == std::string::npos) {
+				out.macros.emplace_back(token.substr(2), "");
+			} else {
+				out.macros.emplace_back(token.substr(2, equal_pos - 2), token.substr(equal_pos + 1));
+			}
+		} else if (token == "-I") {
+			if (!(stream >> token)) return false;
+			out.include_dirs.push_back(token);
+		} else if (token.starts_with("-I")) {
+			out.include_dirs.push_back(token.substr(2));
+		} else if (token == "-O0") {
+			out.optimization_level = SLANG_OPTIMIZATION_LEVEL_NONE;
+		} else if (token == "-O1") {
+			out.optimization_level = SLANG_OPTIMIZATION_LEVEL_DEFAULT;
+		} else if (token == "-O2") {
+			out.optimization_level = SLANG_OPTIMIZATION_LEVEL_HIGH;
+		} else if (token == "-O3") {
+			out.optimization_level = SLANG_OPTIMIZATION_LEVEL_MAXIMAL;
+		} else if (token == "-g") {
+			out.bDebugInfo = true;
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Contents of a module binary read from disk
+class SlangFileBlob final : public ISlangBlob {
+public:
+	explicit SlangFileBlob(std::vector<std::byte> data) : data(std::move(data)) {}
+
+	SLANG_NO_THROW SlangResult SLANG_MCALL queryInterface(SlangUUID const& uuid, void** out_object) override {
+		SlangUUID const blob_uuid    = ISlangBlob::getTypeGuid();
+		SlangUUID const unknown_uuid = ISlangUnknown::getTypeGuid();
+		if (std::memcmp(&uuid, &blob_uuid, sizeof(uuid)) == 0 || std::memcmp(&uuid, &unknown_uuid, sizeof(uuid)) == 0) {
+			addRef();
+			*out_object = static_cast<ISlangBlob*>(this);
+			return SLANG_OK;
+		}
+		*out_object = nullptr;
+		return SLANG_E_NO_INTERFACE;
+	}
+	SLANG_NO_THROW std::uint32_t SLANG_MCALL addRef() override { return ++ref_count; }
+	SLANG_NO_THROW std::uint32_t SLANG_MCALL release() override {
+		std::uint32_t const count = --ref_count;
+		if (count == 0) delete this;
+		return count;
+	}
+	SLANG_NO_THROW void const* SLANG_MCALL getBufferPointer() override { return data.data(); }
+	SLANG_NO_THROW std::size_t SLANG_MCALL getBufferSize() override { return data.size(); }
+
+private:
+	std::vector<std::byte> data;
+	std::uint32_t          ref_count = 0;
+};
+
+void AppendDiagnostics(std::string& messages, ISlangBlob* diagnostics) {
+	if (diagnostics) {
+		messages.append(static_cast<char const*>(diagnostics->getBufferPointer()), diagnostics->getBufferSize());
+	}
+}
+
+auto GetWriteTime(std::filesystem::path const& path) -> std::filesystem::file_time_type {
+	std::error_code error;
+	return std::filesystem::last_write_time(path, error);
+}
+
+// Binaries of libraries from different directories with the same name must not collide
+auto GetSlangModuleCachePath(std::filesystem::path const& dir, SlangLibrary const& library) -> std::filesystem::path {
+	return dir / std::format("{}.{:016x}.slang-module", library.name, Utils::HashString(library.path.string(), 0xcbf29ce484222325ull));
+}
+
+} // namespace
+
+// Called with gSlangMutex held
+bool ShaderCompiler::CreateSlangSession(std::string_view path, std::string_view compile_options) {
+	slang::IGlobalSession* global_session = GetSlangGlobalSession();
+	if (!global_session) {
+		FormatAndResize(buffer, "Failed to create Slang global session");
+		return false;
+	}
+	SlangOptions slang_options;
+	(void)ParseSlangOptions(compile_options, slang_options);
+
+	// Imports are looked up next to the shader first
+	std::string const        shader_dir = std::filesystem::path(path).parent_path().string();
+	std::vector<char const*> search_paths{shader_dir.data()};
+	for (std::string const& dir : slang_options.include_dirs) {
+		search_paths.push_back(dir.data());
+	}
+	std::vector<slang::PreprocessorMacroDesc> macros;
+	for (auto const& [name, value] : slang_options.macros) {
+		macros.push_back({.name = name.data(), .value = value.data()});
+	}
+	std::vector<slang::CompilerOptionEntry> option_entries;
+	if (slang_options.optimization_level.has_value()) {
+		option_entries.push_back({
+			.name  = slang::CompilerOptionName::Optimization,
+			.value = {.kind = slang::CompilerOptionValueKind::Int, .intValue0 = static_cast<std::int32_t>(slang_options.optimization_level.value())},
+		});
+	}
+	if (slang_options.bDebugInfo) {
+		option_entries.push_back({
+			.name  = slang::CompilerOptionName::DebugInformation,
+			.value = {.kind = slang::CompilerOptionValueKind::Int, .intValue0 = static_cast<std::int32_t>(SLANG_DEBUG_INFO_LEVEL_STANDARD)},
+		});
+	}
+	slang::TargetDesc const target{
+		.format  = SLANG_SPIRV,
+		.profile = global_session->findProfile("spirv_1_5"),
+	};
+	slang::SessionDesc const session_desc{
+		.targets                  = &target,
+		.targetCount              = 1,
+		.searchPaths              = search_paths.data(),
+		.searchPathCount          = static_cast<SlangInt>(search_paths.size()),
+		.preprocessorMacros       = macros.data(),
+		.preprocessorMacroCount   = static_cast<SlangInt>(macros.size()),
+		.compilerOptionEntries    = option_entries.data(),
+		.compilerOptionEntryCount = static_cast<u32>(option_entries.size()),
+	};
+	in_process->slang_session = nullptr;
+	if (SLANG_FAILED(global_session->createSession(session_desc, in_process->slang_session.writeRef()))) {
+		FormatAndResize(buffer, "Failed to create Slang session");
+		return false;
+	}
+	in_process->slang_session_options  = std::format("{}\n{}", shader_dir, compile_options);
+	in_process->slang_session_compiles = 0;
+
+	// Libraries of the last session whose binaries are still up to date are loaded without parsing,
+	// the others are parsed again when the user file imports them
+	if (module_cache_dir.empty()) {
+		return true;
+	}
+	for (SlangLibrary& library : in_process->slang_libraries) {
+		library.bCached                            = false;
+		std::optional<std::vector<std::byte>> data = Utils::ReadBinaryFile(GetSlangModuleCachePath(module_cache_dir, library).string());
+		if (!data.has_value()) continue;
+		Slang::ComPtr<ISlangBlob> blob(new SlangFileBlob(std::move(data.value())));
+		std::string const         library_path = library.path.string();
+		if (!in_process->slang_session->isBinaryModuleUpToDate(library_path.data(), blob)) continue;
+		Slang::ComPtr<ISlangBlob> diagnostics;
+		library.bCached = in_process->slang_session->loadModuleFromIRBlob(library.name.data(), library_path.data(), blob, diagnostics.writeRef()) != nullptr;
+	}
+	return true;
+}
+
+// Remembers the libraries the session loaded and writes binaries of new or changed ones. Called with gSlangMutex held.
+void ShaderCompiler::UpdateSlangLibraries() {
+	std::vector<SlangLibrary> libraries;
+	for (SlangInt index = 0; index < in_process->slang_session->getLoadedModuleCount(); ++index) {
+		slang::IModule* const module = in_process->slang_session->getLoadedModule(index);
+		char const* const     name   = module->getName();
+		char const* const     path   = module->getFilePath();
+		if (!name || !path || std::string_view(name).starts_with(kSlangUserModulePrefix)) continue;
+		SlangLibrary library{.name = name, .path = path, .write_time = GetWriteTime(path)};
+		auto const   old = std::ranges::find(in_process->slang_libraries, library.path, &SlangLibrary::path);
+		library.bCached  = old != in_process->slang_libraries.end() && old->bCached && old->write_time == library.write_time;
+		if (!library.bCached && !module_cache_dir.empty()) {
+			std::error_code error;
+			std::filesystem::create_directories(module_cache_dir, error);
+			library.bCached = SLANG_SUCCEEDED(module->writeToFile(GetSlangModuleCachePath(module_cache_dir, library).string().data()));
+		}
+		libraries.push_back(std::move(library));
+	}
+	in_process->slang_libraries = std::move(libraries);
+}
+
+bool ShaderCompiler::CompileSlang(std::string_view path, std::string_view compile_options) {
+	diagnostics.clear();
+	std::string const          path_string(path);
+	std::optional<std::string> source = Utils::ReadFile(path_string);
+	if (!source.has_value()) {
+		FormatAndResize(buffer, "Failed to read %s", path_string.data());
+		return false;
+	}
+
+	std::lock_guard   lock(gSlangMutex);
+	bool const        bLibraryChanged = std::ranges::any_of(in_process->slang_libraries, [](SlangLibrary const& library) {
+		return GetWriteTime(library.path) != library.write_time;
+	});
+	std::string const session_options = std::format("{}\n{}", std::filesystem::path(path).parent_path().string(), compile_options);
+	if (!in_process->slang_session || bLibraryChanged || in_process->slang_session_options != session_options ||
+		in_process->slang_session_compiles >= kMaxSlangSessionCompiles) {
+		if (!CreateSlangSession(path, compile_options)) {
+			return false;
+		}
+	}
+	slang::ISession* const session = in_process->slang_session;
+
+	// A module name is loaded only once per session, the user file gets a new one every time
+	std::string const                    module_name = std::format("{}{}", kSlangUserModulePrefix, in_process->slang_session_compiles++);
+	std::string                          messages;
+	Slang::ComPtr<ISlangBlob>            step_diagnostics;
+	Slang::ComPtr<slang::IEntryPoint>    entry_point;
+	Slang::ComPtr<slang::IComponentType> program;
+	Slang::ComPtr<slang::IComponentType> linked;
+	Slang::ComPtr<ISlangBlob>            code;
+	slang::IModule* const                module = session->loadModuleFromSourceString(module_name.data(), path_string.data(), source.value().data(), step_diagnostics.writeRef());
+	AppendDiagnostics(messages, step_diagnostics);
+	bool bSuccess = module != nullptr;
+	if (bSuccess) {
+		SlangStage const stage = GetShaderStage(path) == ShaderStage::eCompute ? SLANG_STAGE_COMPUTE : SLANG_STAGE_FRAGMENT;
+		bSuccess               = SLANG_SUCCEEDED(module->findAndCheckEntryPoint("main", stage, entry_point.writeRef(), step_diagnostics.writeRef()));
+		AppendDiagnostics(messages, step_diagnostics);
+	}
+	if (bSuccess) {
+		slang::IComponentType* const components[] = {module, entry_point};
+		bSuccess                                  = SLANG_SUCCEEDED(session->createCompositeComponentType(components, 2, program.writeRef(), step_diagnostics.writeRef()));
+		AppendDiagnostics(messages, step_diagnostics);
+	}
+	if (bSuccess) {
+		bSuccess = SLANG_SUCCEEDED(program->link(linked.writeRef(), step_diagnostics.writeRef()));
+		AppendDiagnostics(messages, step_diagnostics);
+	}
+	if (bSuccess) {
+		bSuccess = SLANG_SUCCEEDED(linked->getEntryPointCode(0, 0, code.writeRef(), step_diagnostics.writeRef()));
+		AppendDiagnostics(messages, step_diagnostics);
+	}
+	ParseDiagnostics(messages);
+	AssignToBuffer(buffer, messages);
+	if (!bSuccess) {
+		return false;
+	}
+	spirv.resize(code->getBufferSize() / sizeof(u32));
+	std::memcpy(spirv.data(), code->getBufferPointer(), spirv.size() * sizeof(u32));
+	std::vector<std::filesystem::path> files;
+	for (SlangInt32 index = 0; index < module->getDependencyFileCount(); ++index) {
+		files.emplace_back(module->getDependencyFilePath(index));
+	}
+	SetDependencies(path, std::move(files));
+	UpdateSlangLibraries();
+	return true;
+}
+#endif // SHADER_PLAYGROUND_SLANG
+
+auto ShaderCompiler::SelectBackend(std::string_view path, std::string_view compile_options) const -> ShaderCompilerBackend {
+#ifdef SHADER_PLAYGROUND_SHADERC
+	std::string_view const file_extension = GetFileExtension(path);
+	InProcessOptions       parsed_options;
+	if (bInProcessEnabled && HasInProcessBackend() &&
+		(file_extension == "glsl" || file_extension == "frag" || file_extension == "comp") &&
+		ParseInProcessOptions(compile_options, parsed_options)) {
+		return ShaderCompilerBackend::eInProcess;
+	}
+#endif
+#ifdef SHADER_PLAYGROUND_SLANG
+	SlangOptions slang_options;
+	if (bInProcessEnabled && HasInProcessBackend() && GetFileExtension(path) == "slang" && ParseSlangOptions(compile_options, slang_options)) {
+		return ShaderCompilerBackend::eInProcess;
+	}
+#endif
+	return ShaderCompilerBackend::eExternalProcess;
+}
+
+bool ShaderCompiler::CompileInProcess(std::string_view path, std::string_view compile_options) {
+#ifdef SHADER_PLAYGROUND_SLANG
+	if (GetFileExtension(path) == "slang") {
+		return CompileSlang(path, compile_options);
+	}
+#endif
+#ifdef SHADER_PLAYGROUND_SHADERC
+	diagnostics.clear();
+	InProcessOptions parsed_options;
+	(void)ParseInProcessOptions(compile_options, parsed_options);
+
+	std::string const          path_string(path);
+	std::optional<std::string> source = Utils::ReadFile(path_string);
+	if (!source.has_value()) {
+		FormatAndResize(buffer, "Failed to read %s", path_string.data());
+		return false;
+	}
+
+	std::vector<std::filesystem::path> includes;
+	IncludeContext                     include_context{.include_dirs = &parsed_options.include_dirs, .dependencies = &includes};
+	shaderc_compile_options_t          options = CreateCompileOptions(parsed_options, &include_context);
+
+	// Stage from #pragma shader_stage, from the extension otherwise
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(
+		in_process->compiler, source.value().data(), source.value().size(),
+		GetDefaultShaderKind(path), path_string.data(), "main", options);
+	shaderc_compile_options_release(options);
+
+	char const*      error_message = shaderc_result_get_error_message(result);
+	std::string_view messages      = error_message ? error_message : "";
+	ParseDiagnostics(messages);
+	AssignToBuffer(buffer, messages);
+
+	bool const bSuccess = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+	if (bSuccess) {
+		std::size_t const size = shaderc_result_get_length(result);
+		spirv.resize(size / sizeof(u32));
+		std::memcpy(spirv.data(), shaderc_result_get_bytes(result), spirv.size() * sizeof(u32));
+		SetDependencies(path, std::move(includes));
+	}
+	shaderc_result_release(result);
+	return bSuccess;
+#else
+	return false;
+#endif
+}
+
+auto ShaderCompiler::PreprocessInProcess(std::string_view path, std::string_view compile_options) -> std::optional<std::string> {
+#ifdef SHADER_PLAYGROUND_SHADERC
+	InProcessOptions parsed_options;
+	(void)ParseInProcessOptions(compile_options, parsed_options);
+
+	std::string const          path_string(path);
+	std::optional<std::string> source = Utils::ReadFile(path_string);
+	if (!source.has_value()) {
+		return std::nullopt;
+	}
+
+	std::vector<std::filesystem::path> includes;
+	IncludeContext                     include_context{.include_dirs = &parsed_options.include_dirs, .dependencies = &includes};
+	shaderc_compile_options_t          options = CreateCompileOptions(parsed_options, &include_context);
+
+	// Includes are expanded in place, so the text covers their contents too
+	shaderc_compilation_result_t result = shaderc_compile_into_preprocessed_text(
+		in_process->compiler, source.value().data(), source.value().size(),
+		GetDefaultShaderKind(path), path_string.data(), "main", options);
+	shaderc_compile_options_release(options);
+
+	std::optional<std::string> text;
+	if (shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success) {
+		text.emplace(shaderc_result_get_bytes(result), shaderc_result_get_length(result));
+	}
+	shaderc_result_release(result);
+	// Also when an include is missing, creating it must be noticed
+	SetDependencies(path, std::move(includes));
+	return text;
+#else
+	return std::nullopt;
+#endif
+}
+
+auto ShaderCompiler::GetCompilerIdentity(ShaderCompilerBackend backend, std::string_view path) -> std::string_view {
+	bool const        bSlang        = GetFileExtension(path) == "slang";
+	char const*       external_name = GetExternalCompilerName(GetFileExtension(path));
+	std::string const name          = backend == ShaderCompilerBackend::eInProcess ? (bSlang ? "slang" : "shaderc")
+									  : external_name                              ? external_name
+																				   : "";
+	auto [it, bInserted] = compiler_identities.try_emplace(name);
+	if (!bInserted || name.empty()) {
+		return it->second;
+	}
+	if (backend == ShaderCompilerBackend::eInProcess && bSlang) {
+#ifdef SHADER_PLAYGROUND_SLANG
+		std::lock_guard lock(gSlangMutex);
+		if (slang::IGlobalSession* const global_session = GetSlangGlobalSession()) {
+			it->second = std::format("slang {}", global_session->getBuildTagString());
+		}
+#endif
+	} else if (backend == ShaderCompilerBackend::eInProcess) {
+#ifdef SHADER_PLAYGROUND_SHADERC
+		unsigned int spirv_version  = 0;
+		unsigned int spirv_revision = 0;
+		shaderc_get_spv_version(&spirv_version, &spirv_revision);
+		it->second = std::format("shaderc {} spv {}.{}", SHADER_PLAYGROUND_SHADERC_VERSION, spirv_version, spirv_revision);
+#endif
+	} else {
+		std::string const command = name + (name == "slangc" ? " -v 2>&1" : " --version 2>&1");
+		(void)RunCommand(command.data(), it->second);
+	}
+	return it->second;
+}
+
+namespace {
+
+// Length-prefixed, so adjacent fields can not shift into each other
+auto HashField(std::uint64_t hash, std::string_view const field) -> std::uint64_t {
+	std::uint64_t const size = field.size();
+	hash                     = Utils::HashBytes(std::as_bytes(std::span(&size, 1)), hash);
+	return Utils::HashString(field, hash);
+}
+
+auto ParseIncludeDirs(std::string_view options) -> std::vector<std::filesystem::path> {
+	std::vector<std::filesystem::path> include_dirs;
+	std::istringstream                 stream{std::string(options)};
+	for (std::string token; stream >> token;) {
+		if (token == "-I") {
+			if (stream >> token) include_dirs.emplace_back(token);
+		} else if (token.starts_with("-I")) {
+			include_dirs.emplace_back(token.substr(2));
+		}
+	}
+	return include_dirs;
+}
+
+} // namespace
+
+auto FindShaderDependencies(std::string_view source) -> std::vector<std::string> {
+	std::vector<std::string> names;
+	while (!source.empty()) {
+		std::size_t const line_end = source.find('\n');
+		std::string_view  line     = source.substr(0, line_end);
+		source.remove_prefix(line_end == std::string_view::npos ? source.size() : line_end + 1);
+
+		line.remove_prefix(std::min(line.find_first_not_of(" \t"), line.size()));
+		bool const bImport    = line.starts_with("import ");
+		bool const bDirective = line.starts_with('#');
+		if (bDirective) {
+			line.remove_prefix(1);
+			line.remove_prefix(std::min(line.find_first_not_of(" \t"), line.size()));
+		}
+		// #include is a preprocessor directive, Slang's __include and import are statements
+		bool const bInclude = bDirective ? line.starts_with("include") : line.starts_with("__include");
+		if (!bImport && !bInclude) {
+			continue;
+		}
+		line.remove_prefix(std::min(line.find_first_of(" \t\"<"), line.size()));
+		line.remove_prefix(std::min(line.find_first_not_of(" \t"), line.size()));
+		if (line.starts_with('"') || line.starts_with('<')) {
+			char const        close = line.front() == '"' ? '"' : '>';
+			std::size_t const end   = line.find(close, 1);
+			if (end != std::string_view::npos) {
+				names.emplace_back(line.substr(1, end - 1));
+			}
+		} else if (bImport) {
+			// Slang module name: dots are directories, underscores may be dashes in the file name
+			std::string module(line.substr(0, line.find_first_of("; \t\r")));
+			std::ranges::replace(module, '.', '/');
+			names.push_back(module + ".slang");
+			std::ranges::replace(module, '_', '-');
+			names.push_back(module + ".slang");
+		}
+	}
+	return names;
+}
+
+namespace {
+
+// Hashes the file and, recursively, every file it references. Files that can not be found
+// are hashed by name so the key changes once they appear, the first place they are looked for is added to missing.
+void HashSourceTree(std::filesystem::path const& path, std::string_view source, std::span<std::filesystem::path const> include_dirs,
+					std::vector<std::filesystem::path>& visited, std::vector<std::filesystem::path>& missing, std::uint64_t& hash) {
+	hash = HashField(hash, source);
+	for (std::string const& name : FindShaderDependencies(source)) {
+		std::vector<std::filesystem::path> candidates{path.parent_path() / name};
+		for (std::filesystem::path const& dir : include_dirs) {
+			candidates.push_back(dir / name);
+		}
+		bool bFound = false;
+		for (std::filesystem::path const& candidate : candidates) {
+			std::filesystem::path const normal = candidate.lexically_normal();
+			if (std::ranges::find(visited, normal) != visited.end()) {
+				bFound = true;
+				break;
+			}
+			if (std::optional<std::string> content = Utils::ReadFile(normal.string())) {
+				visited.push_back(normal);
+				hash = HashField(hash, normal.string());
+				HashSourceTree(normal, content.value(), include_dirs, visited, missing, hash);
+				bFound = true;
+				break;
+			}
+		}
+		if (!bFound) {
+			hash = HashField(hash, name);
+			missing.push_back(candidates.front().lexically_normal());
+		}
+	}
+}
+
+} // namespace
+
+auto ShaderCompiler::ComputeCacheKey(std::string_view path, std::string_view compile_options) -> std::optional<std::uint64_t> {
+	ShaderCompilerBackend const backend = SelectBackend(path, compile_options);
+	dependencies.clear();
+
+	std::uint64_t hash = HashField(0xcbf29ce484222325ull, GetCompilerIdentity(backend, path));
+	hash               = HashField(hash, compile_options);
+	// Slang has no preprocess-only mode, imports are hashed like for the external compiler
+	if (backend == ShaderCompilerBackend::eInProcess && GetFileExtension(path) != "slang") {
+		std::optional<std::string> text = PreprocessInProcess(path, compile_options);
+		if (!text.has_value()) {
+			return std::nullopt;
+		}
+		return HashField(hash, text.value());
+	}
+
+	std::filesystem::path const file_path = std::filesystem::path(path).lexically_normal();
+	std::optional<std::string>  source    = Utils::ReadFile(file_path.string());
+	if (!source.has_value()) {
+		return std::nullopt;
+	}
+	std::vector<std::filesystem::path> const include_dirs = ParseIncludeDirs(compile_options);
+	std::vector<std::filesystem::path>       visited{file_path};
+	std::vector<std::filesystem::path>       missing;
+	HashSourceTree(file_path, source.value(), include_dirs, visited, missing, hash);
+	// Everything the source tree references, the compiler narrows it down once it succeeds
+	visited.append_range(missing);
+	SetDependencies(path, std::move(visited));
+	return hash;
+}
+
 auto ShaderCompiler::GetErrorMessage() -> std::string_view {
 	return {reinterpret_cast<char*>(buffer.data()), buffer.size()};
 };
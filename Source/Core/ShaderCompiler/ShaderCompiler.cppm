@@ -2,15 +2,105 @@ export module ShaderCompiler;
 
 import std;
 
+using u32 = std::uint32_t;
+
+export enum class ShaderCompilerBackend {
+	eNone,
+	eExternalProcess,
+	eInProcess,
+};
+
+export constexpr inline auto ShaderCompilerBackendToString(ShaderCompilerBackend backend) -> char const* {
+	switch (backend) {
+	case ShaderCompilerBackend::eExternalProcess: return "external";
+	case ShaderCompilerBackend::eInProcess:       return "in-process";
+	default:                                      return "none";
+	}
+}
+
+export enum class ShaderStage {
+	eFragment,
+	eCompute, // .comp files
+};
+
+// Stage a user shader is compiled for, from its extension
+export auto GetShaderStage(std::string_view path) -> ShaderStage;
+
+// Extension has a compiler: .frag, .comp, .glsl or .slang
+export auto IsShaderFile(std::string_view path) -> bool;
+
+// File names referenced by #include, __include and Slang import directives of source
+export auto FindShaderDependencies(std::string_view source) -> std::vector<std::string>;
+
+export enum class ShaderDiagnosticSeverity {
+	eError,
+	eWarning,
+	eNote,
+};
+
+export struct ShaderDiagnostic {
+	ShaderDiagnosticSeverity severity = ShaderDiagnosticSeverity::eError;
+	std::string              file;
+	int                      line = 0; // 0 if unknown
+	std::string              message;
+};
+
+struct InProcessCompiler;
+
 export class ShaderCompiler {
 public:
+	ShaderCompiler();
 	~ShaderCompiler();
 	bool               Init();
 	void               Destroy();
 	[[nodiscard]] bool CompileShader(std::string_view path, std::string_view output_file_path, std::string_view compile_options = "");
-	auto               GetErrorMessage() -> std::string_view;
+
+	// Compile into memory. Falls back to the external compiler writing into output_file_path
+	// when the in-process one is not built in, disabled or can not handle the file or options.
+	// Returned span stays valid until the next compilation.
+	[[nodiscard]] auto CompileShaderToSpirv(std::string_view path, std::string_view output_file_path, std::string_view compile_options = "") -> std::optional<std::span<u32 const>>;
+
+	// Hash of everything that affects the output: preprocessed source or source with the contents
+	// of all includes, compiler identity and options. Empty if the source can not be read.
+	[[nodiscard]] auto ComputeCacheKey(std::string_view path, std::string_view compile_options = "") -> std::optional<std::uint64_t>;
+
+	// Backend CompileShaderToSpirv would use for these arguments
+	auto SelectBackend(std::string_view path, std::string_view compile_options) const -> ShaderCompilerBackend;
+
+	// Absolute paths of the files the shader includes or imports, set by ComputeCacheKey from everything
+	// the source tree references and narrowed to what the compiler read once a compilation succeeds.
+	// Included files that could not be found are listed where they were first looked for.
+	auto GetDependencies() const -> std::span<std::filesystem::path const> { return dependencies; }
+
+	auto GetErrorMessage() -> std::string_view;
+	auto GetDiagnostics() const -> std::span<ShaderDiagnostic const> { return diagnostics; }
+	auto GetLastBackend() const -> ShaderCompilerBackend { return last_backend; }
+
+	void SetInProcessEnabled(bool bEnabled) { bInProcessEnabled = bEnabled; }
+	bool HasInProcessBackend() const;
+	// Binaries of modules imported by Slang shaders are kept here between sessions and runs, not kept if empty
+	void SetModuleCacheDir(std::filesystem::path dir) { module_cache_dir = std::move(dir); }
 
 private:
-	std::vector<std::byte> buffer;
-	
+	[[nodiscard]] bool CompileInProcess(std::string_view path, std::string_view compile_options);
+	[[nodiscard]] bool CompileSlang(std::string_view path, std::string_view compile_options);
+	[[nodiscard]] bool CreateSlangSession(std::string_view path, std::string_view compile_options);
+	void               UpdateSlangLibraries();
+	[[nodiscard]] auto PreprocessInProcess(std::string_view path, std::string_view compile_options) -> std::optional<std::string>;
+	[[nodiscard]] bool RunExternalCompiler(std::string_view path, std::string_view output_file_path, std::string_view compile_options);
+	auto               GetCompilerIdentity(ShaderCompilerBackend backend, std::string_view path) -> std::string_view;
+	void               ParseDiagnostics(std::string_view output);
+	void               SetDependencies(std::string_view path, std::vector<std::filesystem::path> paths);
+
+	std::vector<std::byte>             buffer;
+	std::vector<u32>                   spirv;
+	std::vector<ShaderDiagnostic>      diagnostics;
+	std::vector<std::filesystem::path> dependencies;
+	std::unique_ptr<InProcessCompiler> in_process;
+	// Compiler name -> version output, queried once per session
+	std::unordered_map<std::string, std::string> compiler_identities;
+
+	std::filesystem::path              module_cache_dir;
+	ShaderCompilerBackend              last_backend      = ShaderCompilerBackend::eNone;
+	bool                               bInProcessEnabled = true;
 };
@@ -0,0 +1,298 @@
+module ShaderReflection;
+
+import std;
+
+namespace {
+constexpr u32 kSpirvMagic      = 0x07230203;
+constexpr u32 kSpirvHeaderSize = 5;
+
+constexpr u32 kDecorationSpecId         = 1;
+constexpr u32 kDecorationBuiltIn        = 11;
+constexpr u32 kDecorationBinding        = 33;
+constexpr u32 kDecorationDescriptorSet  = 34;
+constexpr u32 kBuiltInWorkgroupSize     = 25;
+constexpr u32 kExecutionModeLocalSize   = 17;
+constexpr u32 kExecutionModeLocalSizeId = 38;
+constexpr u32 kChannelSet               = 1;
+constexpr u32 kChannelCount             = 4;
+
+enum class Op : u32 {
+	eName                  = 5,
+	eMemberName            = 6,
+	eEntryPoint            = 15,
+	eExecutionMode         = 16,
+	eTypeBool              = 20,
+	eTypeInt               = 21,
+	eTypeFloat             = 22,
+	eTypeStruct            = 30,
+	eTypePointer           = 32,
+	eConstant              = 43,
+	eConstantComposite     = 44,
+	eSpecConstantTrue      = 48,
+	eSpecConstantFalse     = 49,
+	eSpecConstant          = 50,
+	eSpecConstantComposite = 51,
+	eVariable              = 59,
+	eAccessChain           = 65,
+	eInBoundsAccessChain   = 66,
+	eDecorate              = 71,
+	eMemberDecorate        = 72,
+	eExecutionModeId       = 331,
+};
+
+enum class StorageClass : u32 {
+	eUniformConstant = 0,
+	eUniform         = 2,
+	ePushConstant    = 9,
+};
+
+// Calls func(opcode, operands) for every instruction, false if the stream is malformed
+template <typename Func>
+bool ForEachInstruction(std::span<u32 const> spirv, Func&& func) {
+	for (std::size_t offset = kSpirvHeaderSize; offset < spirv.size();) {
+		u32 const word_count = spirv[offset] >> 16;
+		if (word_count == 0 || offset + word_count > spirv.size()) return false;
+		func(static_cast<Op>(spirv[offset] & 0xFFFF), spirv.subspan(offset + 1, word_count - 1));
+		offset += word_count;
+	}
+	return true;
+}
+
+// Literal string operand, nul terminated and padded to whole words
+auto DecodeString(std::span<u32 const> words) -> std::string {
+	std::string string;
+	for (u32 const word : words) {
+		for (u32 byte = 0; byte < 4; ++byte) {
+			char const c = static_cast<char>((word >> (byte * 8)) & 0xFF);
+			if (c == '\0') return string;
+			string.push_back(c);
+		}
+	}
+	return string;
+}
+} // namespace
+
+auto ReflectFrameInputs(std::span<u32 const> spirv) -> FrameInputUsage {
+	if (spirv.size() < kSpirvHeaderSize || spirv[0] != kSpirvMagic) return {};
+
+	std::unordered_map<u32, u32>          constants;     // result id -> low word
+	std::unordered_map<u32, u32>          struct_sizes;  // struct type -> member count
+	std::unordered_map<u32, u32>          pointee_types; // pointer type -> pointee type
+	std::unordered_map<u32, StorageClass> variables;     // push constant and uniform variables
+	std::unordered_map<u32, u32>          variable_types;
+	std::unordered_map<u32, u32>          bindings; // variable -> binding, for set kChannelSet
+	std::unordered_set<u32>               channel_set_variables;
+	bool const bValid = ForEachInstruction(spirv, [&](Op op, std::span<u32 const> operands) {
+		if (op == Op::eConstant && operands.size() >= 3) {
+			constants[operands[1]] = operands[2];
+		} else if (op == Op::eTypeStruct && operands.size() >= 1) {
+			struct_sizes[operands[0]] = static_cast<u32>(operands.size() - 1);
+		} else if (op == Op::eTypePointer && operands.size() >= 3) {
+			pointee_types[operands[0]] = operands[2];
+		} else if (op == Op::eVariable && operands.size() >= 3) {
+			StorageClass const storage = static_cast<StorageClass>(operands[2]);
+			if (storage == StorageClass::ePushConstant || storage == StorageClass::eUniform || storage == StorageClass::eUniformConstant) {
+				variables[operands[1]]      = storage;
+				variable_types[operands[1]] = operands[0];
+			}
+		} else if (op == Op::eDecorate && operands.size() >= 3) {
+			if (operands[1] == kDecorationBinding) bindings[operands[0]] = operands[2];
+			if (operands[1] == kDecorationDescriptorSet && operands[2] == kChannelSet) channel_set_variables.insert(operands[0]);
+		}
+	});
+	if (!bValid) return {};
+
+	// Only a block with the members of PushConstants declared directly in it is traced,
+	// e.g. not one wrapping the struct as a single member
+	std::array<bool, 5> members{};
+	auto const          IsFlatBlock = [&](u32 variable) {
+		auto const pointee = pointee_types.find(variable_types[variable]);
+		if (pointee == pointee_types.end()) return false;
+		auto const size = struct_sizes.find(pointee->second);
+		return size != struct_sizes.end() && size->second == members.size();
+	};
+
+	// Members are read through access chains with a constant first index on the push constant block.
+	// Uniform blocks wrap the struct and are not traced, any use reads everything.
+	// Channels are sampled if their variable is used at all.
+	bool bAll         = false;
+	u32  channel_mask = 0;
+	auto MarkUsed     = [&](u32 id) {
+		auto const variable = variables.find(id);
+		if (variable == variables.end()) return;
+		if (variable->second != StorageClass::eUniformConstant) {
+			bAll = true;
+		} else if (channel_set_variables.contains(id)) {
+			auto const binding = bindings.find(id);
+			channel_mask |= binding != bindings.end() && binding->second < kChannelCount ? 1u << binding->second : 0u;
+		}
+	};
+	ForEachInstruction(spirv, [&](Op op, std::span<u32 const> operands) {
+		switch (op) {
+		case Op::eName:
+		case Op::eMemberName:
+		case Op::eEntryPoint:
+		case Op::eDecorate:
+		case Op::eMemberDecorate:
+		case Op::eVariable:
+			return;
+		case Op::eAccessChain:
+		case Op::eInBoundsAccessChain: {
+			if (operands.size() < 4) break;
+			auto const variable = variables.find(operands[2]);
+			if (variable == variables.end() || variable->second == StorageClass::eUniformConstant) break;
+			auto const index = constants.find(operands[3]);
+			if (variable->second != StorageClass::ePushConstant || !IsFlatBlock(variable->first) ||
+				index == constants.end() || index->second >= members.size()) {
+				bAll = true;
+			} else {
+				members[index->second] = true;
+			}
+			for (u32 const operand : operands.subspan(4)) {
+				MarkUsed(operand);
+			}
+			return;
+		}
+		default: break;
+		}
+		// Any other use, e.g. loading the whole block or passing it to a function.
+		// Literals equal to a variable id make this more conservative, never less.
+		for (u32 const operand : operands) {
+			MarkUsed(operand);
+		}
+	});
+	if (bAll) return {.channel_mask = channel_mask};
+	return {
+		.bResolution  = members[0],
+		.bMouse       = members[1],
+		.bTime        = members[2],
+		.bTimeDelta   = members[3],
+		.bFrame       = members[4],
+		.channel_mask = channel_mask,
+	};
+}
+
+auto ReflectComputeWorkgroup(std::span<u32 const> spirv) -> ComputeWorkgroup {
+	if (spirv.size() < kSpirvHeaderSize || spirv[0] != kSpirvMagic) return {};
+
+	std::unordered_map<u32, u32>              constants;  // result id -> low word, spec constants with their default
+	std::unordered_map<u32, u32>              spec_ids;   // spec constant -> SpecId
+	std::unordered_map<u32, std::vector<u32>> composites; // result id -> constituents
+	std::optional<std::array<u32, 3>>         local_size;
+	std::optional<std::array<u32, 3>>         local_size_ids;
+	std::optional<u32>                        builtin_size;
+	ForEachInstruction(spirv, [&](Op op, std::span<u32 const> operands) {
+		if ((op == Op::eConstant || op == Op::eSpecConstant) && operands.size() >= 3) {
+			constants[operands[1]] = operands[2];
+		} else if ((op == Op::eConstantComposite || op == Op::eSpecConstantComposite) && operands.size() >= 2) {
+			composites[operands[1]].assign(operands.begin() + 2, operands.end());
+		} else if (op == Op::eExecutionMode && operands.size() >= 5 && operands[1] == kExecutionModeLocalSize) {
+			local_size = {operands[2], operands[3], operands[4]};
+		} else if (op == Op::eExecutionModeId && operands.size() >= 5 && operands[1] == kExecutionModeLocalSizeId) {
+			local_size_ids = {operands[2], operands[3], operands[4]};
+		} else if (op == Op::eDecorate && operands.size() >= 3) {
+			if (operands[1] == kDecorationSpecId) spec_ids[operands[0]] = operands[2];
+			if (operands[1] == kDecorationBuiltIn && operands[2] == kBuiltInWorkgroupSize) builtin_size = operands[0];
+		}
+	});
+
+	// The built-in overrides the execution modes
+	std::optional<std::array<u32, 3>> size_ids = local_size_ids;
+	if (builtin_size.has_value()) {
+		auto const composite = composites.find(builtin_size.value());
+		if (composite != composites.end() && composite->second.size() == 3) {
+			size_ids = {composite->second[0], composite->second[1], composite->second[2]};
+		}
+	}
+	ComputeWorkgroup workgroup;
+	if (size_ids.has_value()) {
+		for (std::size_t axis = 0; axis < 3; ++axis) {
+			auto const constant  = constants.find(size_ids.value()[axis]);
+			workgroup.size[axis] = constant != constants.end() ? constant->second : 1;
+		}
+		auto const SpecIdIs = [&](u32 id, u32 spec_id) {
+			auto const found = spec_ids.find(id);
+			return found != spec_ids.end() && found->second == spec_id;
+		};
+		workgroup.bSpecializable = SpecIdIs(size_ids.value()[0], 0) && SpecIdIs(size_ids.value()[1], 1);
+	} else if (local_size.has_value()) {
+		workgroup.size = local_size.value();
+	}
+	return workgroup;
+}
+
+auto ReflectSpecConstants(std::span<u32 const> spirv) -> std::vector<SpecConstant> {
+	if (spirv.size() < kSpirvHeaderSize || spirv[0] != kSpirvMagic) return {};
+
+	std::unordered_map<u32, SpecConstantType> scalar_types; // 32-bit scalar type -> its kind
+	std::unordered_map<u32, std::string>      names;
+	std::unordered_map<u32, u32>              spec_ids;
+	std::vector<SpecConstant>                 constants; // id is the result id until the end
+	ForEachInstruction(spirv, [&](Op op, std::span<u32 const> operands) {
+		switch (op) {
+		case Op::eName:
+			if (operands.size() >= 2) names[operands[0]] = DecodeString(operands.subspan(1));
+			break;
+		case Op::eDecorate:
+			if (operands.size() >= 3 && operands[1] == kDecorationSpecId) spec_ids[operands[0]] = operands[2];
+			break;
+		case Op::eTypeBool:
+			if (operands.size() >= 1) scalar_types[operands[0]] = SpecConstantType::eBool;
+			break;
+		case Op::eTypeInt:
+			if (operands.size() >= 3 && operands[1] == 32) scalar_types[operands[0]] = operands[2] ? SpecConstantType::eInt : SpecConstantType::eUint;
+			break;
+		case Op::eTypeFloat:
+			if (operands.size() >= 2 && operands[1] == 32) scalar_types[operands[0]] = SpecConstantType::eFloat;
+			break;
+		case Op::eSpecConstantTrue:
+		case Op::eSpecConstantFalse:
+		case Op::eSpecConstant: {
+			if (operands.size() < 2) break;
+			auto const type = scalar_types.find(operands[0]);
+			if (type == scalar_types.end()) break;
+			u32 const value = op == Op::eSpecConstant ? (operands.size() >= 3 ? operands[2] : 0) : op == Op::eSpecConstantTrue;
+			constants.push_back({.id = operands[1], .type = type->second, .default_value = value});
+			break;
+		}
+		default: break;
+		}
+	});
+
+	// Constants without a SpecId are derived from others, e.g. the workgroup size composite parts
+	std::erase_if(constants, [&](SpecConstant const& constant) { return !spec_ids.contains(constant.id); });
+	for (SpecConstant& constant : constants) {
+		auto const name = names.find(constant.id);
+		if (name != names.end()) constant.name = name->second;
+		constant.id = spec_ids[constant.id];
+	}
+	return constants;
+}
+
+auto ParseSpecConstantValue(SpecConstantType type, std::string_view text) -> std::optional<u32> {
+	auto Parse = [text]<typename T>(T value) -> std::optional<u32> {
+		auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc{} || end != text.data() + text.size()) return std::nullopt;
+		return std::bit_cast<u32>(value);
+	};
+	switch (type) {
+	case SpecConstantType::eBool:
+		if (text == "true" || text == "1") return 1u;
+		if (text == "false" || text == "0") return 0u;
+		return std::nullopt;
+	case SpecConstantType::eInt:   return Parse(std::int32_t{});
+	case SpecConstantType::eUint:  return Parse(u32{});
+	case SpecConstantType::eFloat: return Parse(float{});
+	}
+	return std::nullopt;
+}
+
+auto FormatSpecConstantValue(SpecConstantType type, u32 value) -> std::string {
+	switch (type) {
+	case SpecConstantType::eBool:  return value ? "true" : "false";
+	case SpecConstantType::eInt:   return std::to_string(std::bit_cast<std::int32_t>(value));
+	case SpecConstantType::eUint:  return std::to_string(value);
+	case SpecConstantType::eFloat: return std::format("{}", std::bit_cast<float>(value));
+	}
+	return {};
+}
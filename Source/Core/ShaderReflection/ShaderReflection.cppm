@@ -0,0 +1,62 @@
+export module ShaderReflection;
+
+import std;
+
+using u32 = std::uint32_t;
+
+// Members of PushConstants (Shaders/PushConstants.h) a shader reads, through the
+// push constant block or the per-frame uniform buffer, and the channels it samples
+export struct FrameInputUsage {
+	bool bResolution = true;
+	bool bMouse      = true;
+	bool bTime       = true;
+	bool bTimeDelta  = true;
+	bool bFrame      = true;
+	// Bit i is set if iChannel<i>, set 1 binding i, is sampled
+	u32 channel_mask = 0xF;
+
+	// Output changes from frame to frame even without input
+	bool IsAnimated() const { return bTime || bTimeDelta || bFrame; }
+
+	// Depends on nothing but the size, e.g. the fallback shader
+	static constexpr auto ResolutionOnly() -> FrameInputUsage {
+		return {.bResolution = true, .bMouse = false, .bTime = false, .bTimeDelta = false, .bFrame = false, .channel_mask = 0};
+	}
+};
+
+// Conservative, anything that can not be traced to single members counts as reading all of them.
+// Invalid SPIR-V reads everything.
+export auto ReflectFrameInputs(std::span<u32 const> spirv) -> FrameInputUsage;
+
+// Workgroup size of a compute shader
+export struct ComputeWorkgroup {
+	// From the WorkgroupSize built-in, LocalSizeId or LocalSize, defaults for specialization constants
+	std::array<u32, 3> size = {1, 1, 1};
+	// Width and height are specialization constants 0 and 1,
+	// layout(local_size_x_id = 0, local_size_y_id = 1) in;
+	bool bSpecializable = false;
+};
+
+export auto ReflectComputeWorkgroup(std::span<u32 const> spirv) -> ComputeWorkgroup;
+
+export enum class SpecConstantType {
+	eBool,
+	eInt,
+	eUint,
+	eFloat,
+};
+
+// Scalar specialization constant, layout(constant_id = N) const <type> name = value;
+export struct SpecConstant {
+	u32              id   = 0;
+	std::string      name; // empty if the shader has no debug names
+	SpecConstantType type          = SpecConstantType::eInt;
+	u32              default_value = 0; // bits of the value, 0 or 1 for bools
+};
+
+// 32-bit scalars in the order they are declared, others can not be set with a 32-bit value and are skipped
+export auto ReflectSpecConstants(std::span<u32 const> spirv) -> std::vector<SpecConstant>;
+
+// Value as text, e.g. true, -3, 2, 0.5, and back. Bools also accept 1 and 0.
+export auto ParseSpecConstantValue(SpecConstantType type, std::string_view text) -> std::optional<u32>;
+export auto FormatSpecConstantValue(SpecConstantType type, u32 value) -> std::string;
@@ -0,0 +1,92 @@
+module SpecConstants;
+
+import std;
+import ShaderReflection;
+
+bool SpecConstantSet::Update(std::span<SpecConstant const> reflected) {
+	std::vector<UserSpecConstant> updated;
+	updated.reserve(reflected.size());
+	for (SpecConstant const& info : reflected) {
+		auto const previous = std::ranges::find_if(constants, [&](UserSpecConstant const& constant) {
+			return constant.info.name == info.name && constant.info.type == info.type && (!info.name.empty() || constant.info.id == info.id);
+		});
+		updated.push_back({.info = info, .value = previous != constants.end() ? previous->value : info.default_value});
+	}
+	bool const bNew = std::ranges::any_of(updated, [&](UserSpecConstant const& constant) {
+		return std::ranges::none_of(constants, [&](UserSpecConstant const& old) { return old.info.name == constant.info.name && old.info.id == constant.info.id; });
+	});
+	constants = std::move(updated);
+	return bNew;
+}
+
+bool SpecConstantSet::LoadControlFile(std::filesystem::path const& path) {
+	auto const Trim = [](std::string_view view) {
+		std::size_t const first = view.find_first_not_of(" \t\r");
+		if (first == std::string_view::npos) return std::string_view{};
+		return view.substr(first, view.find_last_not_of(" \t\r") - first + 1);
+	};
+	std::vector<std::pair<std::string, std::string>> values;
+	std::ifstream                                    file(path);
+	for (std::string line; std::getline(file, line);) {
+		std::string_view const text  = std::string_view{line}.substr(0, line.find('#'));
+		std::size_t const      equal = text.find('=');
+		if (equal == std::string_view::npos) continue;
+		values.emplace_back(Trim(text.substr(0, equal)), Trim(text.substr(equal + 1)));
+	}
+	if (values == control_values) return false;
+	control_values = std::move(values);
+	return true;
+}
+
+auto SpecConstantSet::ApplyControlValues() -> std::vector<std::string> {
+	std::vector<std::string> messages;
+	for (auto const& [key, text] : control_values) {
+		auto const constant = std::ranges::find_if(constants, [&](UserSpecConstant const& constant) {
+			return constant.info.name == key || std::to_string(constant.info.id) == key;
+		});
+		if (constant == constants.end()) {
+			messages.push_back(std::format("no specialization constant {}", key));
+			continue;
+		}
+		std::optional<u32> const value = ParseSpecConstantValue(constant->info.type, text);
+		if (!value.has_value()) {
+			messages.push_back(std::format("invalid value {} for {}", text, key));
+			continue;
+		}
+		constant->value = value.value();
+	}
+	return messages;
+}
+
+auto SpecConstantSet::Step(std::size_t index, int direction) -> UserSpecConstant const* {
+	if (index >= constants.size()) return nullptr;
+	UserSpecConstant& constant = constants[index];
+	switch (constant.info.type) {
+	case SpecConstantType::eBool: constant.value = !constant.value; break;
+	case SpecConstantType::eInt:  constant.value = std::bit_cast<u32>(std::bit_cast<std::int32_t>(constant.value) + direction); break;
+	case SpecConstantType::eUint:
+		if (direction > 0 || constant.value > 0) constant.value += direction;
+		break;
+	case SpecConstantType::eFloat: {
+		float const step = std::max(std::abs(std::bit_cast<float>(constant.info.default_value)) * 0.1f, 0.01f);
+		constant.value   = std::bit_cast<u32>(std::bit_cast<float>(constant.value) + direction * step);
+		break;
+	}
+	}
+	return &constant;
+}
+
+void SpecConstantSet::ResetToDefaults() {
+	for (UserSpecConstant& constant : constants) {
+		constant.value = constant.info.default_value;
+	}
+}
+
+auto SpecConstantSet::GetValues() const -> std::vector<SpecConstantValue> {
+	std::vector<SpecConstantValue> values;
+	values.reserve(constants.size());
+	for (UserSpecConstant const& constant : constants) {
+		values.push_back({.id = constant.info.id, .value = constant.value});
+	}
+	return values;
+}
@@ -0,0 +1,48 @@
+export module SpecConstants;
+
+import std;
+import ShaderReflection;
+
+using u32 = std::uint32_t;
+
+// Value a pipeline is specialized with. Constants are matched by id across passes, ids 0 and 1
+// of compute shaders that size their workgroup with them are not the user's.
+export struct SpecConstantValue {
+	u32 id    = 0;
+	u32 value = 0;
+
+	bool operator==(SpecConstantValue const&) const = default;
+};
+
+export struct UserSpecConstant {
+	SpecConstant info;
+	u32          value = 0;
+};
+
+// Specialization constants of a shader with the values the user picked, from the control file
+// next to the shader or stepped one at a time. Changing one only respecializes the pipelines.
+// The control file has name = value lines, # starts a comment, constants are named by their
+// name or constant_id.
+export class SpecConstantSet {
+public:
+	// Constants in reflected keep the value of one with the same name and type, new ones take
+	// the shader default. Returns whether any is new, control values are then applied again.
+	bool Update(std::span<SpecConstant const> reflected);
+
+	// Returns false if the file did not change what it sets, a missing file sets nothing
+	bool LoadControlFile(std::filesystem::path const& path);
+	// Returns a message for each line naming no constant or with an invalid value
+	auto ApplyControlValues() -> std::vector<std::string>;
+
+	// Toggles a bool, steps an integer by one and a float by a tenth of its default.
+	// Returns null if there is no constant at index.
+	auto Step(std::size_t index, int direction) -> UserSpecConstant const*;
+	void ResetToDefaults();
+
+	auto GetValues() const -> std::vector<SpecConstantValue>;
+	auto GetConstants() const -> std::span<UserSpecConstant const> { return constants; }
+
+private:
+	std::vector<UserSpecConstant>                    constants;
+	std::vector<std::pair<std::string, std::string>> control_values; // name or id = value
+};
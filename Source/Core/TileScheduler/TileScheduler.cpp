@@ -0,0 +1,74 @@
+module TileScheduler;
+
+import std;
+
+namespace {
+// Largest growth of the pixels drawn per frame from one measurement
+constexpr float kMaxGrowth = 2.0f;
+} // namespace
+
+void TileScheduler::Init(TileSchedulerInfo const& info) {
+	this->info             = info;
+	this->info.granularity = std::max(info.granularity, 1u);
+	this->info.max_tiles   = std::max(info.max_tiles, 1u);
+	ms_per_pixel           = 0.0f;
+	Restart(0, 0);
+}
+
+void TileScheduler::Restart(u32 width, u32 height) {
+	this->width  = width;
+	this->height = height;
+	x            = 0;
+	y            = 0;
+	band_height  = 0;
+}
+
+auto TileScheduler::GetPixelsPerFrame() const -> u64 {
+	u64 const min_pixels = u64(info.granularity) * info.granularity;
+	if (ms_per_pixel <= 0.0f) return min_pixels;
+	u64 const pixels = static_cast<u64>(info.budget_ms / ms_per_pixel);
+	return std::clamp(pixels, min_pixels, std::max(u64(width) * height, min_pixels));
+}
+
+auto TileScheduler::NextTiles(std::vector<Tile>& tiles) -> u64 {
+	u32 const  granularity = info.granularity;
+	auto const RoundDown   = [granularity](u64 value) { return static_cast<u32>(std::max<u64>(value / granularity * granularity, granularity)); };
+
+	u64 const budget = GetPixelsPerFrame();
+	u64       drawn  = 0;
+	for (u32 count = 0; count < info.max_tiles && !IsComplete(); ++count) {
+		if (x == 0) {
+			// Square tiles while the budget is below a square of the image width, whole rows above it
+			u64 const side = std::max(static_cast<u64>(std::sqrt(static_cast<double>(budget))), budget / width);
+			band_height    = std::min(RoundDown(side), height - y);
+		}
+		u64 const left = budget > drawn ? budget - drawn : 0;
+		if (drawn > 0 && left < u64(granularity) * band_height) break;
+		u32 const tile_width = std::min(RoundDown(left / band_height), width - x);
+		tiles.push_back({.x = x, .y = y, .width = tile_width, .height = band_height});
+		drawn += u64(tile_width) * band_height;
+		x += tile_width;
+		if (x >= width) {
+			x = 0;
+			y += band_height;
+		}
+	}
+	return drawn;
+}
+
+void TileScheduler::AddTime(u64 pixel_count, float gpu_ms) {
+	if (pixel_count == 0 || gpu_ms <= 0.0f) return;
+	float const measured = gpu_ms / static_cast<float>(pixel_count);
+	if (ms_per_pixel <= 0.0f || measured >= ms_per_pixel) {
+		ms_per_pixel = measured;
+	} else {
+		ms_per_pixel = std::max(measured, ms_per_pixel / kMaxGrowth);
+	}
+}
+
+auto TileScheduler::GetProgress() const -> float {
+	if (width == 0 || height == 0) return 1.0f;
+	if (IsComplete()) return 1.0f;
+	u64 const drawn = u64(y) * width + u64(x) * band_height;
+	return static_cast<float>(static_cast<double>(drawn) / (static_cast<double>(width) * height));
+}
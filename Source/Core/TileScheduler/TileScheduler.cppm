@@ -0,0 +1,58 @@
+export module TileScheduler;
+
+import std;
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+export struct TileSchedulerInfo {
+	// GPU time of the tiles drawn in one frame in milliseconds
+	float budget_ms = 8.0f;
+	// Tile edges are multiples of this, except at the right and bottom of the image
+	u32 granularity = 32;
+	// Tiles drawn in one frame at most
+	u32 max_tiles = 64;
+};
+
+export struct Tile {
+	u32 x      = 0;
+	u32 y      = 0;
+	u32 width  = 0;
+	u32 height = 0;
+};
+
+// Splits an image into tiles drawn over several frames, each frame as many pixels as fit the time budget.
+// The cost of a pixel is learned from measured GPU times. Before the first measurement a frame draws one
+// tile of the granularity, afterwards the estimate follows slower shaders at once and faster ones at most
+// doubling the pixels per frame, so a single frame never runs far over the budget.
+// Tiles are laid out in bands from the top, a band's height is chosen when it starts and the widths of
+// its tiles follow the current estimate.
+export class TileScheduler {
+public:
+	void Init(TileSchedulerInfo const& info);
+
+	// Starts a new pass over an image of width x height
+	void Restart(u32 width, u32 height);
+	// Appends the tiles of the next frame, none once the pass is complete. Returns their pixel count.
+	auto NextTiles(std::vector<Tile>& tiles) -> u64;
+
+	// GPU time of a frame that drew pixel_count pixels of tiles
+	void AddTime(u64 pixel_count, float gpu_ms);
+	// Forgets the cost of a pixel, e.g. for another shader
+	void ResetEstimate() { ms_per_pixel = 0.0f; }
+
+	bool IsComplete() const { return y >= height; }
+	// Fraction of the pass drawn
+	auto GetProgress() const -> float;
+	auto GetPixelsPerFrame() const -> u64;
+	auto GetInfo() const -> TileSchedulerInfo const& { return info; }
+
+private:
+	TileSchedulerInfo info;
+	u32               width        = 0;
+	u32               height       = 0;
+	u32               x            = 0;
+	u32               y            = 0;
+	u32               band_height  = 0;
+	float             ms_per_pixel = 0.0f; // 0 until the first measurement
+};
@@ -3,6 +3,5 @@ import Application;
 
 int main(int argc, char* argv[]) {
 	MainApplication app;
-	app.Run(argc, argv);
-	return 0;
+	return app.Run(argc, argv);
 }
\ No newline at end of file
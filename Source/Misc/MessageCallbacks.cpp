@@ -1,33 +1,32 @@
+module;
+#include "Log/LogMacros.hpp"
 module MessageCallbacks;
 
 import std;
 import vulkan_hpp;
+import Log;
 
-#define ANSI_COLOR_RED "\x1b[31m"
-#define ANSI_COLOR_GREEN "\x1b[32m"
-#define ANSI_COLOR_YELLOW "\x1b[33m"
-#define ANSI_COLOR_RESET "\x1b[0m"
-
+// Validation often repeats a message every frame, repeats are counted by the logger instead of written
 vk::Bool32 DebugUtilsCallback(vk::DebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
 							  vk::DebugUtilsMessageTypeFlagsEXT             messageTypes,
 							  const vk::DebugUtilsMessengerCallbackDataEXT* pCallbackData,
 							  void*                                         pUserData) {
 
 	if (messageSeverity & vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose) {
-		std::printf("%s\n", pCallbackData->pMessage);
+		LOG_MESSAGE_RATE_LIMITED(LogLevel::Trace, pCallbackData->pMessage);
 	}
 	if (messageSeverity & vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo) {
-		std::printf("[" ANSI_COLOR_GREEN "I" ANSI_COLOR_RESET "] %s\n", pCallbackData->pMessage);
+		LOG_MESSAGE_RATE_LIMITED(LogLevel::Info, pCallbackData->pMessage);
 	}
 	if (messageSeverity & vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning) {
-		std::printf("[" ANSI_COLOR_YELLOW "W" ANSI_COLOR_RESET "] %s\n", pCallbackData->pMessage);
+		LOG_MESSAGE_RATE_LIMITED(LogLevel::Warning, pCallbackData->pMessage);
 	}
 	if (messageSeverity & vk::DebugUtilsMessageSeverityFlagBitsEXT::eError) {
-		std::printf("[" ANSI_COLOR_RED "E" ANSI_COLOR_RESET "] %s\n", pCallbackData->pMessage);
+		LOG_MESSAGE_RATE_LIMITED(LogLevel::Error, pCallbackData->pMessage);
 	}
 	return vk::False;
 }
 
 void WindowErrorCallback(int error, char const* description) {
-	std::printf("[" ANSI_COLOR_RED "Window Error" ANSI_COLOR_RESET "] (%d) {%s}", error, description);
+	LOG_ERROR("Window Error (%d) {%s}", error, description);
 }
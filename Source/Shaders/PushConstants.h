@@ -1,6 +1,16 @@
 #ifndef SHADER_PLAYGROUND_PUSHCONSTANTS_H
 #define SHADER_PLAYGROUND_PUSHCONSTANTS_H
 
+// Values are passed as push constants and, with the same layout, in a uniform buffer at
+// set 0, binding 0. Prerecorded command buffers (--prerecord) only update the uniform buffer:
+//   layout(set = 0, binding = 0) uniform FrameUniforms { PushConstants frame; };
+// With buffer passes (<name>.bufferA<ext> to <name>.bufferD<ext>) Buffer A-D are sampled as
+//   layout(set = 1, binding = 0..3) uniform sampler2D iChannel0..3;
+// Compute shaders (.comp) run one invocation per pixel and write their output to
+//   layout(set = 1, binding = 4, rgba16f) uniform writeonly image2D iOutput;
+// with the workgroup size picked for the device through
+//   layout(local_size_x_id = 0, local_size_y_id = 1) in;
+
 #ifdef __cplusplus
 struct PushConstants {
 	float resolution[2];
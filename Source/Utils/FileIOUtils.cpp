@@ -29,15 +29,15 @@ auto ReadBinaryFile(std::string_view const filename) -> std::optional<std::vecto
 	return std::move(buffer);
 }
 
-auto GetFileVersion(std::string_view const filename) -> int {
-	std::filesystem::path file_path(filename);
-	if (!std::filesystem::exists(file_path)) {
+// Last write time in nanoseconds, -1 if the file does not exist
+auto GetFileVersion(std::string_view const filename) -> std::int64_t {
+	std::error_code error;
+	auto            last_write_time = std::filesystem::last_write_time(std::filesystem::path(filename), error);
+	if (error) {
 		return -1;
 	}
-	auto last_write_time = std::filesystem::last_write_time(file_path);
-	auto duration        = last_write_time.time_since_epoch();
-	auto seconds         = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
-	return static_cast<int>(seconds);
+	auto duration = last_write_time.time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
 }
 
 } // namespace Utils
@@ -0,0 +1,81 @@
+export module StatsUtils;
+import std;
+
+export namespace Utils {
+
+struct SampleStats {
+	std::uint32_t count = 0;
+	float         min   = 0.0f;
+	float         avg   = 0.0f;
+	float         p50   = 0.0f;
+	float         p95   = 0.0f;
+	float         p99   = 0.0f;
+	float         max   = 0.0f;
+};
+
+// Nearest-rank percentiles, reorders the samples
+inline auto ComputeStatsInPlace(std::span<float> samples) -> SampleStats {
+	if (samples.empty()) return {};
+	std::ranges::sort(samples);
+
+	std::size_t const count      = samples.size();
+	auto              Percentile = [samples, count](float percent) {
+		std::size_t const rank = static_cast<std::size_t>(std::ceil(percent / 100.0f * count));
+		return samples[std::clamp<std::size_t>(rank, 1, count) - 1];
+	};
+	double const sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+	return {
+		.count = static_cast<std::uint32_t>(count),
+		.min   = samples.front(),
+		.avg   = static_cast<float>(sum / count),
+		.p50   = Percentile(50.0f),
+		.p95   = Percentile(95.0f),
+		.p99   = Percentile(99.0f),
+		.max   = samples.back(),
+	};
+}
+
+// Keeps the last kCapacity samples, no allocations after construction
+template <std::size_t kCapacity>
+class SampleRing {
+public:
+	void Push(float value) {
+		samples[next] = value;
+		next          = (next + 1) % kCapacity;
+		count         = std::min(count + 1, kCapacity);
+		++total_count;
+	}
+
+	void Clear() {
+		next  = 0;
+		count = 0;
+	}
+
+	auto GetCount() const -> std::size_t { return count; }
+	auto GetTotalCount() const -> std::uint64_t { return total_count; }
+	bool IsEmpty() const { return count == 0; }
+
+	// Calls func for every sample, oldest first
+	template <typename Func>
+	void ForEach(Func&& func) const {
+		std::size_t const first = (next + kCapacity - count) % kCapacity;
+		for (std::size_t i = 0; i < count; ++i) {
+			func(samples[(first + i) % kCapacity]);
+		}
+	}
+
+	// Nearest-rank percentiles over the samples currently in the ring
+	auto ComputeStats() const -> SampleStats {
+		std::array<float, kCapacity> sorted;
+		std::copy_n(samples.begin(), count, sorted.begin());
+		return ComputeStatsInPlace(std::span(sorted.data(), count));
+	}
+
+private:
+	std::array<float, kCapacity> samples{};
+	std::size_t                  next        = 0;
+	std::size_t                  count       = 0;
+	std::uint64_t                total_count = 0;
+};
+
+} // namespace Utils
@@ -2,6 +2,7 @@ export module Utils;
 export import FileIOUtils;
 export import VulkanUtils;
 export import ParseUtils;
+export import StatsUtils;
 
 import std;
 export namespace Utils {
@@ -10,4 +11,21 @@ constexpr inline auto FormatBool(bool value) -> std::string_view { return value
 inline void HashCombine(std::size_t& hash, std::size_t value) {
 	hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
 }
+
+// 64-bit FNV-1a, stable across runs so it can be stored on disk
+constexpr inline auto HashBytes(std::span<std::byte const> bytes, std::uint64_t hash = 0xcbf29ce484222325ull) -> std::uint64_t {
+	for (std::byte const byte : bytes) {
+		hash ^= std::to_integer<std::uint64_t>(byte);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+constexpr inline auto HashString(std::string_view const str, std::uint64_t hash = 0xcbf29ce484222325ull) -> std::uint64_t {
+	for (char const c : str) {
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
 } // namespace Utils
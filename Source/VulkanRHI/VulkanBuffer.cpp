@@ -0,0 +1,108 @@
+module VulkanRHI;
+import :Buffer;
+import :PhysicalDevice;
+
+import vulkan_hpp;
+import std;
+
+using u32 = std::uint32_t;
+
+#define RETURN_ON_ERROR(func) \
+	{ \
+		vk::Result local_result_ = (func); \
+		if (local_result_ != vk::Result::eSuccess) { \
+			return local_result_; \
+		} \
+	}
+
+namespace VulkanRHI {
+
+Buffer::~Buffer() { Destroy(); }
+
+Buffer::Buffer(Buffer&& other) noexcept {
+	this->operator=(std::move(other));
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+	if (this != &other) {
+		Destroy();
+		vk::Buffer::operator=(std::exchange(static_cast<vk::Buffer&>(other), {}));
+		device    = std::exchange(other.device, {});
+		allocator = other.allocator;
+		memory    = std::exchange(other.memory, {});
+		mapped    = std::exchange(other.mapped, nullptr);
+		bCoherent = other.bCoherent;
+		info      = other.info;
+	}
+	return *this;
+}
+
+auto Buffer::Create(vk::Device                     device,
+					PhysicalDevice const&          physical_device,
+					BufferInfo const&              info,
+					vk::AllocationCallbacks const* allocator) -> vk::Result {
+	Destroy();
+	this->device    = device;
+	this->allocator = allocator;
+	this->info      = info;
+
+	vk::BufferCreateInfo buffer_info{
+		.size        = info.size,
+		.usage       = info.usage,
+		.sharingMode = vk::SharingMode::eExclusive,
+	};
+	RETURN_ON_ERROR(GetDevice().createBuffer(&buffer_info, GetAllocator(), this));
+
+	vk::MemoryRequirements requirements;
+	GetDevice().getBufferMemoryRequirements(*this, &requirements);
+	std::optional<u32> memory_type = physical_device.FindMemoryType(requirements.memoryTypeBits, info.memory_properties);
+	if (!memory_type.has_value()) {
+		return vk::Result::eErrorOutOfDeviceMemory;
+	}
+	vk::MemoryAllocateInfo alloc_info{
+		.allocationSize  = requirements.size,
+		.memoryTypeIndex = memory_type.value(),
+	};
+	RETURN_ON_ERROR(GetDevice().allocateMemory(&alloc_info, GetAllocator(), &memory));
+	RETURN_ON_ERROR(GetDevice().bindBufferMemory(*this, memory, 0));
+
+	vk::MemoryPropertyFlags const type_flags = physical_device.GetMemoryProperties().memoryProperties.memoryTypes[memory_type.value()].propertyFlags;
+	bCoherent                                = static_cast<bool>(type_flags & vk::MemoryPropertyFlagBits::eHostCoherent);
+	if (type_flags & vk::MemoryPropertyFlagBits::eHostVisible) {
+		RETURN_ON_ERROR(GetDevice().mapMemory(memory, 0, vk::WholeSize, {}, &mapped));
+	}
+	return vk::Result::eSuccess;
+}
+
+void Buffer::Destroy() {
+	if (!GetDevice()) {
+		return;
+	}
+	if (mapped) {
+		GetDevice().unmapMemory(memory);
+		mapped = nullptr;
+	}
+	GetDevice().destroyBuffer(*this, GetAllocator());
+	GetDevice().freeMemory(memory, GetAllocator());
+	vk::Buffer::operator=(vk::Buffer{});
+	memory = vk::DeviceMemory{};
+	device = vk::Device{};
+}
+
+auto Buffer::Invalidate() const -> vk::Result {
+	if (!mapped || bCoherent) {
+		return vk::Result::eSuccess;
+	}
+	vk::MappedMemoryRange range{.memory = memory, .offset = 0, .size = vk::WholeSize};
+	return GetDevice().invalidateMappedMemoryRanges(1, &range);
+}
+
+auto Buffer::Flush() const -> vk::Result {
+	if (!mapped || bCoherent) {
+		return vk::Result::eSuccess;
+	}
+	vk::MappedMemoryRange range{.memory = memory, .offset = 0, .size = vk::WholeSize};
+	return GetDevice().flushMappedMemoryRanges(1, &range);
+}
+
+} // namespace VulkanRHI
@@ -0,0 +1,56 @@
+export module VulkanRHI:Buffer;
+
+import vulkan_hpp;
+import std;
+import :PhysicalDevice;
+
+export namespace VulkanRHI {
+
+struct BufferInfo {
+	vk::DeviceSize          size              = 0;
+	vk::BufferUsageFlags    usage             = {};
+	vk::MemoryPropertyFlags memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+};
+
+// Buffer with its own memory allocation. Host visible buffers stay mapped for their lifetime
+class Buffer : public vk::Buffer {
+public:
+	Buffer() = default;
+
+	Buffer(Buffer const&)            = delete;
+	Buffer& operator=(Buffer const&) = delete;
+	Buffer(Buffer&& other) noexcept;
+	Buffer& operator=(Buffer&& other) noexcept;
+
+	~Buffer();
+
+	[[nodiscard]] auto Create(vk::Device                     device,
+							  PhysicalDevice const&          physical_device,
+							  BufferInfo const&              info,
+							  vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
+
+	void Destroy();
+
+	// Makes device writes visible to the host, no-op for coherent memory
+	[[nodiscard]] auto Invalidate() const -> vk::Result;
+	// Makes host writes visible to the device, no-op for coherent memory
+	[[nodiscard]] auto Flush() const -> vk::Result;
+
+	auto GetMappedData() const -> std::span<std::byte> { return {static_cast<std::byte*>(mapped), mapped ? info.size : 0}; }
+	auto GetMemory() const -> vk::DeviceMemory { return memory; }
+	auto GetSize() const -> vk::DeviceSize { return info.size; }
+
+	auto GetDevice() const -> vk::Device const& { return device; }
+	auto GetAllocator() const -> vk::AllocationCallbacks const* { return allocator; }
+
+private:
+	vk::Device                     device;
+	vk::AllocationCallbacks const* allocator = nullptr;
+
+	vk::DeviceMemory memory;
+	void*            mapped    = nullptr;
+	bool             bCoherent = false;
+	BufferInfo       info;
+};
+
+} // namespace VulkanRHI
@@ -82,6 +82,41 @@ void CommandBuffer::Barrier(std::span<vk::MemoryBarrier2 const> const barriers)
 	pipelineBarrier2(&dependency);
 }
 
+void CommandBuffer::Barrier(std::span<ImageBarrier const> const barriers) {
+	if (barriers.empty()) {
+		return;
+	}
+	std::vector<vk::ImageMemoryBarrier2> barriers2;
+	barriers2.reserve(barriers.size());
+	for (ImageBarrier const& barrier : barriers) {
+		barriers2.push_back({
+			.srcStageMask        = barrier.srcStageMask,
+			.srcAccessMask       = barrier.srcAccessMask,
+			.dstStageMask        = barrier.dstStageMask,
+			.dstAccessMask       = barrier.dstAccessMask,
+			.oldLayout           = barrier.oldLayout,
+			.newLayout           = barrier.newLayout,
+			.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+			.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+			.image               = barrier.image,
+			.subresourceRange{
+				.aspectMask     = barrier.aspectMask,
+				.baseMipLevel   = 0,
+				.levelCount     = vk::RemainingMipLevels,
+				.baseArrayLayer = 0,
+				.layerCount     = vk::RemainingArrayLayers,
+			},
+		});
+	}
+
+	vk::DependencyInfo const dependency{
+		.imageMemoryBarrierCount = static_cast<u32>(barriers2.size()),
+		.pImageMemoryBarriers    = barriers2.data(),
+	};
+
+	pipelineBarrier2(&dependency);
+}
+
 void CommandBuffer::BeginRendering(RenderingInfo const& info) {
 	vk::RenderingInfoKHR renderingInfo{
 		.flags                = info.flags,
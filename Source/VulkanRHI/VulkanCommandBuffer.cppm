@@ -62,6 +62,7 @@ public:
 	void Barrier(BufferBarrier const& barrier);
 	void Barrier(ImageBarrier const& barrier);
 	void Barrier(std::span<vk::MemoryBarrier2 const> const barriers);
+	void Barrier(std::span<ImageBarrier const> const barriers);
 
 	void BeginRendering(RenderingInfo const& info);
 	void SetViewport(Viewport const& viewport);
@@ -0,0 +1,23 @@
+module VulkanRHI;
+import :DeletionQueue;
+
+import vulkan_hpp;
+import std;
+
+namespace VulkanRHI {
+
+void DeletionQueue::Flush(vk::Device device, vk::AllocationCallbacks const* allocator) {
+	auto DestroyHandle = [device, allocator](auto object) {
+		if constexpr (std::is_same_v<decltype(object), vk::DeviceMemory>) {
+			device.freeMemory(object, allocator);
+		} else {
+			device.destroy(object, allocator);
+		}
+	};
+	for (Handle const& handle : handles) {
+		std::visit(DestroyHandle, handle);
+	}
+	handles.clear();
+}
+
+} // namespace VulkanRHI
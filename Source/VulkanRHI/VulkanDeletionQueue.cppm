@@ -0,0 +1,42 @@
+export module VulkanRHI:DeletionQueue;
+
+import vulkan_hpp;
+import std;
+
+export namespace VulkanRHI {
+
+// Handles that are destroyed together once the GPU has finished with them.
+// The owner decides when that is, usually after waiting for a frame's fence.
+class DeletionQueue {
+public:
+	using Handle = std::variant<vk::Pipeline,
+								vk::PipelineLayout,
+								vk::ShaderModule,
+								vk::ImageView,
+								vk::Image,
+								vk::Buffer,
+								vk::DeviceMemory,
+								vk::Sampler,
+								vk::DescriptorPool,
+								vk::QueryPool,
+								vk::SwapchainKHR>;
+
+	// Null handles are ignored
+	template <typename T>
+	void Push(T handle) {
+		if (handle) {
+			handles.emplace_back(handle);
+		}
+	}
+
+	// Destroys everything pushed so far, in the order it was pushed
+	void Flush(vk::Device device, vk::AllocationCallbacks const* allocator);
+
+	auto GetSize() const -> std::size_t { return handles.size(); }
+	bool IsEmpty() const { return handles.empty(); }
+
+private:
+	std::vector<Handle> handles;
+};
+
+} // namespace VulkanRHI
@@ -19,3 +19,8 @@ void LoadDeviceDebugUtilsFunctionsEXT(vk::Device device) {
 	pfn_vkSetDebugUtilsObjectNameEXT = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(
 		vkGetDeviceProcAddr(device, "vkSetDebugUtilsObjectName"));
 }
+
+void LoadDevicePresentWaitFunctionsKHR(vk::Device device) {
+	pfn_vkWaitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+		vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+}
@@ -4,4 +4,5 @@ import vulkan_hpp;
 export {
 	void LoadInstanceDebugUtilsFunctionsEXT(vk::Instance instance);
 	void LoadDeviceDebugUtilsFunctionsEXT(vk::Device device);
+	void LoadDevicePresentWaitFunctionsKHR(vk::Device device);
 }
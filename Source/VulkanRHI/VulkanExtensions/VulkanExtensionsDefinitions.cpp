@@ -9,6 +9,9 @@ PFN_vkCreateDebugUtilsMessengerEXT  pfn_vkCreateDebugUtilsMessengerEXT = nullptr
 PFN_vkDestroyDebugUtilsMessengerEXT pfn_vkDestroyDebugUtilsMessengerEXT = nullptr;
 PFN_vkSetDebugUtilsObjectNameEXT    pfn_vkSetDebugUtilsObjectNameEXT = nullptr;
 
+// VK_KHR_present_wait
+PFN_vkWaitForPresentKHR pfn_vkWaitForPresentKHR = nullptr;
+
 // VK_EXT_debug_utils
 VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(
 	VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
@@ -25,4 +28,9 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyDebugUtilsMessengerEXT(VkInstance
 VKAPI_ATTR VkResult VKAPI_CALL vkSetDebugUtilsObjectNameEXT(VkDevice                             device,
 															const VkDebugUtilsObjectNameInfoEXT* pNameInfo) {
 	return pfn_vkSetDebugUtilsObjectNameEXT(device, pNameInfo);
-}
\ No newline at end of file
+}
+
+// VK_KHR_present_wait
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitForPresentKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t presentId, uint64_t timeout) {
+	return pfn_vkWaitForPresentKHR(device, swapchain, presentId, timeout);
+}
@@ -6,3 +6,6 @@
 extern PFN_vkCreateDebugUtilsMessengerEXT  pfn_vkCreateDebugUtilsMessengerEXT;
 extern PFN_vkDestroyDebugUtilsMessengerEXT pfn_vkDestroyDebugUtilsMessengerEXT;
 extern PFN_vkSetDebugUtilsObjectNameEXT    pfn_vkSetDebugUtilsObjectNameEXT;
+
+// VK_KHR_present_wait
+extern PFN_vkWaitForPresentKHR pfn_vkWaitForPresentKHR;
@@ -0,0 +1,115 @@
+module VulkanRHI;
+import :Image;
+import :PhysicalDevice;
+import :DeletionQueue;
+
+import vulkan_hpp;
+import std;
+
+#define RETURN_ON_ERROR(func) \
+	{ \
+		vk::Result local_result_ = (func); \
+		if (local_result_ != vk::Result::eSuccess) { \
+			return local_result_; \
+		} \
+	}
+
+namespace VulkanRHI {
+
+Image::~Image() { Destroy(); }
+
+Image::Image(Image&& other) noexcept {
+	this->operator=(std::move(other));
+}
+
+Image& Image::operator=(Image&& other) noexcept {
+	if (this != &other) {
+		Destroy();
+		vk::Image::operator=(std::exchange(static_cast<vk::Image&>(other), {}));
+		device    = std::exchange(other.device, {});
+		allocator = other.allocator;
+		memory    = std::exchange(other.memory, {});
+		view      = std::exchange(other.view, {});
+		info      = other.info;
+	}
+	return *this;
+}
+
+auto Image::Create(vk::Device                     device,
+				   PhysicalDevice const&          physical_device,
+				   ImageInfo const&               info,
+				   vk::AllocationCallbacks const* allocator) -> vk::Result {
+	Destroy();
+	this->device    = device;
+	this->allocator = allocator;
+	this->info      = info;
+
+	vk::ImageCreateInfo image_info{
+		.imageType     = vk::ImageType::e2D,
+		.format        = info.format,
+		.extent        = {info.extent.width, info.extent.height, 1},
+		.mipLevels     = 1,
+		.arrayLayers   = 1,
+		.samples       = vk::SampleCountFlagBits::e1,
+		.tiling        = vk::ImageTiling::eOptimal,
+		.usage         = info.usage,
+		.sharingMode   = vk::SharingMode::eExclusive,
+		.initialLayout = vk::ImageLayout::eUndefined,
+	};
+	RETURN_ON_ERROR(GetDevice().createImage(&image_info, GetAllocator(), this));
+
+	vk::MemoryRequirements requirements;
+	GetDevice().getImageMemoryRequirements(*this, &requirements);
+	std::optional<u32> memory_type = physical_device.FindMemoryType(requirements.memoryTypeBits, info.memory_properties);
+	if (!memory_type.has_value()) {
+		return vk::Result::eErrorOutOfDeviceMemory;
+	}
+	vk::MemoryAllocateInfo alloc_info{
+		.allocationSize  = requirements.size,
+		.memoryTypeIndex = memory_type.value(),
+	};
+	RETURN_ON_ERROR(GetDevice().allocateMemory(&alloc_info, GetAllocator(), &memory));
+	RETURN_ON_ERROR(GetDevice().bindImageMemory(*this, memory, 0));
+
+	vk::ImageViewCreateInfo view_info{
+		.image    = *this,
+		.viewType = vk::ImageViewType::e2D,
+		.format   = info.format,
+		.subresourceRange{
+			.aspectMask     = info.aspect,
+			.baseMipLevel   = 0,
+			.levelCount     = 1,
+			.baseArrayLayer = 0,
+			.layerCount     = 1,
+		},
+	};
+	return GetDevice().createImageView(&view_info, GetAllocator(), &view);
+}
+
+void Image::Destroy() {
+	if (!GetDevice()) {
+		return;
+	}
+	GetDevice().destroyImageView(view, GetAllocator());
+	GetDevice().destroyImage(*this, GetAllocator());
+	GetDevice().freeMemory(memory, GetAllocator());
+	vk::Image::operator=(vk::Image{});
+	view   = vk::ImageView{};
+	memory = vk::DeviceMemory{};
+	device = vk::Device{};
+}
+
+void Image::DestroyDeferred(DeletionQueue& queue) {
+	if (!GetDevice()) {
+		return;
+	}
+	queue.Push(view);
+	queue.Push(static_cast<vk::Image>(*this));
+	queue.Push(memory);
+	vk::Image::operator=(vk::Image{});
+	view   = vk::ImageView{};
+	memory = vk::DeviceMemory{};
+	device = vk::Device{};
+}
+
+} // namespace VulkanRHI
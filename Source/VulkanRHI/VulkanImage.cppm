@@ -0,0 +1,59 @@
+export module VulkanRHI:Image;
+
+import vulkan_hpp;
+import std;
+import :PhysicalDevice;
+import :DeletionQueue;
+
+export namespace VulkanRHI {
+
+using u32 = std::uint32_t;
+
+struct ImageInfo {
+	vk::Extent2D            extent            = {};
+	vk::Format              format            = vk::Format::eR8G8B8A8Unorm;
+	vk::ImageUsageFlags     usage             = vk::ImageUsageFlagBits::eColorAttachment;
+	vk::ImageAspectFlags    aspect            = vk::ImageAspectFlagBits::eColor;
+	vk::MemoryPropertyFlags memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+};
+
+// 2D image with its own memory allocation and a view of the whole image
+class Image : public vk::Image {
+public:
+	Image() = default;
+
+	Image(Image const&)            = delete;
+	Image& operator=(Image const&) = delete;
+	Image(Image&& other) noexcept;
+	Image& operator=(Image&& other) noexcept;
+
+	~Image();
+
+	[[nodiscard]] auto Create(vk::Device                     device,
+							  PhysicalDevice const&          physical_device,
+							  ImageInfo const&               info,
+							  vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
+
+	void Destroy();
+	// Hands the handles to the queue instead of destroying them now, for images the GPU may still use
+	void DestroyDeferred(DeletionQueue& queue);
+
+	auto GetView() const -> vk::ImageView { return view; }
+	auto GetMemory() const -> vk::DeviceMemory { return memory; }
+	auto GetExtent() const -> vk::Extent2D const& { return info.extent; }
+	auto GetFormat() const -> vk::Format { return info.format; }
+	auto GetInfo() const -> ImageInfo const& { return info; }
+
+	auto GetDevice() const -> vk::Device const& { return device; }
+	auto GetAllocator() const -> vk::AllocationCallbacks const* { return allocator; }
+
+private:
+	vk::Device                     device;
+	vk::AllocationCallbacks const* allocator = nullptr;
+
+	vk::DeviceMemory memory;
+	vk::ImageView    view;
+	ImageInfo        info;
+};
+
+} // namespace VulkanRHI
@@ -62,6 +62,9 @@ auto PhysicalDevice::GetQueueFamilyIndex(QueueFamilyInfo const& info) const -> s
 		if ((queue_family_properties[index].queueFamilyProperties.queueFlags & info.flags) == info.flags &&
 			(info.undesired_flags == vk::QueueFlags{} ||
 			 (queue_family_properties[index].queueFamilyProperties.queueFlags & info.undesired_flags) != info.undesired_flags)) {
+			if (!info.surface) {
+				return {vk::Result::eSuccess, index};
+			}
 			vk::Bool32 bSupportsSurface;
 			vk::Result result = getSurfaceSupportKHR(index, info.surface, &bSupportsSurface);
 			if (result != vk::Result::eSuccess) {
@@ -122,4 +125,14 @@ auto PhysicalDevice::GetMaxPushConstantsSize() const -> u32 {
 	return GetProperties10().limits.maxPushConstantsSize;
 }
 
+auto PhysicalDevice::FindMemoryType(u32 type_bits, vk::MemoryPropertyFlags properties) const -> std::optional<u32> {
+	vk::PhysicalDeviceMemoryProperties const& memory = memory_properties.memoryProperties;
+	for (u32 index = 0; index < memory.memoryTypeCount; ++index) {
+		if ((type_bits & (1u << index)) && (memory.memoryTypes[index].propertyFlags & properties) == properties) {
+			return index;
+		}
+	}
+	return std::nullopt;
+}
+
 } // namespace VulkanRHI
@@ -8,7 +8,7 @@ using u32 = std::uint32_t;
 struct QueueFamilyInfo {
 	vk::QueueFlags flags;
 	vk::QueueFlags undesired_flags = {};
-	vk::SurfaceKHR surface         = {};
+	vk::SurfaceKHR surface         = {}; // null to skip the present support check
 };
 
 class PhysicalDevice : public vk::PhysicalDevice {
@@ -53,6 +53,7 @@ public:
 	auto GetQueueCount(u32 queue_family_index) const -> u32;
 	auto GetQueueFamilyProperties(u32 queue_family_index) const -> vk::QueueFamilyProperties const&;
 	auto GetMaxPushConstantsSize() const -> u32;
+	auto FindMemoryType(u32 type_bits, vk::MemoryPropertyFlags properties) const -> std::optional<u32>;
 
 	constexpr inline auto GetFeatures2() -> vk::PhysicalDeviceFeatures2& { return features.features2; }
 	constexpr inline auto GetFeatures10() -> vk::PhysicalDeviceFeatures& { return features.features2.features; }
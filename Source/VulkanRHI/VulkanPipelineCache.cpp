@@ -0,0 +1,183 @@
+module VulkanRHI;
+import :PipelineCache;
+import :PhysicalDevice;
+
+import vulkan_hpp;
+import std;
+import Utils;
+
+#define RETURN_ON_ERROR(func) \
+	{ \
+		vk::Result local_result_ = (func); \
+		if (local_result_ != vk::Result::eSuccess) { \
+			return local_result_; \
+		} \
+	}
+
+namespace VulkanRHI {
+
+PipelineCache::~PipelineCache() { Destroy(); }
+
+auto PipelineCache::Create(vk::Device                     device,
+						   PhysicalDevice const&          physical_device,
+						   PipelineCacheInfo const&       info,
+						   vk::AllocationCallbacks const* allocator) -> vk::Result {
+	this->device    = device;
+	this->allocator = allocator;
+	file_path       = info.file_path;
+	max_size        = info.max_size;
+
+	vk::PhysicalDeviceProperties const& properties = physical_device.GetProperties10();
+	vendor_id                                      = properties.vendorID;
+	device_id                                      = properties.deviceID;
+	driver_version                                 = properties.driverVersion;
+	std::memcpy(pipeline_cache_uuid, properties.pipelineCacheUUID.data(), sizeof(pipeline_cache_uuid));
+
+	std::vector<std::byte> initial_data = ReadFile(&loaded_hash);
+	loaded_size                         = initial_data.size();
+
+	vk::PipelineCacheCreateInfo create_info{
+		.initialDataSize = initial_data.size(),
+		.pInitialData    = initial_data.data(),
+	};
+	vk::Result result = GetDevice().createPipelineCache(&create_info, GetAllocator(), this);
+	if (result != vk::Result::eSuccess && !initial_data.empty()) {
+		// Driver rejected the blob, start empty
+		loaded_hash = 0;
+		loaded_size = 0;
+		create_info = vk::PipelineCacheCreateInfo{};
+		result      = GetDevice().createPipelineCache(&create_info, GetAllocator(), this);
+	}
+	return result;
+}
+
+auto PipelineCache::Save() -> vk::Result {
+	saved_size       = 0;
+	bSizeCapExceeded = false;
+	if (!*this || file_path.empty()) {
+		return vk::Result::eSuccess;
+	}
+
+	u64                    file_hash = 0;
+	std::vector<std::byte> file_data = ReadFile(&file_hash);
+	if (!file_data.empty() && file_hash != loaded_hash) {
+		vk::PipelineCacheCreateInfo create_info{
+			.initialDataSize = file_data.size(),
+			.pInitialData    = file_data.data(),
+		};
+		vk::PipelineCache file_cache;
+		if (GetDevice().createPipelineCache(&create_info, GetAllocator(), &file_cache) == vk::Result::eSuccess) {
+			vk::Result result = GetDevice().mergePipelineCaches(*this, 1, &file_cache);
+			GetDevice().destroyPipelineCache(file_cache, GetAllocator());
+			RETURN_ON_ERROR(result);
+		}
+	}
+
+	std::size_t data_size = 0;
+	RETURN_ON_ERROR(GetDevice().getPipelineCacheData(*this, &data_size, nullptr));
+	if (data_size > max_size) {
+		bSizeCapExceeded = true;
+		return vk::Result::eSuccess;
+	}
+	std::vector<std::byte> data(data_size);
+	RETURN_ON_ERROR(GetDevice().getPipelineCacheData(*this, &data_size, data.data()));
+	data.resize(data_size);
+
+	if (data.empty() || !WriteFile(data)) {
+		return vk::Result::eSuccess;
+	}
+	saved_size = data.size();
+	return vk::Result::eSuccess;
+}
+
+void PipelineCache::Destroy() {
+	if (!GetDevice()) {
+		return;
+	}
+	GetDevice().destroyPipelineCache(*this, GetAllocator());
+	vk::PipelineCache::operator=(vk::PipelineCache{});
+	device = vk::Device{};
+}
+
+void PipelineCache::RecordFeedback(vk::PipelineCreationFeedback const& feedback) {
+	if (!(feedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid)) {
+		return;
+	}
+	if (feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit) {
+		hit_count.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		miss_count.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool PipelineCache::IsCompatible(PipelineCacheFileHeader const& header) const {
+	return header.magic == PipelineCacheFileHeader::kMagic &&
+		   header.version == PipelineCacheFileHeader::kVersion &&
+		   header.vendor_id == vendor_id &&
+		   header.device_id == device_id &&
+		   header.driver_version == driver_version &&
+		   std::memcmp(header.pipeline_cache_uuid, pipeline_cache_uuid, sizeof(pipeline_cache_uuid)) == 0;
+}
+
+auto PipelineCache::ReadFile(u64* data_hash) const -> std::vector<std::byte> {
+	if (file_path.empty()) {
+		return {};
+	}
+	std::ifstream file(file_path, std::ios::ate | std::ios::binary);
+	if (!file.is_open()) {
+		return {};
+	}
+	std::size_t const file_size = static_cast<std::size_t>(file.tellg());
+	if (file_size < sizeof(PipelineCacheFileHeader)) {
+		return {};
+	}
+
+	PipelineCacheFileHeader header;
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!IsCompatible(header) ||
+		header.data_size != file_size - sizeof(header) ||
+		header.data_size > max_size) {
+		return {};
+	}
+
+	std::vector<std::byte> data(header.data_size);
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!file || Utils::HashBytes(data) != header.data_hash) {
+		return {};
+	}
+	*data_hash = header.data_hash;
+	return data;
+}
+
+auto PipelineCache::WriteFile(std::span<std::byte const> data) const -> bool {
+	PipelineCacheFileHeader header{
+		.magic          = PipelineCacheFileHeader::kMagic,
+		.version        = PipelineCacheFileHeader::kVersion,
+		.vendor_id      = vendor_id,
+		.device_id      = device_id,
+		.driver_version = driver_version,
+		.data_size      = static_cast<u32>(data.size()),
+		.data_hash      = Utils::HashBytes(data),
+	};
+	std::memcpy(header.pipeline_cache_uuid, pipeline_cache_uuid, sizeof(pipeline_cache_uuid));
+
+	// Write next to the target and rename, so a concurrent reader never sees a partial file
+	std::string const temp_path = file_path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file.write(reinterpret_cast<char const*>(data.data()), data.size());
+		if (!file) {
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temp_path, file_path, error);
+	return !error;
+}
+
+} // namespace VulkanRHI
@@ -0,0 +1,91 @@
+export module VulkanRHI:PipelineCache;
+
+import vulkan_hpp;
+import std;
+import :PhysicalDevice;
+
+export namespace VulkanRHI {
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+struct PipelineCacheInfo {
+	// File the cache is loaded from and saved to. Empty for memory-only cache
+	std::string_view file_path = "";
+	// Cache data larger than this is neither loaded nor saved
+	std::size_t max_size = 32 * 1024 * 1024;
+};
+
+// Written in front of the driver blob. The blob header only has vendor/device id and uuid,
+// driver version is checked here so that driver updates do not feed stale data to the driver
+struct PipelineCacheFileHeader {
+	static constexpr u32 kMagic   = 0x43505053; // "SPPC"
+	static constexpr u32 kVersion = 1;
+
+	u32          magic;
+	u32          version;
+	u32          vendor_id;
+	u32          device_id;
+	u32          driver_version;
+	u32          data_size;
+	u64          data_hash;
+	std::uint8_t pipeline_cache_uuid[vk::UuidSize];
+};
+
+class PipelineCache : public vk::PipelineCache {
+public:
+	PipelineCache() = default;
+
+	PipelineCache(PipelineCache const&)            = delete;
+	PipelineCache& operator=(PipelineCache const&) = delete;
+
+	~PipelineCache();
+
+	[[nodiscard]] auto Create(vk::Device                     device,
+							  PhysicalDevice const&          physical_device,
+							  PipelineCacheInfo const&       info,
+							  vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
+
+	// Merge with the current file contents (other instances may have saved meanwhile) and write it back
+	[[nodiscard]] auto Save() -> vk::Result;
+
+	void Destroy();
+
+	// Call with feedback from vk::PipelineCreationFeedbackCreateInfo after pipeline creation
+	void RecordFeedback(vk::PipelineCreationFeedback const& feedback);
+
+	auto GetHitCount() const -> u32 { return hit_count.load(std::memory_order_relaxed); }
+	auto GetMissCount() const -> u32 { return miss_count.load(std::memory_order_relaxed); }
+	auto GetLoadedSize() const -> std::size_t { return loaded_size; }
+	auto GetSavedSize() const -> std::size_t { return saved_size; }
+	bool IsSizeCapExceeded() const { return bSizeCapExceeded; }
+
+	auto GetDevice() const -> vk::Device const& { return device; }
+	auto GetAllocator() const -> vk::AllocationCallbacks const* { return allocator; }
+
+private:
+	// Returns the validated driver blob stored in the file, empty if missing or incompatible
+	auto ReadFile(u64* data_hash) const -> std::vector<std::byte>;
+	auto WriteFile(std::span<std::byte const> data) const -> bool;
+	bool IsCompatible(PipelineCacheFileHeader const& header) const;
+
+	vk::Device                     device;
+	vk::AllocationCallbacks const* allocator = nullptr;
+
+	std::string  file_path;
+	std::size_t  max_size = 0;
+	u32          vendor_id;
+	u32          device_id;
+	u32          driver_version;
+	std::uint8_t pipeline_cache_uuid[vk::UuidSize];
+
+	u64         loaded_hash      = 0;
+	std::size_t loaded_size      = 0;
+	std::size_t saved_size       = 0;
+	bool        bSizeCapExceeded = false;
+
+	std::atomic<u32> hit_count  = 0;
+	std::atomic<u32> miss_count = 0;
+};
+
+} // namespace VulkanRHI
@@ -0,0 +1,89 @@
+module VulkanRHI;
+import :QueryPool;
+import :PhysicalDevice;
+
+import vulkan_hpp;
+import std;
+
+namespace VulkanRHI {
+
+TimestampQueryPool::~TimestampQueryPool() { Destroy(); }
+
+TimestampQueryPool::TimestampQueryPool(TimestampQueryPool&& other) noexcept {
+	this->operator=(std::move(other));
+}
+
+TimestampQueryPool& TimestampQueryPool::operator=(TimestampQueryPool&& other) noexcept {
+	if (this != &other) {
+		Destroy();
+		vk::QueryPool::operator=(std::exchange(static_cast<vk::QueryPool&>(other), {}));
+		device           = std::exchange(other.device, {});
+		allocator        = other.allocator;
+		query_count      = other.query_count;
+		valid_mask       = other.valid_mask;
+		timestamp_period = other.timestamp_period;
+		bPending         = std::exchange(other.bPending, false);
+	}
+	return *this;
+}
+
+auto TimestampQueryPool::Create(vk::Device                     device,
+								PhysicalDevice const&          physical_device,
+								TimestampQueryPoolInfo const&  info,
+								vk::AllocationCallbacks const* allocator) -> vk::Result {
+	Destroy();
+	this->device     = device;
+	this->allocator  = allocator;
+	query_count      = info.query_count;
+	timestamp_period = physical_device.GetProperties10().limits.timestampPeriod;
+
+	u32 const valid_bits = physical_device.GetQueueFamilyProperties(info.queue_family_index).timestampValidBits;
+	if (valid_bits == 0 || timestamp_period == 0.0) {
+		return vk::Result::eSuccess;
+	}
+	valid_mask = valid_bits >= 64 ? ~u64(0) : (u64(1) << valid_bits) - 1;
+
+	vk::QueryPoolCreateInfo create_info{
+		.queryType  = vk::QueryType::eTimestamp,
+		.queryCount = query_count,
+	};
+	return GetDevice().createQueryPool(&create_info, GetAllocator(), this);
+}
+
+void TimestampQueryPool::Destroy() {
+	if (!GetDevice()) {
+		return;
+	}
+	GetDevice().destroyQueryPool(*this, GetAllocator());
+	vk::QueryPool::operator=(vk::QueryPool{});
+	device   = vk::Device{};
+	bPending = false;
+}
+
+void TimestampQueryPool::Reset(vk::CommandBuffer cmd) {
+	if (!IsSupported()) return;
+	cmd.resetQueryPool(*this, 0, query_count);
+	bPending = true;
+}
+
+void TimestampQueryPool::Write(vk::CommandBuffer cmd, vk::PipelineStageFlagBits2 stage, u32 query) {
+	if (!IsSupported()) return;
+	cmd.writeTimestamp2(stage, *this, query);
+}
+
+auto TimestampQueryPool::ReadElapsedMs(u32 begin_query, u32 end_query) -> std::optional<double> {
+	if (!IsSupported() || !bPending) {
+		return std::nullopt;
+	}
+	u64 begin = 0, end = 0;
+	// Only these two queries are read, they need not be adjacent
+	if (GetDevice().getQueryPoolResults(*this, begin_query, 1, sizeof(begin), &begin, sizeof(u64), vk::QueryResultFlagBits::e64) != vk::Result::eSuccess ||
+		GetDevice().getQueryPoolResults(*this, end_query, 1, sizeof(end), &end, sizeof(u64), vk::QueryResultFlagBits::e64) != vk::Result::eSuccess) {
+		return std::nullopt;
+	}
+	bPending        = false;
+	u64 const ticks = ((end & valid_mask) - (begin & valid_mask)) & valid_mask;
+	return static_cast<double>(ticks) * timestamp_period / 1'000'000.0;
+}
+
+} // namespace VulkanRHI
@@ -0,0 +1,61 @@
+export module VulkanRHI:QueryPool;
+
+import vulkan_hpp;
+import std;
+import :PhysicalDevice;
+
+export namespace VulkanRHI {
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+struct TimestampQueryPoolInfo {
+	u32 queue_family_index = 0; // queue the timestamps are written on
+	u32 query_count        = 2;
+};
+
+// Timestamp queries of one frame in flight. Results are read once the frame's fence
+// has signaled, so reading never waits on the GPU.
+class TimestampQueryPool : public vk::QueryPool {
+public:
+	TimestampQueryPool() = default;
+
+	TimestampQueryPool(TimestampQueryPool const&)            = delete;
+	TimestampQueryPool& operator=(TimestampQueryPool const&) = delete;
+	TimestampQueryPool(TimestampQueryPool&& other) noexcept;
+	TimestampQueryPool& operator=(TimestampQueryPool&& other) noexcept;
+
+	~TimestampQueryPool();
+
+	// Succeeds without creating a pool if the queue does not support timestamps
+	[[nodiscard]] auto Create(vk::Device                     device,
+							  PhysicalDevice const&          physical_device,
+							  TimestampQueryPoolInfo const&  info,
+							  vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
+
+	void Destroy();
+
+	// Record before the first Write of a submission
+	void Reset(vk::CommandBuffer cmd);
+	void Write(vk::CommandBuffer cmd, vk::PipelineStageFlagBits2 stage, u32 query);
+
+	// Milliseconds between two queries of the last submission. Empty if nothing was
+	// written since the last read or the results are not available yet
+	auto ReadElapsedMs(u32 begin_query, u32 end_query) -> std::optional<double>;
+
+	bool IsSupported() const { return static_cast<bool>(*this); }
+
+	auto GetDevice() const -> vk::Device const& { return device; }
+	auto GetAllocator() const -> vk::AllocationCallbacks const* { return allocator; }
+
+private:
+	vk::Device                     device;
+	vk::AllocationCallbacks const* allocator = nullptr;
+
+	u32    query_count      = 0;
+	u64    valid_mask       = 0;
+	double timestamp_period = 0.0; // nanoseconds per tick
+	bool   bPending         = false;
+};
+
+} // namespace VulkanRHI
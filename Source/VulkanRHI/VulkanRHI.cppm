@@ -2,3 +2,9 @@ export module VulkanRHI;
 export import :PhysicalDevice;
 export import :CommandBuffer;
 export import :Swapchain;
+export import :PipelineCache;
+export import :Image;
+export import :Buffer;
+export import :QueryPool;
+export import :DeletionQueue;
+export import :RenderGraph;
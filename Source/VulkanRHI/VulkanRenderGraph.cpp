@@ -0,0 +1,317 @@
+module VulkanRHI;
+import :RenderGraph;
+import :CommandBuffer;
+import :Image;
+import :DeletionQueue;
+import :PhysicalDevice;
+
+import vulkan_hpp;
+import std;
+
+#define RETURN_ON_ERROR(func) \
+	{ \
+		vk::Result local_result_ = (func); \
+		if (local_result_ != vk::Result::eSuccess) { \
+			return local_result_; \
+		} \
+	}
+
+namespace VulkanRHI {
+
+namespace {
+constexpr vk::AccessFlags2 kWriteAccess = vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eShaderStorageWrite |
+										   vk::AccessFlagBits2::eTransferWrite;
+
+struct AccessState {
+	vk::ImageLayout         layout;
+	vk::PipelineStageFlags2 stage;
+	vk::AccessFlags2        access;
+};
+
+auto GetInputAccess(RenderGraphPassType type) -> AccessState {
+	switch (type) {
+	case RenderGraphPassType::eCompute:
+		return {vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead};
+	case RenderGraphPassType::eTransfer:
+		return {vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead};
+	default:
+		return {vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead};
+	}
+}
+
+auto GetOutputAccess(RenderGraphPassType type) -> AccessState {
+	switch (type) {
+	case RenderGraphPassType::eCompute:
+		return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite};
+	case RenderGraphPassType::eTransfer:
+		return {vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite};
+	default:
+		return {vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite};
+	}
+}
+} // namespace
+
+RenderGraph::~RenderGraph() { Reset(); }
+
+auto RenderGraph::AddImage(RenderGraphImageInfo const& info) -> RenderGraphImage {
+	images.push_back({.info = info});
+	return static_cast<RenderGraphImage>(images.size() - 1);
+}
+
+void RenderGraph::AddPass(RenderGraphPassInfo info) {
+	passes.push_back(std::move(info));
+}
+
+auto RenderGraph::Compile(vk::Device                     device,
+						  PhysicalDevice const&          physical_device,
+						  vk::AllocationCallbacks const* allocator) -> vk::Result {
+	for (int pass_index = 0; pass_index < static_cast<int>(passes.size()); ++pass_index) {
+		for (RenderGraphImage output : passes[pass_index].outputs) {
+			if (output >= images.size() || images[output].writer >= 0) {
+				return vk::Result::eErrorInitializationFailed;
+			}
+			images[output].writer   = pass_index;
+			images[output].bStorage = passes[pass_index].type == RenderGraphPassType::eCompute;
+		}
+	}
+	for (int pass_index = 0; pass_index < static_cast<int>(passes.size()); ++pass_index) {
+		for (RenderGraphInput const& input : passes[pass_index].inputs) {
+			if (input.image >= images.size()) {
+				return vk::Result::eErrorInitializationFailed;
+			}
+			ImageEntry& entry = images[input.image];
+			if (entry.info.bExternal) {
+				return vk::Result::eErrorInitializationFailed;
+			}
+			if (input.read == RenderGraphRead::eCurrent && entry.writer >= pass_index) {
+				// Read before or while it is written this frame
+				return vk::Result::eErrorInitializationFailed;
+			}
+			entry.bHistory |= input.read == RenderGraphRead::ePrevious && entry.writer >= 0;
+			entry.last_use = std::max(entry.last_use, pass_index);
+		}
+	}
+
+	// Images written and read in one frame are transient, everything else keeps its contents
+	std::vector<RenderGraphImage> transient_images;
+	for (RenderGraphImage image = 0; image < images.size(); ++image) {
+		ImageEntry& entry = images[image];
+		entry.first_use   = entry.writer;
+		entry.last_use    = std::max(entry.last_use, entry.writer);
+		if (entry.writer >= 0 && !entry.bHistory && !entry.info.bExternal) {
+			transient_images.push_back(image);
+			continue;
+		}
+		entry.physical[0] = AddPhysical(entry);
+		entry.physical[1] = entry.bHistory ? AddPhysical(entry) : entry.physical[0];
+	}
+
+	// Transient images in order of first use take the first compatible image that is free by then
+	std::ranges::sort(transient_images, {}, [this](RenderGraphImage image) { return images[image].first_use; });
+	std::vector<u32> transient_physical;
+	for (RenderGraphImage image : transient_images) {
+		ImageEntry& entry    = images[image];
+		auto const  physical = std::ranges::find_if(transient_physical, [this, &entry](u32 candidate) {
+			PhysicalImage const& other = physical_images[candidate];
+			return other.last_use < entry.first_use && other.format == entry.info.format && other.extent == entry.info.extent;
+		});
+		if (physical == transient_physical.end()) {
+			entry.physical[0] = AddPhysical(entry);
+			transient_physical.push_back(entry.physical[0]);
+		} else {
+			entry.physical[0] = *physical;
+			physical_images[*physical].usage |= entry.bStorage ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlags{};
+		}
+		entry.physical[1]                           = entry.physical[0];
+		physical_images[entry.physical[0]].last_use = entry.last_use;
+	}
+
+	for (PhysicalImage& physical : physical_images) {
+		if (physical.bExternal) continue;
+		RETURN_ON_ERROR(physical.image.Create(device, physical_device,
+											  {
+												  .extent = physical.extent,
+												  .format = physical.format,
+												  .usage  = physical.usage,
+											  },
+											  allocator));
+		physical.handle = physical.image;
+		physical.view   = physical.image.GetView();
+	}
+	return vk::Result::eSuccess;
+}
+
+auto RenderGraph::AddPhysical(ImageEntry const& entry) -> u32 {
+	// Storage only for images written by compute passes, many formats do not support it
+	vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled |
+								vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	if (entry.bStorage) usage |= vk::ImageUsageFlagBits::eStorage;
+	physical_images.push_back({
+		.extent    = entry.info.extent,
+		.format    = entry.info.format,
+		.usage     = usage,
+		.bExternal = entry.info.bExternal,
+	});
+	return static_cast<u32>(physical_images.size() - 1);
+}
+
+void RenderGraph::SetExternalImage(RenderGraphImage image, vk::Image handle, vk::ImageView view, RenderGraphImageState const& state) {
+	PhysicalImage& physical = physical_images[images[image].physical[0]];
+	physical.handle         = handle;
+	physical.view           = view;
+	physical.state          = {.layout = state.layout, .stage = state.stage, .access = state.access};
+}
+
+auto RenderGraph::GetPhysical(RenderGraphImage image, RenderGraphRead read, u32 parity) -> PhysicalImage& {
+	u32 const index = read == RenderGraphRead::ePrevious ? parity ^ 1 : parity;
+	return physical_images[images[image].physical[index]];
+}
+
+auto RenderGraph::GetView(RenderGraphInput const& input, u32 parity) const -> vk::ImageView {
+	u32 const index = input.read == RenderGraphRead::ePrevious ? parity ^ 1 : parity;
+	return physical_images[images[input.image].physical[index]].view;
+}
+
+auto RenderGraph::GetImageState(RenderGraphImage image) const -> RenderGraphImageState {
+	u32 const         parity = frame > 0 ? static_cast<u32>((frame - 1) & 1) : 0;
+	ImageState const& state  = physical_images[images[image].physical[parity]].state;
+	return {.layout = state.layout, .stage = state.stage, .access = state.access};
+}
+
+auto RenderGraph::GetCreatedImageCount() const -> std::size_t {
+	return std::ranges::count_if(physical_images, [](PhysicalImage const& physical) { return static_cast<bool>(physical.image); });
+}
+
+// Inputs that hold nothing yet, never written or read from the previous frame in the first one, are cleared to zero
+void RenderGraph::ClearUnwrittenInputs(CommandBuffer cmd, RenderGraphPassInfo const& pass, u32 parity) {
+	std::vector<ImageBarrier>   barriers;
+	std::vector<PhysicalImage*> cleared;
+	for (RenderGraphInput const& input : pass.inputs) {
+		PhysicalImage& physical = GetPhysical(input.image, input.read, parity);
+		if (physical.state.layout != vk::ImageLayout::eUndefined || std::ranges::contains(cleared, &physical)) continue;
+		barriers.push_back({
+			.image         = physical.handle,
+			.oldLayout     = vk::ImageLayout::eUndefined,
+			.newLayout     = vk::ImageLayout::eTransferDstOptimal,
+			.srcStageMask  = physical.state.stage,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask  = vk::PipelineStageFlagBits2::eClear,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+		});
+		cleared.push_back(&physical);
+	}
+	if (cleared.empty()) return;
+	cmd.Barrier(barriers);
+	vk::ClearColorValue const       zero{.float32 = {{0.0f, 0.0f, 0.0f, 0.0f}}};
+	vk::ImageSubresourceRange const range{
+		.aspectMask     = vk::ImageAspectFlagBits::eColor,
+		.baseMipLevel   = 0,
+		.levelCount     = 1,
+		.baseArrayLayer = 0,
+		.layerCount     = 1,
+	};
+	for (PhysicalImage* physical : cleared) {
+		cmd.clearColorImage(physical->handle, vk::ImageLayout::eTransferDstOptimal, &zero, 1, &range);
+		physical->state = {
+			.layout = vk::ImageLayout::eTransferDstOptimal,
+			.stage  = vk::PipelineStageFlagBits2::eClear,
+			.access = vk::AccessFlagBits2::eTransferWrite,
+		};
+	}
+}
+
+void RenderGraph::Execute(CommandBuffer cmd) {
+	u32 const                  parity = GetParity();
+	std::vector<ImageBarrier>  barriers;
+	std::vector<vk::ImageView> output_views;
+	std::vector<vk::Image>     input_images;
+	std::vector<vk::Image>     output_images;
+	for (RenderGraphPassInfo const& pass : passes) {
+		ClearUnwrittenInputs(cmd, pass, parity);
+
+		AccessState const input_access  = GetInputAccess(pass.type);
+		AccessState const output_access = GetOutputAccess(pass.type);
+
+		barriers.clear();
+		input_images.clear();
+		for (RenderGraphInput const& input : pass.inputs) {
+			PhysicalImage& physical = GetPhysical(input.image, input.read, parity);
+			input_images.push_back(physical.handle);
+			// Read after read in the same layout needs no barrier, the next write waits for all readers
+			if (physical.state.layout == input_access.layout && !(physical.state.access & kWriteAccess)) {
+				physical.state.stage |= input_access.stage;
+				physical.state.access |= input_access.access;
+				continue;
+			}
+			barriers.push_back({
+				.image         = physical.handle,
+				.oldLayout     = physical.state.layout,
+				.newLayout     = input_access.layout,
+				.srcStageMask  = physical.state.stage,
+				.srcAccessMask = physical.state.access & kWriteAccess,
+				.dstStageMask  = input_access.stage,
+				.dstAccessMask = input_access.access,
+			});
+			physical.state = {
+				.layout = input_access.layout,
+				.stage  = input_access.stage,
+				.access = input_access.access,
+			};
+		}
+
+		output_views.clear();
+		output_images.clear();
+		vk::Extent2D extent{};
+		for (RenderGraphImage output : pass.outputs) {
+			PhysicalImage& physical = GetPhysical(output, RenderGraphRead::eCurrent, parity);
+			// Previous contents are overwritten, only the last access has to finish
+			barriers.push_back({
+				.image         = physical.handle,
+				.oldLayout     = vk::ImageLayout::eUndefined,
+				.newLayout     = output_access.layout,
+				.srcStageMask  = physical.state.stage,
+				.srcAccessMask = physical.state.access & kWriteAccess,
+				.dstStageMask  = output_access.stage,
+				.dstAccessMask = output_access.access,
+			});
+			physical.state = {
+				.layout = output_access.layout,
+				.stage  = output_access.stage,
+				.access = output_access.access,
+			};
+			output_views.push_back(physical.view);
+			output_images.push_back(physical.handle);
+			if (extent == vk::Extent2D{}) extent = images[output].info.extent;
+		}
+		cmd.Barrier(barriers);
+
+		pass.record({
+			.cmd           = cmd,
+			.parity        = parity,
+			.output_views  = output_views,
+			.input_images  = input_images,
+			.output_images = output_images,
+			.extent        = extent,
+		});
+	}
+	++frame;
+}
+
+void RenderGraph::Reset() {
+	for (PhysicalImage& physical : physical_images) {
+		physical.image.Destroy();
+	}
+	physical_images.clear();
+	images.clear();
+	passes.clear();
+	frame = 0;
+}
+
+void RenderGraph::Reset(DeletionQueue& deletion_queue) {
+	for (PhysicalImage& physical : physical_images) {
+		physical.image.DestroyDeferred(deletion_queue);
+	}
+	Reset();
+}
+
+} // namespace VulkanRHI
@@ -0,0 +1,153 @@
+export module VulkanRHI:RenderGraph;
+
+import vulkan_hpp;
+import std;
+import :PhysicalDevice;
+import :CommandBuffer;
+import :Image;
+import :DeletionQueue;
+
+export namespace VulkanRHI {
+
+using u32 = std::uint32_t;
+
+// Index of an image declared in a RenderGraph
+using RenderGraphImage = u32;
+
+struct RenderGraphImageInfo {
+	std::string  name;
+	vk::Extent2D extent = {};
+	vk::Format   format = vk::Format::eR16G16B16A16Sfloat;
+	// Set every frame with SetExternalImage, e.g. the swapchain image. Contents are discarded.
+	bool bExternal = false;
+};
+
+// Which frame's contents a pass reads
+enum class RenderGraphRead {
+	eCurrent,  // written by an earlier pass of this frame, or never written and zero
+	ePrevious, // written in the previous frame, zero in the first one. The image gets a second copy.
+};
+
+struct RenderGraphInput {
+	RenderGraphImage image;
+	RenderGraphRead  read = RenderGraphRead::eCurrent;
+};
+
+// Last use of an image before the graph, for external images
+struct RenderGraphImageState {
+	vk::ImageLayout         layout = vk::ImageLayout::eUndefined;
+	vk::PipelineStageFlags2 stage  = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+	vk::AccessFlags2        access = vk::AccessFlagBits2::eNone;
+};
+
+enum class RenderGraphPassType {
+	eGraphics, // inputs are sampled in the fragment shader, outputs are color attachments
+	eCompute,  // inputs are sampled in the compute shader, outputs are storage images in eGeneral
+	eTransfer, // inputs are copy or blit sources, outputs destinations
+};
+
+struct RenderGraphPassContext {
+	CommandBuffer                  cmd;
+	u32                            parity; // views of the inputs are GetView(input, parity)
+	std::span<vk::ImageView const> output_views;
+	std::span<vk::Image const>     input_images;  // in the order of the inputs
+	std::span<vk::Image const>     output_images; // in the order of the outputs
+	vk::Extent2D                   extent;        // of the first output
+};
+
+struct RenderGraphPassInfo {
+	std::string                   name;
+	std::vector<RenderGraphInput> inputs;
+	std::vector<RenderGraphImage> outputs; // fully overwritten
+	// Records the pass. Outputs are in eColorAttachmentOptimal, eGeneral or eTransferDstOptimal by type,
+	// inputs in eShaderReadOnlyOptimal or eTransferSrcOptimal.
+	std::function<void(RenderGraphPassContext const&)> record;
+	RenderGraphPassType                                type = RenderGraphPassType::eGraphics;
+};
+
+// Passes run in the order they are added, each image is written by at most one pass.
+// Compile creates the images: ones read from the previous frame get two copies that swap every
+// frame, ones written and read within a frame share an image with others of the same format and
+// size when their lifetimes do not overlap. Layout transitions and barriers follow from the
+// declared inputs and outputs, the graph tracks the last access of every image across frames,
+// so command buffers must be submitted in the order Execute recorded them.
+class RenderGraph {
+public:
+	RenderGraph() = default;
+
+	RenderGraph(RenderGraph const&)            = delete;
+	RenderGraph& operator=(RenderGraph const&) = delete;
+
+	~RenderGraph();
+
+	auto AddImage(RenderGraphImageInfo const& info) -> RenderGraphImage;
+	void AddPass(RenderGraphPassInfo info);
+
+	[[nodiscard]] auto Compile(vk::Device                     device,
+							   PhysicalDevice const&          physical_device,
+							   vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
+
+	// Image used for an external image until the next call
+	void SetExternalImage(RenderGraphImage image, vk::Image handle, vk::ImageView view, RenderGraphImageState const& state = {});
+
+	// Records all passes and advances to the next frame
+	void Execute(CommandBuffer cmd);
+
+	// Last access of an image in the copy used by the last Execute, e.g. to transition the swapchain image for present
+	auto GetImageState(RenderGraphImage image) const -> RenderGraphImageState;
+
+	// View an input is read from in frames of this parity
+	auto GetView(RenderGraphInput const& input, u32 parity) const -> vk::ImageView;
+	auto GetParity() const -> u32 { return static_cast<u32>(frame & 1); }
+
+	auto GetPassCount() const -> std::size_t { return passes.size(); }
+	auto GetImageCount() const -> std::size_t { return images.size(); }
+	// Created images, less than declared ones with aliasing, more with ping-pong copies
+	auto GetCreatedImageCount() const -> std::size_t;
+	bool IsEmpty() const { return passes.empty(); }
+
+	// Removes all passes and images. Created images are destroyed now or, with a queue, when it is flushed.
+	void Reset();
+	void Reset(DeletionQueue& deletion_queue);
+
+private:
+	struct ImageState {
+		vk::ImageLayout         layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags2 stage  = vk::PipelineStageFlagBits2::eNone;
+		vk::AccessFlags2        access = vk::AccessFlagBits2::eNone;
+	};
+
+	// Created or external image that declared images map to
+	struct PhysicalImage {
+		Image               image; // not created for external images
+		vk::Image           handle;
+		vk::ImageView       view;
+		ImageState          state;
+		vk::Extent2D        extent;
+		vk::Format          format    = vk::Format::eUndefined;
+		vk::ImageUsageFlags usage     = {};
+		bool                bExternal = false;
+		int                 last_use  = -1; // pass index, while aliasing in Compile
+	};
+
+	struct ImageEntry {
+		RenderGraphImageInfo info;
+		u32                  physical[2] = {}; // by parity, equal unless read from the previous frame
+		int                  writer      = -1;
+		int                  first_use   = -1;
+		int                  last_use    = -1;
+		bool                 bHistory    = false;
+		bool                 bStorage    = false; // written by a compute pass
+	};
+
+	auto AddPhysical(ImageEntry const& entry) -> u32;
+	auto GetPhysical(RenderGraphImage image, RenderGraphRead read, u32 parity) -> PhysicalImage&;
+	void ClearUnwrittenInputs(CommandBuffer cmd, RenderGraphPassInfo const& pass, u32 parity);
+
+	std::vector<ImageEntry>          images;
+	std::vector<RenderGraphPassInfo> passes;
+	std::vector<PhysicalImage>       physical_images;
+	std::uint64_t                    frame = 0;
+};
+
+} // namespace VulkanRHI
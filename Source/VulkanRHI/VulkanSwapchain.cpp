@@ -31,10 +31,13 @@ Swapchain& Swapchain::operator=(Swapchain&& other) noexcept {
 		images                    = std::move(other.images);
 		image_views               = std::exchange(other.image_views, {});
 		frames                    = std::exchange(other.frames, {});
+		retired_swapchains        = std::exchange(other.retired_swapchains, {});
 		available_present_modes   = std::move(other.available_present_modes);
 		available_surface_formats = std::move(other.available_surface_formats);
 		current_frame_index       = other.current_frame_index;
 		current_image_index       = other.current_image_index;
+		last_present_id           = other.last_present_id;
+		first_present_id          = other.first_present_id;
 	}
 	return *this;
 }
@@ -69,8 +72,9 @@ auto Swapchain::Recreate(u32 width, u32 height) -> vk::Result {
 		return vk::Result::eErrorUnknown;
 	}
 
+	// Frames in flight may still render to the old views
 	for (auto& image_view : image_views) {
-		GetDevice().destroyImageView(image_view, GetAllocator());
+		DestroyDeferred(image_view);
 	}
 	image_views.clear();
 
@@ -94,11 +98,23 @@ void Swapchain::Destroy() {
 	if (!GetDevice()) {
 		return;
 	}
+	// Waiting for the device does not cover presents
 	for (auto& frame : frames) {
+		if (frame.GetPresentFence()) {
+			(void)GetDevice().waitForFences(1, &frame.GetPresentFence(), vk::True, std::numeric_limits<u64>::max());
+		}
+	}
+	for (RetiredSwapchain const& retired : retired_swapchains) {
+		GetDevice().destroySwapchainKHR(retired.handle, GetAllocator());
+	}
+	retired_swapchains.clear();
+	for (auto& frame : frames) {
+		frame.GetDeletionQueue().Flush(GetDevice(), GetAllocator());
 		GetDevice().destroyCommandPool(frame.GetCommandPool(), GetAllocator());
 		GetDevice().destroyFence(frame.GetFence(), GetAllocator());
 		GetDevice().destroySemaphore(frame.GetImageAvailableSemaphore(), GetAllocator());
 		GetDevice().destroySemaphore(frame.GetRenderFinishedSemaphore(), GetAllocator());
+		GetDevice().destroyFence(frame.GetPresentFence(), GetAllocator());
 	}
 	frames.clear();
 
@@ -130,10 +146,13 @@ auto Swapchain::AcquireNextImage() -> vk::Result {
 
 // vkQueueSubmit2 + vkQueuePresentKHR
 auto Swapchain::SubmitAndPresent(vk::Queue submit, vk::Queue present) -> vk::Result {
+	return SubmitAndPresent(submit, present, GetCurrentCommandBuffer());
+}
 
+auto Swapchain::SubmitAndPresent(vk::Queue submit, vk::Queue present, vk::CommandBuffer cmd) -> vk::Result {
 	vk::SemaphoreSubmitInfo     wait{.semaphore = GetCurrentImageAvailableSemaphore()};
 	vk::SemaphoreSubmitInfo     signal{.semaphore = GetCurrentRenderFinishedSemaphore()};
-	vk::CommandBufferSubmitInfo bufferSubmitInfo{.commandBuffer = GetCurrentCommandBuffer()};
+	vk::CommandBufferSubmitInfo bufferSubmitInfo{.commandBuffer = cmd};
 
 	vk::SubmitInfo2 submit_info{
 		.waitSemaphoreInfoCount   = 1,
@@ -148,7 +167,22 @@ auto Swapchain::SubmitAndPresent(vk::Queue submit, vk::Queue present) -> vk::Res
 
 	vk::Semaphore present_wait = GetCurrentRenderFinishedSemaphore();
 
+	u64 const           present_id = last_present_id + 1;
+	SwapchainFrameData& frame      = GetCurrentFrameData();
+	if (info.bMaintenance1) {
+		// Present of this slot frames_in_flight frames ago, long done unless presentation is stalled
+		RETURN_ON_ERROR(GetDevice().waitForFences(1, &frame.GetPresentFence(), vk::True, std::numeric_limits<u64>::max()));
+		RETURN_ON_ERROR(GetDevice().resetFences(1, &frame.GetPresentFence()));
+		frame.GetPresentFenceId() = present_id;
+	}
+	vk::SwapchainPresentFenceInfoEXT present_fence_info{.swapchainCount = 1, .pFences = &frame.GetPresentFence()};
+	vk::PresentIdKHR                 present_id_info{
+		.pNext          = info.bMaintenance1 ? &present_fence_info : nullptr,
+		.swapchainCount = 1,
+		.pPresentIds    = &present_id,
+	};
 	vk::PresentInfoKHR present_info{
+		.pNext              = info.bPresentWait ? &present_id_info : present_id_info.pNext,
 		.waitSemaphoreCount = 1,
 		.pWaitSemaphores    = &present_wait,
 		.swapchainCount     = 1,
@@ -157,10 +191,17 @@ auto Swapchain::SubmitAndPresent(vk::Queue submit, vk::Queue present) -> vk::Res
 		.pResults           = nullptr,
 	};
 
-	RETURN_ON_ERROR(present.presentKHR(&present_info));
-
+	// Frame is submitted even if presenting fails, the next one must use the next frame data
 	current_frame_index = (current_frame_index + 1) % info.frames_in_flight;
-	return vk::Result::eSuccess;
+	last_present_id     = present_id;
+	return present.presentKHR(&present_info);
+}
+
+auto Swapchain::WaitForPresent(u64 present_id, u64 timeout) -> vk::Result {
+	if (!info.bPresentWait || present_id < first_present_id || present_id == 0) {
+		return vk::Result::eSuccess;
+	}
+	return GetDevice().waitForPresentKHR(*this, present_id, timeout);
 }
 
 bool Swapchain::SupportsFormat(vk::Format format, vk::ImageTiling tiling, vk::FormatFeatureFlags features) {
@@ -251,8 +292,11 @@ auto Swapchain::CreateSwapchain() -> vk::Result {
 		image_count = capabilities.maxImageCount;
 	}
 
+	vk::SwapchainPresentScalingCreateInfoEXT const scaling = info.bMaintenance1 ? ChoosePresentScaling() : vk::SwapchainPresentScalingCreateInfoEXT{};
+
 	// Create swapchain
 	vk::SwapchainCreateInfoKHR createInfo{
+		.pNext            = scaling.scalingBehavior ? &scaling : nullptr,
 		.surface          = info.surface,
 		.minImageCount    = image_count,
 		.imageFormat      = info.preferred_format,
@@ -272,11 +316,62 @@ auto Swapchain::CreateSwapchain() -> vk::Result {
 	};
 
 	RETURN_ON_ERROR(GetDevice().createSwapchainKHR(&createInfo, GetAllocator(), this));
-
-	GetDevice().destroySwapchainKHR(createInfo.oldSwapchain, GetAllocator());
+	first_present_id = last_present_id + 1;
+
+	// Old swapchain is retired, its images may still be presented
+	if (frames.empty()) {
+		GetDevice().destroySwapchainKHR(createInfo.oldSwapchain, GetAllocator());
+	} else if (info.bMaintenance1) {
+		retired_swapchains.push_back({.handle = createInfo.oldSwapchain, .last_present_id = last_present_id});
+	} else {
+		DestroyDeferred(createInfo.oldSwapchain);
+	}
 	return vk::Result::eSuccess;
 }
 
+// Images are stretched over the window while it is resized, presents stay valid until the
+// swapchain is recreated instead of failing out of date
+auto Swapchain::ChoosePresentScaling() -> vk::SwapchainPresentScalingCreateInfoEXT {
+	vk::SurfacePresentModeEXT                present_mode{.presentMode = info.present_mode};
+	vk::PhysicalDeviceSurfaceInfo2KHR        surface_info{.pNext = &present_mode, .surface = info.surface};
+	vk::SurfacePresentScalingCapabilitiesEXT scaling_capabilities{};
+	vk::SurfaceCapabilities2KHR              capabilities{.pNext = &scaling_capabilities};
+	if (GetPhysicalDevice().getSurfaceCapabilities2KHR(&surface_info, &capabilities) != vk::Result::eSuccess) {
+		return {};
+	}
+
+	vk::SwapchainPresentScalingCreateInfoEXT scaling{};
+	for (vk::PresentScalingFlagBitsEXT behavior : {vk::PresentScalingFlagBitsEXT::eStretch,
+												   vk::PresentScalingFlagBitsEXT::eAspectRatioStretch,
+												   vk::PresentScalingFlagBitsEXT::eOneToOne}) {
+		if (scaling_capabilities.supportedPresentScaling & behavior) {
+			scaling.scalingBehavior = behavior;
+			break;
+		}
+	}
+	if (scaling.scalingBehavior &&
+		(scaling_capabilities.supportedPresentGravityX & vk::PresentGravityFlagBitsEXT::eMin) &&
+		(scaling_capabilities.supportedPresentGravityY & vk::PresentGravityFlagBitsEXT::eMin)) {
+		scaling.presentGravityX = vk::PresentGravityFlagBitsEXT::eMin;
+		scaling.presentGravityY = vk::PresentGravityFlagBitsEXT::eMin;
+	}
+	return scaling;
+}
+
+void Swapchain::DestroyRetired() {
+	// Each slot's fence covers the last present of the slot, earlier ones were waited for before reusing it
+	std::erase_if(retired_swapchains, [this](RetiredSwapchain const& retired) {
+		for (SwapchainFrameData const& frame : frames) {
+			if (frame.GetPresentFenceId() <= retired.last_present_id &&
+				GetDevice().getFenceStatus(frame.GetPresentFence()) != vk::Result::eSuccess) {
+				return false;
+			}
+		}
+		GetDevice().destroySwapchainKHR(retired.handle, GetAllocator());
+		return true;
+	});
+}
+
 auto Swapchain::CreateImages() -> vk::Result {
 	u32        imageCount;
 	vk::Result result;
@@ -323,6 +418,9 @@ auto Swapchain::CreateFrames() -> vk::Result {
 		vk::SemaphoreCreateInfo semaphoreInfo{};
 		RETURN_ON_ERROR(GetDevice().createSemaphore(&semaphoreInfo, GetAllocator(), &frames[i].GetImageAvailableSemaphore()));
 		RETURN_ON_ERROR(GetDevice().createSemaphore(&semaphoreInfo, GetAllocator(), &frames[i].GetRenderFinishedSemaphore()));
+		if (info.bMaintenance1) {
+			RETURN_ON_ERROR(GetDevice().createFence(&fence_info, GetAllocator(), &frames[i].GetPresentFence()));
+		}
 	}
 
 	return vk::Result::eSuccess;
@@ -2,10 +2,12 @@ export module VulkanRHI:Swapchain;
 
 import vulkan_hpp;
 import std;
+import :DeletionQueue;
 
 export namespace VulkanRHI {
 
 using u32 = std::uint32_t;
+using u64 = std::uint64_t;
 
 struct SwapchainInfo {
 	// Necessary data
@@ -19,6 +21,13 @@ struct SwapchainInfo {
 	vk::Format         preferred_format = vk::Format::eR8G8B8A8Unorm;
 	vk::ColorSpaceKHR  color_space      = vk::ColorSpaceKHR::eSrgbNonlinear;
 	vk::PresentModeKHR present_mode     = vk::PresentModeKHR::eMailbox;
+	// Tag presents with ids so WaitForPresent can be used,
+	// requires VK_KHR_present_id and VK_KHR_present_wait
+	bool bPresentWait = false;
+	// Presents signal fences, so a retired swapchain is destroyed once its presents are done, and images
+	// are scaled to the window until the swapchain is recreated after a resize.
+	// Requires VK_EXT_swapchain_maintenance1 and VK_EXT_surface_maintenance1.
+	bool bMaintenance1 = false;
 };
 
 struct SwapchainFrameData {
@@ -33,6 +42,12 @@ public:
 	auto GetImageAvailableSemaphore() const -> vk::Semaphore const& { return image_available_semaphore; }
 	auto GetRenderFinishedSemaphore() -> vk::Semaphore& { return render_finished_semaphore; }
 	auto GetRenderFinishedSemaphore() const -> vk::Semaphore const& { return render_finished_semaphore; }
+	auto GetDeletionQueue() -> DeletionQueue& { return deletion_queue; }
+	auto GetDeletionQueue() const -> DeletionQueue const& { return deletion_queue; }
+	auto GetPresentFence() -> vk::Fence& { return present_fence; }
+	auto GetPresentFence() const -> vk::Fence const& { return present_fence; }
+	auto GetPresentFenceId() -> u64& { return present_fence_id; }
+	auto GetPresentFenceId() const -> u64 const& { return present_fence_id; }
 
 private:
 	vk::CommandPool   command_pool{};
@@ -40,6 +55,11 @@ private:
 	vk::Fence         fence{};
 	vk::Semaphore     image_available_semaphore{};
 	vk::Semaphore     render_finished_semaphore{};
+	// Signaled when the present with present_fence_id is done, with SwapchainInfo::bMaintenance1
+	vk::Fence present_fence{};
+	u64       present_fence_id = 0;
+	// Destroyed after fence signals, see Swapchain::DestroyDeferred
+	DeletionQueue deletion_queue;
 };
 
 class Swapchain : public vk::SwapchainKHR {
@@ -58,12 +78,37 @@ public:
 							  SwapchainInfo const&           info,
 							  vk::AllocationCallbacks const* allocator = nullptr) -> vk::Result;
 
+	// The old swapchain is retired, not waited for. Frames in flight keep rendering to and presenting its images.
 	[[nodiscard]] auto Recreate(u32 width, u32 height) -> vk::Result;
 
 	void Destroy();
 
 	[[nodiscard]] auto AcquireNextImage() -> vk::Result;
 	[[nodiscard]] auto SubmitAndPresent(vk::Queue submit, vk::Queue present) -> vk::Result;
+	// Submits cmd instead of the current frame's command buffer
+	[[nodiscard]] auto SubmitAndPresent(vk::Queue submit, vk::Queue present, vk::CommandBuffer cmd) -> vk::Result;
+
+	// Destroys the handle once every frame submitted so far has completed, without waiting.
+	// It is queued on the last submitted frame, whose fence signals after all earlier frames.
+	template <typename T>
+	void DestroyDeferred(T handle) {
+		GetDeferredDeletionQueue().Push(handle);
+	}
+	// Queue of the last submitted frame, flushed once it has completed
+	auto GetDeferredDeletionQueue() -> DeletionQueue& {
+		return frames[(current_frame_index + info.frames_in_flight - 1) % info.frames_in_flight].GetDeletionQueue();
+	}
+
+	// Waits until the present with this id or a later one is shown. Returns immediately for ids
+	// of a previous swapchain. Presents are numbered from 1, see GetLastPresentId.
+	[[nodiscard]] auto WaitForPresent(u64 present_id, u64 timeout) -> vk::Result;
+	auto               GetLastPresentId() const -> u64 { return last_present_id; }
+
+	// Call after waiting for the current frame's fence
+	void FlushCurrentDeletionQueue() {
+		GetCurrentFrameData().GetDeletionQueue().Flush(GetDevice(), GetAllocator());
+		DestroyRetired();
+	}
 
 	auto GetFrameData() -> std::span<SwapchainFrameData> { return frames; }
 	auto GetFrameData() const -> std::span<SwapchainFrameData const> { return frames; }
@@ -95,6 +140,7 @@ public:
 	auto GetCurrentFrameIndex() const -> u32 const& { return current_frame_index; }
 	auto GetCurrentImageIndex() -> u32& { return current_image_index; }
 	auto GetCurrentImageIndex() const -> u32 const& { return current_image_index; }
+	auto GetImageCount() const -> u32 { return static_cast<u32>(images.size()); }
 
 	auto GetSurface() -> vk::SurfaceKHR& { return info.surface; }
 	auto GetSurface() const -> vk::SurfaceKHR const& { return info.surface; }
@@ -123,6 +169,10 @@ private:
 	[[nodiscard]] auto CreateSwapchain() -> vk::Result;
 	[[nodiscard]] auto CreateImages() -> vk::Result;
 	[[nodiscard]] auto CreateFrames() -> vk::Result;
+	auto               ChoosePresentScaling() -> vk::SwapchainPresentScalingCreateInfoEXT;
+
+	// Destroys retired swapchains whose presents are all done
+	void DestroyRetired();
 
 	vk::Device         device;
 	vk::PhysicalDevice physical_device;
@@ -134,11 +184,20 @@ private:
 	std::vector<vk::PresentModeKHR>   available_present_modes;
 	std::vector<vk::SurfaceFormatKHR> available_surface_formats;
 
+	// Swapchain replaced by Recreate, with SwapchainInfo::bMaintenance1
+	struct RetiredSwapchain {
+		vk::SwapchainKHR handle;
+		u64              last_present_id; // its last present
+	};
+
 	std::vector<SwapchainFrameData> frames;
 	std::vector<vk::Image>          images;
 	std::vector<vk::ImageView>      image_views;
+	std::vector<RetiredSwapchain>   retired_swapchains;
 	u32                             current_frame_index = 0;
 	u32                             current_image_index = 0;
 	SwapchainInfo                   info;
+	u64                             last_present_id  = 0;
+	u64                             first_present_id = 1; // of the current vk::SwapchainKHR
 };
 } // namespace VulkanRHI
@@ -10,6 +10,7 @@ void WindowManager::Terminate() { glfwTerminate(); }
 void WindowManager::PollEvents() { glfwPollEvents(); }
 void WindowManager::WaitEvents() { glfwWaitEvents(); }
 void WindowManager::WaitEventsTimeout(double timeout) { glfwWaitEventsTimeout(timeout); }
+void WindowManager::PostEmptyEvent() { glfwPostEmptyEvent(); }
 
 vk::Result WindowManager::CreateWindowSurface(vk::Instance                   instance,
 											  GLFWwindow*                    window,
@@ -24,4 +24,6 @@ public:
 	static void PollEvents();
 	static void WaitEvents();
 	static void WaitEventsTimeout(double timeout);
+	// Wakes WaitEvents, safe to call from any thread
+	static void PostEmptyEvent();
 };